@@ -72,6 +72,7 @@ class PlatformAdaptor_Abstract;
 
 namespace Positioning
 {
+class FlightRecorder;
 class PositionProvider;
 } // namespace Positioning
 
@@ -156,6 +157,12 @@ public:
      */
     Q_INVOKABLE static DemoRunner* demoRunner();
 
+    /*! \brief Pointer to appplication-wide static FlightRecorder instance
+     *
+     * @returns Pointer to appplication-wide static instance.
+     */
+    Q_INVOKABLE static Positioning::FlightRecorder* flightRecorder();
+
     /*! \brief Pointer to appplication-wide static FlarmnetDB instance
      *
      * @returns Pointer to appplication-wide static instance.
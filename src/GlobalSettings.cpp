@@ -93,6 +93,13 @@ auto GlobalSettings::mapBearingPolicy() const -> GlobalSettings::MapBearingPolic
 }
 
 
+auto GlobalSettings::maxConcurrentDownloads() const -> int
+{
+    auto maxConcurrentDownloads = settings.value(QStringLiteral("DataManager/maxConcurrentDownloads"), 2).toInt();
+    return qBound(1, maxConcurrentDownloads, maxConcurrentDownloads_max);
+}
+
+
 //
 // Setter Methods
 //
@@ -253,6 +260,18 @@ void GlobalSettings::setMapBearingPolicy(MapBearingPolicy policy)
 }
 
 
+void GlobalSettings::setMaxConcurrentDownloads(int newMaxConcurrentDownloads)
+{
+    newMaxConcurrentDownloads = qBound(1, newMaxConcurrentDownloads, maxConcurrentDownloads_max);
+    if (newMaxConcurrentDownloads == maxConcurrentDownloads())
+    {
+        return;
+    }
+    settings.setValue(QStringLiteral("DataManager/maxConcurrentDownloads"), newMaxConcurrentDownloads);
+    emit maxConcurrentDownloadsChanged();
+}
+
+
 void GlobalSettings::setNightMode(bool newNightMode)
 {
     if (newNightMode == nightMode())
@@ -277,6 +296,18 @@ void GlobalSettings::setPositioningByTrafficDataReceiver(bool newPositioningByTr
 }
 
 
+void GlobalSettings::setRecordFlights(bool newRecordFlights)
+{
+    if (newRecordFlights == recordFlights())
+    {
+        return;
+    }
+
+    settings.setValue(QStringLiteral("recordFlights"), newRecordFlights);
+    emit recordFlightsChanged();
+}
+
+
 void GlobalSettings::setShowAltitudeAGL(bool newShowAltitudeAGL)
 {
     if (newShowAltitudeAGL == showAltitudeAGL())
@@ -161,6 +161,16 @@ public:
     /*! \brief Map bearing policy */
     Q_PROPERTY(MapBearingPolicy mapBearingPolicy READ mapBearingPolicy WRITE setMapBearingPolicy NOTIFY mapBearingPolicyChanged)
 
+    /*! \brief Maximal number of map files that are downloaded at the same time
+     *
+     *  This is a value between 1 and maxConcurrentDownloads_max. The default
+     *  is 2.
+     */
+    Q_PROPERTY(int maxConcurrentDownloads READ maxConcurrentDownloads WRITE setMaxConcurrentDownloads NOTIFY maxConcurrentDownloadsChanged)
+
+    /*! \brief Maximal value for property maxConcurrentDownloads */
+    Q_PROPERTY(int maxConcurrentDownloads_max MEMBER maxConcurrentDownloads_max CONSTANT)
+
     /*! \brief Night mode */
     Q_PROPERTY(bool nightMode READ nightMode WRITE setNightMode NOTIFY nightModeChanged)
 
@@ -171,6 +181,14 @@ public:
      */
     Q_PROPERTY(Units::ByteSize privacyHash READ privacyHash WRITE setPrivacyHash NOTIFY privacyHashChanged)
 
+    /*! \brief Record flights
+     *
+     * If true, the FlightRecorder records all position fixes on the device.
+     * The recordings never leave the device unless the user exports them.
+     * This property is false by default.
+     */
+    Q_PROPERTY(bool recordFlights READ recordFlights WRITE setRecordFlights NOTIFY recordFlightsChanged)
+
     /*! \brief Show Altitude AGL */
     Q_PROPERTY(bool showAltitudeAGL READ showAltitudeAGL WRITE setShowAltitudeAGL NOTIFY showAltitudeAGLChanged)
 
@@ -273,6 +291,12 @@ public:
      */
     [[nodiscard]] auto mapBearingPolicy() const -> MapBearingPolicy;
 
+    /*! \brief Getter function for property of the same name
+     *
+     * @returns Property maxConcurrentDownloads
+     */
+    [[nodiscard]] auto maxConcurrentDownloads() const -> int;
+
     /*! \brief Getter function for property of the same name
      *
      * @returns Property night mode
@@ -291,6 +315,12 @@ public:
      */
     [[nodiscard]] auto privacyHash() const -> Units::ByteSize  { return settings.value(QStringLiteral("privacyHash"), 0).value<size_t>(); }
 
+    /*! \brief Getter function for property of the same name
+     *
+     * @returns Property recordFlights
+     */
+    [[nodiscard]] auto recordFlights() const -> bool { return settings.value(QStringLiteral("recordFlights"), false).toBool(); }
+
     /*! \brief Getter function for property of the same name
      *
      * @returns Property positioningByTrafficDataReceiver
@@ -393,6 +423,12 @@ public:
      */
     void setMapBearingPolicy(MapBearingPolicy policy);
 
+    /*! \brief Setter function for property of the same name
+     *
+     * @param newMaxConcurrentDownloads Property maxConcurrentDownloads
+     */
+    void setMaxConcurrentDownloads(int newMaxConcurrentDownloads);
+
     /*! \brief Setter function for property of the same name
      *
      * @param newNightMode Property nightMode
@@ -411,6 +447,12 @@ public:
      */
     void setPrivacyHash(Units::ByteSize newHash);
 
+    /*! \brief Setter function for property of the same name
+     *
+     * @param newRecordFlights Property recordFlights
+     */
+    void setRecordFlights(bool newRecordFlights);
+
     /*! \brief Setter function for property of the same name
      *
      * @param newShowAltitudeAGL Property showAltitudeAGL
@@ -430,6 +472,7 @@ public:
 
     static constexpr Units::Distance airspaceAltitudeLimit_min = Units::Distance::fromFT(3000);
     static constexpr Units::Distance airspaceAltitudeLimit_max = Units::Distance::fromFT(15000);
+    static constexpr int maxConcurrentDownloads_max = 6;
 
 signals:
     /*! \brief Notifier signal */
@@ -468,6 +511,9 @@ signals:
     /*! \brief Notifier signal */
     void mapBearingPolicyChanged();
 
+    /*! \brief Notifier signal */
+    void maxConcurrentDownloadsChanged();
+
     /*! \brief Notifier signal */
     void nightModeChanged();
 
@@ -477,6 +523,9 @@ signals:
     /*! \brief Notifier signal */
     void privacyHashChanged();
 
+    /*! \brief Notifier signal */
+    void recordFlightsChanged();
+
     /*! \brief Notifier signal */
     void showAltitudeAGLChanged();
 
@@ -28,11 +28,14 @@
 #include <QSettings>
 #include <QStack>
 #include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include "GlobalSettings.h"
 #include "dataManagement/DataManager.h"
 #include "fileFormats/MBTILES.h"
+#include "fileFormats/ZipFile.h"
 #include "geomaps/OpenAir.h"
+#include "positioning/Geoid.h"
 
 using namespace std::chrono_literals;
 
@@ -42,6 +45,9 @@ DataManagement::DataManager::DataManager(QObject* parent) : GlobalObject(parent)
     // Delete funny files that might have made their way into our data directory
     cleanDataDirectory();
 
+    // Wire up the integrity index
+    connect(&m_integrityIndex, &DataManagement::IntegrityIndex::damaged, this, &DataManager::onFileDamaged);
+
     // Wire up the Dowloadable object "_maps_json"
     connect(&m_mapList, &DataManagement::Downloadable_SingleFile::fileContentChanged, this, &DataManager::updateDataItemListAndWhatsNew);
     connect(&m_mapList, &DataManagement::Downloadable_SingleFile::fileContentChanged, this, []()
@@ -57,11 +63,25 @@ DataManagement::DataManager::DataManager(QObject* parent) : GlobalObject(parent)
 }
 
 
+DataManagement::DataManager::~DataManager()
+{
+    cancelImport();
+    m_import.waitForFinished();
+}
+
+
 void DataManagement::DataManager::deferredInitialization()
 {    
+    // Wire up the limit for simultaneous downloads
+    connect(globalSettings(), &GlobalSettings::maxConcurrentDownloadsChanged, this, &DataManager::onMaxConcurrentDownloadsChanged);
+    onMaxConcurrentDownloadsChanged();
+
     // If there is a downloaded maps.json file, we read it.
     updateDataItemListAndWhatsNew();
 
+    // Check files that have changed since the last run, in the background
+    m_integrityIndex.verify();
+
     // If the last update is more than one day ago, automatically initiate an
     // update, so that maps stay at least roughly current.
     auto lastUpdate = QSettings().value(QStringLiteral("DataManager/MapListTimeStamp"), QDateTime()).toDateTime();
@@ -74,6 +94,38 @@ void DataManagement::DataManager::deferredInitialization()
 
 void DataManagement::DataManager::cleanDataDirectory()
 {
+    // Partial downloads that have not been touched for a long time can no
+    // longer be resumed sensibly
+    auto isStalePartialFile = [](const QFileInfo& info)
+    {
+        return info.lastModified().daysTo(QDateTime::currentDateTime()) > maxPartialFileAgeInDays;
+    };
+
+    // If the directory has not changed, only partial downloads can have
+    // become stale. These are found in the index, without scanning.
+    if (m_integrityIndex.isCurrent())
+    {
+        QStringList staleFiles;
+        foreach (const auto& partialFile, m_integrityIndex.partialFiles())
+        {
+            if (isStalePartialFile(QFileInfo(partialFile)))
+            {
+                staleFiles += partialFile;
+                staleFiles += partialFile+u"info"_qs;
+            }
+        }
+        if (staleFiles.isEmpty())
+        {
+            return;
+        }
+        foreach (const auto& staleFile, staleFiles)
+        {
+            QFile::remove(staleFile);
+        }
+        m_integrityIndex.rescan();
+        return;
+    }
+
     QStringList misnamedFiles;
     QStringList unexpectedFiles;
     QDirIterator fileIterator(m_dataDirectory, QDir::Files, QDirIterator::Subdirectories);
@@ -89,7 +141,26 @@ void DataManagement::DataManager::cleanDataDirectory()
                 !fileIterator.filePath().endsWith(u".geojson"_qs) &&
                 !fileIterator.filePath().endsWith(u".mbtiles"_qs) &&
                 !fileIterator.filePath().endsWith(u".raster"_qs) &&
-                !fileIterator.filePath().endsWith(u".txt"_qs))
+                !fileIterator.filePath().endsWith(u".txt"_qs) &&
+                !fileIterator.filePath().endsWith(u".part"_qs) &&
+                !fileIterator.filePath().endsWith(u".partinfo"_qs) &&
+                !fileIterator.filePath().endsWith(u".manifest"_qs))
+        {
+            unexpectedFiles += fileIterator.filePath();
+        }
+
+        // Delete incomplete downloads that can no longer be resumed: partial
+        // files without validator or validators without partial file, and
+        // partial files that have not been touched for a long time
+        if (fileIterator.filePath().endsWith(u".part"_qs))
+        {
+            if (!QFile::exists(fileIterator.filePath()+u"info"_qs) || isStalePartialFile(fileIterator.fileInfo()))
+            {
+                unexpectedFiles += fileIterator.filePath();
+                unexpectedFiles += fileIterator.filePath()+u"info"_qs;
+            }
+        }
+        if (fileIterator.filePath().endsWith(u".partinfo"_qs) && !QFile::exists(fileIterator.filePath().chopped(4)))
         {
             unexpectedFiles += fileIterator.filePath();
         }
@@ -142,44 +213,167 @@ void DataManagement::DataManager::cleanDataDirectory()
             }
         }
     }
+
+    // Record the state of the clean directory
+    m_integrityIndex.rescan();
 }
 
 
-QString DataManagement::DataManager::import(const QString& fileName, const QString& newName)
+void DataManagement::DataManager::cancelImport()
 {
-    auto localFile = FileFormats::DataFileAbstract::openFileURL(fileName);
-
-    auto path = m_dataDirectory+"/Unsupported";
-    auto newFileName = path + "/" + newName;
-
-    FileFormats::MBTILES mbtiles(localFile->fileName());
-    switch(mbtiles.format())
+    if (m_importCanceled)
     {
-    case FileFormats::MBTILES::Raster:
-        newFileName += u".raster"_qs;
-        break;
-    case FileFormats::MBTILES::Vector:
-        newFileName += u".mbtiles"_qs;
-        break;
-    case FileFormats::MBTILES::Unknown:
-        return tr("Unable to recognize map file format.");
+        *m_importCanceled = true;
     }
+}
 
-    if (!QDir().mkpath(path))
+
+void DataManagement::DataManager::import(const QString& fileName, const QString& newName)
+{
+    if (m_import.isRunning())
     {
-        return tr("Unable to create directory '%1'.").arg(path);
+        return;
     }
-    QFile::remove(newFileName);
-    if (!localFile->copy(newFileName))
+
+    auto canceled = std::make_shared<std::atomic<bool>>(false);
+    m_importCanceled = canceled;
+    emit importStatus(0.0);
+
+    auto path = m_dataDirectory+"/Unsupported";
+    m_import = QtConcurrent::run([this, fileName, path, newName, canceled]() -> std::pair<QString, QString>
     {
+        auto newFileName = path + "/" + newName;
+        if (!QDir().mkpath(path))
+        {
+            return {{}, tr("Unable to create directory '%1'.").arg(path)};
+        }
+
+        // Copy the file into the data directory in one streaming pass, then
+        // inspect the copy. This avoids an intermediate temporary copy of
+        // content URLs. The staging file has an unexpected suffix, so that
+        // cleanDataDirectory() removes it if the app is interrupted.
+        auto stagingFileName = newFileName + u".import"_qs;
+        if (!FileFormats::DataFileAbstract::copyFileURL(fileName, stagingFileName, importProgress(canceled)))
+        {
+            if (*canceled)
+            {
+                return {{}, tr("Import canceled.")};
+            }
+            return {{}, tr("Unable to copy map file to data directory.")};
+        }
+
+        FileFormats::MBTILES::Format format = FileFormats::MBTILES::Unknown;
+        {
+            FileFormats::MBTILES mbtiles(stagingFileName);
+            format = mbtiles.format();
+        }
+        switch(format)
+        {
+        case FileFormats::MBTILES::Raster:
+            newFileName += u".raster"_qs;
+            break;
+        case FileFormats::MBTILES::Vector:
+            newFileName += u".mbtiles"_qs;
+            break;
+        case FileFormats::MBTILES::Unknown:
+            QFile::remove(stagingFileName);
+            return {{}, tr("Unable to recognize map file format.")};
+        }
+
         QFile::remove(newFileName);
-        updateDataItemListAndWhatsNew();
-        return tr("Unable to copy map file to data directory.");
+        if (!QFile::rename(stagingFileName, newFileName))
+        {
+            QFile::remove(stagingFileName);
+            QFile::remove(newFileName);
+            return {newFileName, tr("Unable to copy map file to data directory.")};
+        }
+        return {newFileName, {}};
+    });
+
+    // The integrity index and the list of data items live in the GUI thread
+    m_import.then(this, [this](const std::pair<QString, QString>& result)
+    {
+        if (!result.first.isEmpty())
+        {
+            m_integrityIndex.commit(result.first);
+            updateDataItemListAndWhatsNew();
+        }
+        emit importStatus(1.0);
+        emit importFinished(result.second);
+    });
+}
+
+
+void DataManagement::DataManager::importGeoid(const QString& fileName)
+{
+    if (m_import.isRunning())
+    {
+        return;
     }
 
-    updateDataItemListAndWhatsNew();
+    auto canceled = std::make_shared<std::atomic<bool>>(false);
+    m_importCanceled = canceled;
+    emit importStatus(0.0);
 
-    return {};
+    m_import = QtConcurrent::run([this, fileName, canceled]() -> std::pair<QString, QString>
+    {
+        auto newFileName = Positioning::Geoid::modelFileName();
+        auto path = QFileInfo(newFileName).absolutePath();
+        if (!QDir().mkpath(path))
+        {
+            return {{}, tr("Unable to create directory '%1'.").arg(path)};
+        }
+
+        // The zip archives published by GeographicLib contain the model in
+        // the directory "geoids", next to auxiliary files
+        auto stagingFileName = newFileName + u".import"_qs;
+        bool success = false;
+        FileFormats::ZipFile zipFile(fileName);
+        if (zipFile.isValid())
+        {
+            auto fileNames = zipFile.fileNames();
+            for(qsizetype i=0; i<fileNames.size(); i++)
+            {
+                if (fileNames[i].endsWith(u".pgm"_qs, Qt::CaseInsensitive))
+                {
+                    success = zipFile.extractToFile(i, stagingFileName, importProgress(canceled));
+                    break;
+                }
+            }
+        }
+        else
+        {
+            success = FileFormats::DataFileAbstract::copyFileURL(fileName, stagingFileName, importProgress(canceled));
+        }
+        if (!success)
+        {
+            if (*canceled)
+            {
+                return {{}, tr("Import canceled.")};
+            }
+            return {{}, tr("Unable to copy geoid model to data directory.")};
+        }
+
+        if (!Positioning::Geoid::isValidModel(stagingFileName))
+        {
+            QFile::remove(stagingFileName);
+            return {{}, tr("Unable to recognize geoid model format.")};
+        }
+        QFile::remove(newFileName);
+        if (!QFile::rename(stagingFileName, newFileName))
+        {
+            QFile::remove(stagingFileName);
+            return {{}, tr("Unable to copy geoid model to data directory.")};
+        }
+        return {{}, {}};
+    });
+
+    m_import.then(this, [this](const std::pair<QString, QString>& result)
+    {
+        Positioning::Geoid::reloadModel();
+        emit importStatus(1.0);
+        emit importFinished(result.second);
+    });
 }
 
 
@@ -219,14 +413,56 @@ QString DataManagement::DataManager::importOpenAir(const QString& fileName, cons
     if (file.error() != QFileDevice::NoError)
     {
         QFile::remove(newFileName);
+        m_integrityIndex.commit(newFileName);
         updateDataItemListAndWhatsNew();
         return tr("Error writing file '%1': %2.").arg(newFileName, file.errorString());
     }
+    m_integrityIndex.commit(newFileName);
     updateDataItemListAndWhatsNew();
     return {};
 }
 
 
+FileFormats::DataFileAbstract::ProgressCallback DataManagement::DataManager::importProgress(const std::shared_ptr<std::atomic<bool>>& canceled)
+{
+    return [this, canceled, percent = 0](qint64 bytesCopied, qint64 bytesTotal) mutable
+    {
+        if (bytesTotal > 0)
+        {
+            auto newPercent = static_cast<int>(100*bytesCopied/bytesTotal);
+            if (newPercent != percent)
+            {
+                percent = newPercent;
+                QMetaObject::invokeMethod(this, [this, newPercent]() { emit importStatus(0.01*newPercent); }, Qt::QueuedConnection);
+            }
+        }
+        return !*canceled;
+    };
+}
+
+
+void DataManagement::DataManager::onFileDamaged(const QString& fileName)
+{
+    foreach (auto itemX, m_items.downloadables())
+    {
+        auto* item = qobject_cast<DataManagement::Downloadable_SingleFile*>(itemX);
+        if ((item == nullptr) || (item->fileName() != fileName))
+        {
+            continue;
+        }
+        // The file is not deleted, because the check is only a heuristic.
+        // The user decides whether to download it again.
+        if (item->url().isValid())
+        {
+            emit error(tr("The file %1 appears to be damaged. Please download it again.").arg(item->objectName()));
+            return;
+        }
+        emit error(tr("The file %1 appears to be damaged.").arg(item->objectName()));
+        return;
+    }
+}
+
+
 void DataManagement::DataManager::onItemFileChanged()
 {
     auto items = m_items.downloadables();
@@ -255,23 +491,52 @@ void DataManagement::DataManager::onItemFileChanged()
 }
 
 
-DataManagement::Downloadable_SingleFile* DataManagement::DataManager::createOrRecycleItem(const QUrl& url, const QString& localFileName, const QGeoRectangle& bBox)
+void DataManagement::DataManager::onMaxConcurrentDownloadsChanged()
 {
-    // If a data item with the given local file name and the given URL already exists,
-    // update that remoteFileDate and remoteFileSize of that element, annd delete its
-    // entry in oldMaps
-    foreach (auto mapPtrX, m_items.downloadables())
+    auto maxConcurrentDownloads = globalSettings()->maxConcurrentDownloads();
+
+    m_aviationMaps.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_baseMaps.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_baseMapsRaster.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_baseMapsVector.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_databases.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_items.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_mapsAndData.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_mapSets.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    m_terrainMaps.setMaxConcurrentDownloads(maxConcurrentDownloads);
+    foreach (auto downloadable, m_mapSets.downloadables())
     {
-        auto* mapPtr = qobject_cast<DataManagement::Downloadable_SingleFile*>(mapPtrX);
-        if (mapPtr == nullptr)
+        auto* mapSet = qobject_cast<DataManagement::Downloadable_MultiFile*>(downloadable);
+        if (mapSet != nullptr)
         {
-            continue;
-        }
-        if ((mapPtr->fileName() == localFileName) && (mapPtr->url() == url))
-        {
-            return mapPtr;
+            mapSet->setMaxConcurrentDownloads(maxConcurrentDownloads);
         }
     }
+}
+
+
+QString DataManagement::DataManager::itemKey(const QUrl& url, const QString& localFileName)
+{
+    return localFileName + u'\n' + url.toString();
+}
+
+
+QString DataManagement::DataManager::mapSetKey(const QString& section, const QString& objectName)
+{
+    return section + u'\n' + objectName;
+}
+
+
+DataManagement::Downloadable_SingleFile* DataManagement::DataManager::createOrRecycleItem(const QUrl& url, const QString& localFileName, const QGeoRectangle& bBox, ItemIndex& index)
+{
+    // If a data item with the given local file name and the given URL already exists,
+    // return that element
+    auto key = itemKey(url, localFileName);
+    auto* existingItem = index.items.value(key);
+    if (existingItem != nullptr)
+    {
+        return existingItem;
+    }
 
     // Construct a new downloadable object and add to appropriate groups
     auto* downloadable = new DataManagement::Downloadable_SingleFile(url, localFileName, bBox, this);
@@ -291,30 +556,28 @@ DataManagement::Downloadable_SingleFile* DataManagement::DataManager::createOrRe
             downloadable->setSection("<a name>"+tr("Manually Imported"));
         }
 
-        bool hasMapSet = false;
-        foreach(auto mapSetX, m_mapSets.downloadables())
+        auto mapSetIndexKey = mapSetKey(downloadable->section(), downloadable->objectName());
+        auto* mapSet = index.mapSets.value(mapSetIndexKey);
+        if (mapSet != nullptr)
         {
-            auto* mapSet = qobject_cast<DataManagement::Downloadable_MultiFile*>(mapSetX);
-            if (mapSet == nullptr)
-            {
-                continue;
-            }
-            if ((mapSet->objectName() == downloadable->objectName()) && (mapSet->section() == downloadable->section()))
-            {
-                mapSet->add(downloadable);
-                hasMapSet = true;
-                break;
-            }
+            mapSet->add(downloadable);
         }
-        if (!hasMapSet)
+        else
         {
             auto* newMapSet = new DataManagement::Downloadable_MultiFile(Downloadable_MultiFile::MultiUpdate, this);
+            newMapSet->setMaxConcurrentDownloads(globalSettings()->maxConcurrentDownloads());
             newMapSet->add(downloadable);
             m_mapSets.add(newMapSet);
+            index.mapSets.insert(mapSetIndexKey, newMapSet);
         }
     }
 
     m_items.add(downloadable);
+    index.items.insert(key, downloadable);
+    connect(downloadable, &DataManagement::Downloadable_SingleFile::fileContentChanged, this, [this, downloadable]()
+    {
+        m_integrityIndex.commit(downloadable->fileName());
+    });
     if (localFileName.endsWith(u"terrain"_qs))
     {
         m_terrainMaps.add(downloadable);
@@ -348,18 +611,6 @@ void DataManagement::DataManager::updateDataItemListAndWhatsNew()
         return;
     }
 
-    // Get List of file in the directory
-    QList<QString> files;
-    QDirIterator fileIterator(m_dataDirectory, QDir::Files, QDirIterator::Subdirectories);
-    while (fileIterator.hasNext())
-    {
-        fileIterator.next();
-        files.append(fileIterator.filePath());
-    }
-
-    // List of maps as we have them now
-    auto oldMaps = m_items.downloadables();
-
     // To begin, we handle the maps described in the maps.json file. If these
     // maps were already present in the old list, we re-use them. Otherwise, we
     // create new Downloadable objects.
@@ -370,6 +621,40 @@ void DataManagement::DataManager::updateDataItemListAndWhatsNew()
         return;
     }
 
+    // Get List of file in the directory. The list is taken from the integrity
+    // index, which scans the directory only if it has changed.
+    auto files = m_integrityIndex.files();
+    QSet<QString> filesInMapList;
+
+    // List of maps as we have them now, and indices for fast lookup
+    QSet<DataManagement::Downloadable_Abstract*> oldMaps;
+    ItemIndex index;
+    foreach (auto mapPtrX, m_items.downloadables())
+    {
+        oldMaps.insert(mapPtrX);
+        auto* mapPtr = qobject_cast<DataManagement::Downloadable_SingleFile*>(mapPtrX);
+        if (mapPtr != nullptr)
+        {
+            index.items.insert(itemKey(mapPtr->url(), mapPtr->fileName()), mapPtr);
+        }
+    }
+    foreach (auto mapSetX, m_mapSets.downloadables())
+    {
+        auto* mapSet = qobject_cast<DataManagement::Downloadable_MultiFile*>(mapSetX);
+        if (mapSet != nullptr)
+        {
+            index.mapSets.insert(mapSetKey(mapSet->section(), mapSet->objectName()), mapSet);
+        }
+    }
+
+    // Changes to the groups are committed at the end of this method, so that
+    // aggregate properties are evaluated and signals are emitted only once
+    const QList<DataManagement::Downloadable_MultiFile*> groups {&m_aviationMaps, &m_baseMaps, &m_baseMapsRaster, &m_baseMapsVector, &m_databases, &m_items, &m_mapSets, &m_terrainMaps};
+    foreach (auto group, groups)
+    {
+        group->beginBatch();
+    }
+
     auto top = doc.object();
 
     // Prepare strings to check if the present version
@@ -449,20 +734,25 @@ void DataManagement::DataManager::updateDataItemListAndWhatsNew()
                 bbox.setBottomRight( {bottom, right} );
             }
 
-            auto* downloadable = createOrRecycleItem(mapUrl, localFileName, bbox);
-            oldMaps.removeAll(downloadable);
+            auto* downloadable = createOrRecycleItem(mapUrl, localFileName, bbox, index);
+            oldMaps.remove(downloadable);
             downloadable->setRemoteFileDate(fileModificationDateTime);
             downloadable->setRemoteFileSize(fileSize);
+            downloadable->setDeltaUpdatesAvailable(obj.value(u"deltaUpdates"_qs).toBool());
 
-            files.removeAll(localFileName);
+            filesInMapList.insert(localFileName);
         }
     }
 
     // Next, we create or recycle items for all files that that we have found in the directory.
     foreach (auto localFileName, files)
     {
-        auto *downloadable = createOrRecycleItem(QUrl(), localFileName, {});
-        oldMaps.removeAll(downloadable);
+        if (filesInMapList.contains(localFileName))
+        {
+            continue;
+        }
+        auto *downloadable = createOrRecycleItem(QUrl(), localFileName, {}, index);
+        oldMaps.remove(downloadable);
         downloadable->setObjectName(localFileName.section(QStringLiteral("/"), -1, -1));
     }
     qDeleteAll(oldMaps);
@@ -487,6 +777,11 @@ void DataManagement::DataManager::updateDataItemListAndWhatsNew()
         m_mapSets.remove(mapSet);
     }
 
+    foreach (auto group, groups)
+    {
+        group->commitBatch();
+    }
+
     // Update the whatsNew property
     auto newWhatsNew = top.value(QStringLiteral("whatsNew")).toString();
     if (!newWhatsNew.isEmpty() && (newWhatsNew != m_whatsNew))
@@ -20,12 +20,18 @@
 
 #pragma once
 
+#include <QFuture>
+#include <QHash>
 #include <QQmlEngine>
 #include <QStandardPaths>
+#include <atomic>
+#include <memory>
 
 #include "GlobalObject.h"
 #include "dataManagement/Downloadable_MultiFile.h"
 #include "dataManagement/Downloadable_SingleFile.h"
+#include "dataManagement/IntegrityIndex.h"
+#include "fileFormats/DataFileAbstract.h"
 #include "units/ByteSize.h"
 
 
@@ -84,7 +90,11 @@ public:
      */
     explicit DataManager(QObject* parent=nullptr);
 
-    ~DataManager() override = default;
+    /*! \brief Standard destructor
+     *
+     *  The destructor cancels a running import and waits for it to finish.
+     */
+    ~DataManager() override;
 
     // No default constructor, important for QML singleton
     explicit DataManager() = delete;
@@ -262,6 +272,14 @@ public:
     // Methods
     //
 
+    /*! \brief Cancel map import
+     *
+     *  If an import started by import() or importGeoid() is running, this
+     *  method cancels it.
+     *  The signal importFinished() is emitted once the import has stopped.
+     */
+    Q_INVOKABLE void cancelImport();
+
     /*! \brief Import raster or vector map into the library of locally installed
      * maps
      *
@@ -270,16 +288,18 @@ public:
      * the map will delete all locally install vector maps when importing a
      * raster map, and all raster maps when importing a vector map.
      *
+     * Maps can be several hundred megabytes large. The file is therefore
+     * copied in a background thread. Progress is reported via the signal
+     * importStatus(), and the signal importFinished() is emitted at the end.
+     * If an import is already running, this method does nothing.
+     *
      * @param fileName File name of locally raster or vector map, in MBTILES
      * format.
      *
      * @param newName Name under which the map is available in the library. If
      * the name exists, the library entry will be replaced.
-     *
-     * @returns A human-readable HTML string on error, or an empty string on
-     * success
      */
-    Q_INVOKABLE QString import(const QString& fileName, const QString& newName);
+    Q_INVOKABLE void import(const QString& fileName, const QString& newName);
 
     /*! \brief Import airspace data into the library of locally installed
      * maps
@@ -298,6 +318,25 @@ public:
      */
     Q_INVOKABLE QString importOpenAir(const QString& fileName, const QString& newName);
 
+    /*! \brief Install a high-resolution geoid model
+     *
+     * This method installs a geoid model for Positioning::Geoid, replacing
+     * any model that was installed before. The file is either a GeographicLib
+     * geoid file in PGM format, such as egm2008-1.pgm, or one of the zip
+     * archives published at
+     * https://sourceforge.net/projects/geographiclib/files/geoids-distrib/
+     * that contain such a file.
+     *
+     * Geoid models can be several hundred megabytes large. Like import(), the
+     * method therefore works in a background thread, reports progress via
+     * the signal importStatus() and emits importFinished() at the end. The
+     * import can be canceled with cancelImport(). If an import is already
+     * running, this method does nothing.
+     *
+     * @param fileName File name of the geoid model or of the zip archive
+     */
+    Q_INVOKABLE void importGeoid(const QString& fileName);
+
 public slots:
     /*! \brief Triggers an update of the list of remotely available data items
      *
@@ -321,6 +360,24 @@ signals:
      */
     void error(const QString& message);
 
+    /*! \brief Map import progress
+     *
+     *  This signal is emitted while import() or importGeoid() copy a file.
+     *
+     *  @param percent A number between 0.0 and 1.0
+     */
+    void importStatus(double percent);
+
+    /*! \brief Map import finished
+     *
+     *  This signal is emitted once the import started by import() or
+     *  importGeoid() has ended, successfully or not.
+     *
+     *  @param errorString A human-readable HTML string on error, or an empty
+     *  string on success
+     */
+    void importFinished(const QString& errorString);
+
     /*! \brief Notifier signal */
     void whatsNewChanged();
 
@@ -329,36 +386,76 @@ private:
 
     // Clean the data directory.
     //
-    // - delete all files with unexpected file names
+    // - delete all files with unexpected file names. Partial downloads
+    //   (".part" and ".partinfo") are kept, so that they can be resumed,
+    //   unless one of the two files is missing or the partial file is older
+    //   than maxPartialFileAgeInDays. Tile manifests (".manifest") are kept
+    //   for delta updates of MBTILES files.
     // - earlier versions of this program constructed files with names ending in
     //   ".geojson.geojson" or ".mbtiles.mbtiles". We correct those file names
     //   here.
     // - remove all empty sub directories
+    //
+    // If the integrity index shows that the directory has not changed since
+    // the last call, the method only deletes stale partial downloads, which
+    // it finds in the index.
     void cleanDataDirectory();
 
+    // Progress callback for file copies in the background. The callback emits
+    // importStatus() on the GUI thread and returns false once canceled is set.
+    [[nodiscard]] FileFormats::DataFileAbstract::ProgressCallback importProgress(const std::shared_ptr<std::atomic<bool>>& canceled);
+
+    // This slot is called when the integrity index finds a damaged file. An
+    // error message is emitted. The file is not deleted.
+    void onFileDamaged(const QString& fileName);
+
     // This slot is called when a local file of one of the Downloadables changes
     // content or existence. If the Downloadable in question has no file
     // anymore, and has an invalid URL, it is then removed.
     void onItemFileChanged();
 
+    // This slot is called when the user changes the maximal number of
+    // simultaneous downloads. It applies the value to all
+    // Downloadable_MultiFiles, including the map sets.
+    void onMaxConcurrentDownloadsChanged();
+
     // This slot updates the DownloadableGroups as well as the propery
     // 'whatsNew', by reading the file 'maps.json' and by checking the data
     // directory for locally installed, unsupported files.
     void updateDataItemListAndWhatsNew();
 
+    // Indices used by updateDataItemListAndWhatsNew() to find existing items
+    // and map sets in constant time
+    struct ItemIndex
+    {
+        // Items, keyed by itemKey()
+        QHash<QString, DataManagement::Downloadable_SingleFile*> items;
+
+        // Map sets, keyed by mapSetKey()
+        QHash<QString, DataManagement::Downloadable_MultiFile*> mapSets;
+    };
+
+    // Keys used in ItemIndex
+    static QString itemKey(const QUrl& url, const QString& localFileName);
+    static QString mapSetKey(const QString& section, const QString& objectName);
+
     // This method checks if a Downloadable item with the given url and
     // localFileName already exists in _items. If so, it returns a pointer to
     // that item. If not, then a Downloadable with the url and localFileName is
     // created and added to _items. Depending on localFileName, it will also be
     // added to _aviationMap, _baseMaps, or _databases. A pointer to that item is
-    // then returned.
-    DataManagement::Downloadable_SingleFile* createOrRecycleItem(const QUrl& url, const QString& localFileName, const QGeoRectangle& bBox);
+    // then returned. Items are looked up in the index, which is updated when
+    // items or map sets are created.
+    DataManagement::Downloadable_SingleFile* createOrRecycleItem(const QUrl& url, const QString& localFileName, const QGeoRectangle& bBox, ItemIndex& index);
 
     bool m_appUpdateRequired {false};
 
     // Full path name of data directory, without trailing slash
     QString m_dataDirectory {QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/aviation_maps"};
 
+    // Index of files in the data directory, with hashes and integrity checks
+    DataManagement::IntegrityIndex m_integrityIndex {m_dataDirectory, QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/aviation_maps.index"};
+
     // The current whats new string from _aviationMaps.
     QString m_whatsNew {};
 
@@ -379,6 +476,15 @@ private:
 
     // List of geographic map sets
     DataManagement::Downloadable_MultiFile m_mapSets  {DataManagement::Downloadable_MultiFile::SingleUpdate};
+
+    // Partial downloads that have not been touched for longer are deleted
+    static constexpr qint64 maxPartialFileAgeInDays = 30;
+
+    // Map or geoid import running in the background. The result is the name
+    // of the imported map file, which is empty for geoid models, and an error
+    // message, which is empty on success.
+    QFuture<std::pair<QString, QString>> m_import;
+    std::shared_ptr<std::atomic<bool>> m_importCanceled;
 };
 
 } // namespace DataManagement
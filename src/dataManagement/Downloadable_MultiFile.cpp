@@ -18,9 +18,18 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <QLocale>
 #include <QPointer>
 
+#include <algorithm>
+
 #include "Downloadable_MultiFile.h"
+#include "Downloadable_SingleFile.h"
+#include "GlobalObject.h"
+#include "geomaps/CoordinateBatch.h"
+#include "navigation/FlightRoute.h"
+#include "navigation/Navigator.h"
+#include "positioning/PositionProvider.h"
 
 
 DataManagement::Downloadable_MultiFile::Downloadable_MultiFile(DataManagement::Downloadable_MultiFile::UpdatePolicy updatePolicy, QObject* parent)
@@ -29,6 +38,9 @@ DataManagement::Downloadable_MultiFile::Downloadable_MultiFile(DataManagement::D
     setContentType(MapSet);
 
     connect(this, &DataManagement::Downloadable_MultiFile::downloadingChanged, this, &DataManagement::Downloadable_MultiFile::evaluateUpdateSize, Qt::QueuedConnection);
+
+    m_throughputTimer.setInterval(1000);
+    connect(&m_throughputTimer, &QTimer::timeout, this, &DataManagement::Downloadable_MultiFile::updateThroughput);
 }
 
 
@@ -114,6 +126,30 @@ auto DataManagement::Downloadable_MultiFile::infoText() -> QString
 }
 
 
+auto DataManagement::Downloadable_MultiFile::throughputString() const -> QString
+{
+    return tr("%1/s").arg(QLocale::system().formattedDataSize(m_throughput, 1, QLocale::DataSizeSIFormat));
+}
+
+
+
+//
+// Setter Methods
+//
+
+void DataManagement::Downloadable_MultiFile::setMaxConcurrentDownloads(int maxConcurrentDownloads)
+{
+    maxConcurrentDownloads = qMax(1, maxConcurrentDownloads);
+    if (maxConcurrentDownloads == m_maxConcurrentDownloads)
+    {
+        return;
+    }
+    m_maxConcurrentDownloads = maxConcurrentDownloads;
+    emit maxConcurrentDownloadsChanged();
+    scheduleDownloads();
+}
+
+
 
 //
 // Methods
@@ -123,37 +159,28 @@ void DataManagement::Downloadable_MultiFile::add(DataManagement::Downloadable_Ab
 {
     if (rawAdd(map))
     {
-        evaluateDownloading();
-        evaluateFiles();
-        evaluateHasFile();
-        evaluateRemoteFileSize();
-        evaluateUpdateSize();
-
-        emit downloadablesChanged();
-        emit fileContentChanged();
+        onDownloadablesChanged();
     }
 }
 
 
 void DataManagement::Downloadable_MultiFile::add(const QVector<DataManagement::Downloadable_Abstract*>& maps)
 {
-    auto cache = m_downloadables.size();
+    beginBatch();
     foreach(auto map, maps)
     {
-        rawAdd(map);
+        if (rawAdd(map))
+        {
+            m_batchChanged = true;
+        }
     }
+    commitBatch();
+}
 
-    if (cache != m_downloadables.size())
-    {
-        evaluateDownloading();
-        evaluateFiles();
-        evaluateHasFile();
-        evaluateRemoteFileSize();
-        evaluateUpdateSize();
 
-        emit downloadablesChanged();
-        emit fileContentChanged();
-    }
+void DataManagement::Downloadable_MultiFile::beginBatch()
+{
+    m_batchDepth++;
 }
 
 
@@ -168,15 +195,23 @@ void DataManagement::Downloadable_MultiFile::clear()
         disconnect(map, nullptr, this, nullptr);
     }
     m_downloadables.clear();
+    m_downloadableSet.clear();
 
-    emit descriptionChanged();
-    emit downloadablesChanged();
-    emit infoTextChanged();
-    evaluateDownloading();
-    evaluateFiles();
-    evaluateHasFile();
-    evaluateRemoteFileSize();
-    evaluateUpdateSize();
+    onDownloadablesChanged();
+}
+
+
+void DataManagement::Downloadable_MultiFile::commitBatch()
+{
+    if (m_batchDepth <= 0)
+    {
+        return;
+    }
+    m_batchDepth--;
+    if ((m_batchDepth == 0) && m_batchChanged)
+    {
+        onDownloadablesChanged();
+    }
 }
 
 
@@ -265,9 +300,9 @@ auto DataManagement::Downloadable_MultiFile::downloadablesByDistance(const QGeoC
     }
 
     // Sort Downloadables according to section name and object name
-    std::sort(result.begin(), result.end(), [location](Downloadable_Abstract* first, Downloadable_Abstract* second)
-              { return first->boundingBox().center().distanceTo(location) < second->boundingBox().center().distanceTo(location); }
-              );
+    GeoMaps::CoordinateBatch::sortByDistance(result, location, [](Downloadable_Abstract* downloadable)
+                                             { return downloadable->boundingBox().center(); }
+                                             );
 
     return result;
 }
@@ -275,21 +310,22 @@ auto DataManagement::Downloadable_MultiFile::downloadablesByDistance(const QGeoC
 
 void DataManagement::Downloadable_MultiFile::startDownload()
 {
-    m_downloadables.removeAll(nullptr);
-    foreach(auto map, m_downloadables)
-    {
-        map->startDownload();
-    }
+    enqueue(false);
+    scheduleDownloads();
 }
 
 
 void DataManagement::Downloadable_MultiFile::stopDownload()
 {
+    m_downloadQueue.clear();
+    m_activeDownloads.clear();
+
     m_downloadables.removeAll(nullptr);
     foreach(auto map, m_downloadables)
     {
         map->stopDownload();
     }
+    scheduleDownloads();
 }
 
 
@@ -300,42 +336,23 @@ void DataManagement::Downloadable_MultiFile::update()
         return;
     }
 
-    m_downloadables.removeAll(nullptr);
-    foreach(auto map, m_downloadables)
-    {
-        if (map->hasFile())
-        {
-            map->update();
-        }
-        else
-        {
-            if (m_updatePolicy == MultiUpdate)
-            {
-                map->startDownload();
-            }
-        }
-    }
+    enqueue(true);
+    scheduleDownloads();
 }
 
 
 void DataManagement::Downloadable_MultiFile::remove(DataManagement::Downloadable_Abstract* map)
 {
-    if (!m_downloadables.contains(map))
+    if (!m_downloadableSet.contains(map))
     {
         return;
     }
 
     disconnect(map, nullptr, this, nullptr);
-    m_downloadables.removeAll(map);
+    m_downloadableSet.remove(map);
+    m_downloadables.removeOne(map);
 
-    emit descriptionChanged();
-    emit downloadablesChanged();
-    emit infoTextChanged();
-    evaluateDownloading();
-    evaluateFiles();
-    evaluateHasFile();
-    evaluateRemoteFileSize();
-    evaluateUpdateSize();
+    onDownloadablesChanged();
 }
 
 
@@ -344,9 +361,32 @@ void DataManagement::Downloadable_MultiFile::remove(DataManagement::Downloadable
 // Private
 //
 
+void DataManagement::Downloadable_MultiFile::onDownloadablesChanged()
+{
+    if (m_batchDepth > 0)
+    {
+        m_batchChanged = true;
+        return;
+    }
+    m_batchChanged = false;
+
+    evaluateDownloading();
+    evaluateFiles();
+    evaluateHasFile();
+    evaluateRemoteFileSize();
+    evaluateUpdateSize();
+
+    emit descriptionChanged();
+    emit downloadablesChanged();
+    emit infoTextChanged();
+    emit fileContentChanged();
+}
+
+
 void DataManagement::Downloadable_MultiFile::evaluateDownloading()
 {
-    bool newDownloading = false;
+    // Files waiting in the queue count as downloading
+    bool newDownloading = !m_downloadQueue.isEmpty();
     m_downloadables.removeAll(nullptr);
     foreach(auto map, m_downloadables)
     {
@@ -460,7 +500,7 @@ bool DataManagement::Downloadable_MultiFile::rawAdd(DataManagement::Downloadable
     {
         return false;
     }
-    if (m_downloadables.contains(map))
+    if (m_downloadableSet.contains(map))
     {
         return false;
     }
@@ -482,14 +522,11 @@ bool DataManagement::Downloadable_MultiFile::rawAdd(DataManagement::Downloadable
     connect(map, &DataManagement::Downloadable_Abstract::updateSizeChanged, this, &DataManagement::Downloadable_MultiFile::evaluateUpdateSize, Qt::QueuedConnection);
 
     // Wire up: when the new member gets destroyed, we need to change all properties.
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::descriptionChanged);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::downloadablesChanged);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::infoTextChanged);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::evaluateDownloading);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::evaluateFiles);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::evaluateHasFile);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::evaluateRemoteFileSize);
-    connect(map, &QObject::destroyed, this, &DataManagement::Downloadable_MultiFile::evaluateUpdateSize);
+    connect(map, &QObject::destroyed, this, [this, map]()
+    {
+        m_downloadableSet.remove(map);
+        onDownloadablesChanged();
+    });
 
     // Wire up: directly forward error messages and file content changed signals
     connect(map, &DataManagement::Downloadable_Abstract::error, this, &DataManagement::Downloadable_MultiFile::error);
@@ -502,6 +539,238 @@ bool DataManagement::Downloadable_MultiFile::rawAdd(DataManagement::Downloadable
 
     // Add downloadable
     m_downloadables.append(map);
+    m_downloadableSet.insert(map);
 
     return true;
 }
+
+
+void DataManagement::Downloadable_MultiFile::enqueue(bool isUpdate)
+{
+    // Files that are already queued or running are not added again
+    QSet<DataManagement::Downloadable_Abstract*> seen;
+    foreach(auto item, m_downloadQueue)
+    {
+        seen += item.downloadable;
+    }
+    foreach(auto activeDownload, m_activeDownloads)
+    {
+        seen += activeDownload.downloadable;
+    }
+
+    enqueue(this, isUpdate, false, priorityCoordinates(), seen);
+}
+
+
+void DataManagement::Downloadable_MultiFile::enqueue(DataManagement::Downloadable_MultiFile* group, bool isUpdate, bool isPriority, const QList<QGeoCoordinate>& priorityCoordinates, QSet<DataManagement::Downloadable_Abstract*>& seen)
+{
+    group->m_downloadables.removeAll(nullptr);
+    foreach(auto map, group->m_downloadables)
+    {
+        if (seen.contains(map))
+        {
+            continue;
+        }
+        seen += map;
+
+        auto mapIsPriority = isPriority;
+        auto bbox = map->boundingBox();
+        if (!mapIsPriority && bbox.isValid())
+        {
+            foreach(auto coordinate, priorityCoordinates)
+            {
+                if (bbox.contains(coordinate))
+                {
+                    mapIsPriority = true;
+                    break;
+                }
+            }
+        }
+
+        // Resolve nested groups, following their update policy
+        auto* multiFile = qobject_cast<DataManagement::Downloadable_MultiFile*>(map);
+        if (multiFile != nullptr)
+        {
+            if (!isUpdate || (multiFile->updateSize() != 0))
+            {
+                enqueue(multiFile, isUpdate, mapIsPriority, priorityCoordinates, seen);
+            }
+            continue;
+        }
+
+        auto* singleFile = qobject_cast<DataManagement::Downloadable_SingleFile*>(map);
+        if (singleFile == nullptr)
+        {
+            continue;
+        }
+        if (!isUpdate)
+        {
+            m_downloadQueue.append({singleFile, false, mapIsPriority});
+        }
+        else if (singleFile->hasFile())
+        {
+            m_downloadQueue.append({singleFile, true, mapIsPriority});
+        }
+        else if (group->m_updatePolicy == MultiUpdate)
+        {
+            m_downloadQueue.append({singleFile, false, mapIsPriority});
+        }
+    }
+}
+
+
+auto DataManagement::Downloadable_MultiFile::priorityCoordinates() -> QList<QGeoCoordinate>
+{
+    if (!GlobalObject::canConstruct())
+    {
+        return {};
+    }
+
+    QList<QGeoCoordinate> result;
+    auto lastValidCoordinate = Positioning::PositionProvider::lastValidCoordinate();
+    if (lastValidCoordinate.isValid())
+    {
+        result += lastValidCoordinate;
+    }
+    auto* route = GlobalObject::navigator()->flightRoute();
+    if (route != nullptr)
+    {
+        foreach(auto waypoint, route->waypoints())
+        {
+            if (waypoint.coordinate().isValid())
+            {
+                result += waypoint.coordinate();
+            }
+        }
+    }
+    return result;
+}
+
+
+void DataManagement::Downloadable_MultiFile::countReceivedBytes(ActiveDownload& activeDownload)
+{
+    if (activeDownload.downloadable.isNull())
+    {
+        return;
+    }
+    auto bytesReceived = activeDownload.downloadable->bytesReceived();
+    m_bytesTransferred += qMax(qint64(0), bytesReceived-activeDownload.bytesReceived);
+    activeDownload.bytesReceived = bytesReceived;
+}
+
+
+void DataManagement::Downloadable_MultiFile::scheduleDownloads()
+{
+    // Forget about downloads that have finished. Bytes received since the last
+    // estimate still count towards the throughput.
+    for (auto i = m_activeDownloads.size()-1; i >= 0; i--)
+    {
+        auto& activeDownload = m_activeDownloads[i];
+        if (activeDownload.downloadable.isNull())
+        {
+            m_activeDownloads.removeAt(i);
+            continue;
+        }
+        if (!activeDownload.downloadable->downloading())
+        {
+            countReceivedBytes(activeDownload);
+            m_activeDownloads.removeAt(i);
+        }
+    }
+
+    // Files covering position and route first, then smaller files first.
+    // Files of unknown size come last.
+    std::stable_sort(m_downloadQueue.begin(), m_downloadQueue.end(), [](const QueueItem& first, const QueueItem& second)
+    {
+        if (first.isPriority != second.isPriority)
+        {
+            return first.isPriority;
+        }
+        auto firstSize = first.downloadable.isNull() ? -1 : first.downloadable->remoteFileSize();
+        auto secondSize = second.downloadable.isNull() ? -1 : second.downloadable->remoteFileSize();
+        if ((firstSize < 0) != (secondSize < 0))
+        {
+            return secondSize < 0;
+        }
+        return firstSize < secondSize;
+    });
+
+    while (!m_downloadQueue.isEmpty() && (m_activeDownloads.size() < m_maxConcurrentDownloads))
+    {
+        auto item = m_downloadQueue.takeFirst();
+        if (item.downloadable.isNull())
+        {
+            continue;
+        }
+        auto isActive = std::any_of(m_activeDownloads.cbegin(), m_activeDownloads.cend(), [&item](const ActiveDownload& activeDownload)
+                                    { return activeDownload.downloadable == item.downloadable; });
+        if (isActive)
+        {
+            continue;
+        }
+
+        // Downloads that were started elsewhere are not interrupted
+        auto bytesReceived = item.downloadable->bytesReceived();
+        if (!item.downloadable->downloading())
+        {
+            if (item.isUpdate)
+            {
+                item.downloadable->update();
+            }
+            else
+            {
+                item.downloadable->startDownload();
+            }
+        }
+        if (!item.downloadable->downloading())
+        {
+            continue;
+        }
+        connect(item.downloadable, &DataManagement::Downloadable_Abstract::downloadingChanged, this, &DataManagement::Downloadable_MultiFile::scheduleDownloads, Qt::ConnectionType(Qt::QueuedConnection|Qt::UniqueConnection));
+        m_activeDownloads.append({item.downloadable, bytesReceived});
+    }
+
+    // Start or stop throughput estimation
+    if (m_activeDownloads.isEmpty())
+    {
+        m_throughputTimer.stop();
+        m_bytesTransferred = 0;
+        if (m_throughput != 0)
+        {
+            m_throughput = 0;
+            emit throughputChanged();
+        }
+    }
+    else if (!m_throughputTimer.isActive())
+    {
+        m_throughputClock.start();
+        m_throughputTimer.start();
+    }
+
+    evaluateDownloading();
+}
+
+
+void DataManagement::Downloadable_MultiFile::updateThroughput()
+{
+    for (auto& activeDownload : m_activeDownloads)
+    {
+        countReceivedBytes(activeDownload);
+    }
+
+    auto elapsed = m_throughputClock.restart();
+    if (elapsed <= 0)
+    {
+        return;
+    }
+    auto rate = m_bytesTransferred*1000/elapsed;
+    m_bytesTransferred = 0;
+
+    // Smooth the estimate, so that it does not jump around
+    auto newThroughput = (m_throughput == 0) ? rate : qRound64(0.7*static_cast<double>(m_throughput) + 0.3*static_cast<double>(rate));
+    if (newThroughput != m_throughput)
+    {
+        m_throughput = newThroughput;
+        emit throughputChanged();
+    }
+}
@@ -20,9 +20,13 @@
 
 #pragma once
 
+#include <QElapsedTimer>
+#include <QGeoCoordinate>
 #include <QQmlEngine>
+#include <QSet>
 
 #include "dataManagement/Downloadable_Abstract.h"
+#include "dataManagement/Downloadable_SingleFile.h"
 
 namespace DataManagement {
 
@@ -30,6 +34,14 @@ namespace DataManagement {
 /*! \brief Group of closely related downloadable items
  *
  *  This class implements a group of Downloadable_Abstract objects.
+ *
+ *  Downloads and updates started with startDownload() and update() are not
+ *  started all at once. Instead, the individual files are put into a queue,
+ *  resolving nested groups to any depth, and at most maxConcurrentDownloads
+ *  files are transferred at the same time.
+ *  Files that cover the current position or the current flight route come
+ *  first, and smaller files come before larger ones, so that the most
+ *  relevant maps become usable as early as possible.
  */
 
 class Downloadable_MultiFile : public Downloadable_Abstract {
@@ -72,6 +84,25 @@ public:
     // Repeated from Downloadable_Abstract, to avoid QML warning
     Q_PROPERTY(bool hasFile READ hasFile NOTIFY hasFileChanged)
 
+    /*! \brief Maximal number of files that are downloaded at the same time
+     *
+     *  This property holds the maximal number of files that startDownload()
+     *  and update() transfer simultaneously. The value is at least one and
+     *  defaults to two.
+     */
+    Q_PROPERTY(int maxConcurrentDownloads READ maxConcurrentDownloads WRITE setMaxConcurrentDownloads NOTIFY maxConcurrentDownloadsChanged)
+
+    /*! \brief Aggregate download throughput
+     *
+     *  This property holds an estimate for the combined throughput of all
+     *  downloads started by this instance, in bytes per second. If no
+     *  download is running, the property holds zero.
+     */
+    Q_PROPERTY(qint64 throughput READ throughput NOTIFY throughputChanged)
+
+    /*! \brief Aggregate download throughput as a human-readable string */
+    Q_PROPERTY(QString throughputString READ throughputString NOTIFY throughputChanged)
+
 
     //
     // Getter Methods
@@ -113,12 +144,30 @@ public:
      */
     [[nodiscard]] auto infoText() -> QString override;
 
+    /*! \brief Getter function for the property with the same name
+     *
+     * @returns Property maxConcurrentDownloads
+     */
+    [[nodiscard]] auto maxConcurrentDownloads() const -> int { return m_maxConcurrentDownloads; }
+
     /*! \brief Getter function for the property with the same name
      *
      * @returns Property remoteFileSize
      */
     [[nodiscard]] auto remoteFileSize() -> qint64 override { return m_remoteFileSize; }
 
+    /*! \brief Getter function for the property with the same name
+     *
+     * @returns Property throughput
+     */
+    [[nodiscard]] auto throughput() const -> qint64 { return m_throughput; }
+
+    /*! \brief Getter function for the property with the same name
+     *
+     * @returns Property throughputString
+     */
+    [[nodiscard]] auto throughputString() const -> QString;
+
     /*! \brief Implementation of pure virtual getter method from Downloadable_Abstract
      *
      * @returns Property updateSize
@@ -127,6 +176,18 @@ public:
 
 
 
+    //
+    // Setter Methods
+    //
+
+    /*! \brief Setter function for the property with the same name
+     *
+     * @param maxConcurrentDownloads Property maxConcurrentDownloads
+     */
+    void setMaxConcurrentDownloads(int maxConcurrentDownloads);
+
+
+
     //
     // Methods
     //
@@ -152,6 +213,26 @@ public:
      */
     Q_INVOKABLE void add(const QVector<DataManagement::Downloadable_Abstract*>& maps);
 
+    /*! \brief Start a batch of changes
+     *
+     *  Every call to add(), remove() or clear() re-evaluates the aggregate
+     *  properties of this instance and emits notifier signals. When many
+     *  children are added or removed at once, this is wasteful. Between calls
+     *  to beginBatch() and commitBatch(), children are added and removed
+     *  without evaluating properties or emitting signals. This also applies
+     *  to children that are destroyed. Batches can be nested; the changes
+     *  take effect when the outermost batch is committed.
+     */
+    void beginBatch();
+
+    /*! \brief Commit a batch of changes
+     *
+     *  If this call ends the outermost batch and if the set of children has
+     *  changed since beginBatch(), then the aggregate properties are
+     *  re-evaluated, and notifier signals are emitted once.
+     */
+    void commitBatch();
+
     /*! \brief Removes all children */
     Q_INVOKABLE void clear();
 
@@ -180,20 +261,42 @@ public:
      */
     Q_INVOKABLE void remove(DataManagement::Downloadable_Abstract* map);
 
-    /*! \brief Implementation of pure virtual method from Downloadable_Abstract */
+    /*! \brief Implementation of pure virtual method from Downloadable_Abstract
+     *
+     *  The files are downloaded in the order described in the documentation
+     *  of this class.
+     */
     Q_INVOKABLE void startDownload() override;
 
-    /*! \brief Implementation of pure virtual method from Downloadable_Abstract */
+    /*! \brief Implementation of pure virtual method from Downloadable_Abstract
+     *
+     *  This method also removes all files from the download queue.
+     */
     Q_INVOKABLE void stopDownload() override;
 
-    /*! \brief Implementation of pure virtual method from Downloadable_Abstract */
+    /*! \brief Implementation of pure virtual method from Downloadable_Abstract
+     *
+     *  The files are updated in the order described in the documentation of
+     *  this class.
+     */
     Q_INVOKABLE void update() override;
 
 signals:
     /*! \brief Notifier signal */
     void downloadablesChanged();
 
+    /*! \brief Notifier signal */
+    void maxConcurrentDownloadsChanged();
+
+    /*! \brief Notifier signal */
+    void throughputChanged();
+
 private:
+    // Re-evaluates all properties and emits notifier signals after the set of
+    // children has changed. Inside a batch, the method only marks the batch
+    // as changed.
+    void onDownloadablesChanged();
+
     // Re-evaluate members when the properties of a member changes
     void evaluateDownloading();
     void evaluateFiles();
@@ -205,6 +308,54 @@ private:
     // Returns 'true' if item has actually been added.
     bool rawAdd(DataManagement::Downloadable_Abstract* map);
 
+    // File that waits in the download queue
+    struct QueueItem
+    {
+        QPointer<DataManagement::Downloadable_SingleFile> downloadable;
+
+        // If true, call update() rather than startDownload()
+        bool isUpdate {false};
+
+        // If true, the file covers the current position or flight route
+        bool isPriority {false};
+    };
+
+    // File that is being transferred
+    struct ActiveDownload
+    {
+        QPointer<DataManagement::Downloadable_SingleFile> downloadable;
+
+        // Value of downloadable->bytesReceived() when the bytes of this file
+        // were last counted
+        qint64 bytesReceived {0};
+    };
+
+    // Appends the files to the download queue that startDownload() (if
+    // isUpdate is false) or update() (if isUpdate is true) need to handle.
+    // Files that are already queued or running are skipped.
+    void enqueue(bool isUpdate);
+
+    // Appends the files of group to the download queue, following the update
+    // policy of group. Nested groups are resolved recursively, so that the
+    // queue contains individual files only. Files and groups found in 'seen'
+    // are skipped, and all items handled are added to 'seen'.
+    void enqueue(DataManagement::Downloadable_MultiFile* group, bool isUpdate, bool isPriority, const QList<QGeoCoordinate>& priorityCoordinates, QSet<DataManagement::Downloadable_Abstract*>& seen);
+
+    // Sorts the queue and starts downloads until maxConcurrentDownloads files
+    // are being transferred
+    void scheduleDownloads();
+
+    // Current position and waypoints of the current flight route
+    static QList<QGeoCoordinate> priorityCoordinates();
+
+    // Adds the bytes that the file has received since they were last counted
+    // to m_bytesTransferred
+    void countReceivedBytes(ActiveDownload& activeDownload);
+
+    // Estimates the number of bytes that downloads started by this instance
+    // have transferred, and updates the property throughput
+    void updateThroughput();
+
     bool m_downloading {false};
     QStringList m_files;
     bool m_hasFile {false};
@@ -212,7 +363,28 @@ private:
     qint64 m_updateSize {0};
 
     QVector<QPointer<DataManagement::Downloadable_Abstract>> m_downloadables;
+
+    // Set of children, used to check membership in constant time. Children
+    // are removed from the set when they are destroyed.
+    QSet<DataManagement::Downloadable_Abstract*> m_downloadableSet;
+
+    // Nesting depth of batches, and flag indicating that the set of children
+    // changed during the current batch
+    int m_batchDepth {0};
+    bool m_batchChanged {false};
     DataManagement::Downloadable_MultiFile::UpdatePolicy m_updatePolicy;
+
+    // Download scheduler
+    int m_maxConcurrentDownloads {2};
+    QList<QueueItem> m_downloadQueue;
+    QList<ActiveDownload> m_activeDownloads;
+
+    // Throughput estimation. m_bytesTransferred counts the bytes that were
+    // actually received since the last estimate.
+    QTimer m_throughputTimer;
+    QElapsedTimer m_throughputClock;
+    qint64 m_bytesTransferred {0};
+    qint64 m_throughput {0};
 };
 
 } // namespace DataManagement
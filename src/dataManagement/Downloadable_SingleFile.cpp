@@ -99,7 +99,8 @@ DataManagement::Downloadable_SingleFile::~Downloadable_SingleFile()
         m_networkReplyDownloadHeader->abort();
         delete m_networkReplyDownloadHeader;
     }
-    delete m_saveFile;
+    delete m_partialFile;
+    delete m_tileDeltaUpdate;
 }
 
 
@@ -108,6 +109,16 @@ DataManagement::Downloadable_SingleFile::~Downloadable_SingleFile()
 // Getter Methods
 //
 
+auto DataManagement::Downloadable_SingleFile::bytesReceived() const -> qint64
+{
+    if (m_tileDeltaUpdate.isNull())
+    {
+        return m_bytesReceived;
+    }
+    return m_bytesReceived + m_tileDeltaUpdate->bytesReceived();
+}
+
+
 auto DataManagement::Downloadable_SingleFile::description() -> QString
 {
     QFileInfo const fileInfo(m_fileName);
@@ -332,7 +343,12 @@ void DataManagement::Downloadable_SingleFile::deleteFiles()
     QLockFile lockFile(m_fileName + ".lock");
     lockFile.lock();
     QFile::remove(m_fileName);
+    QFile::remove(TileDeltaUpdate::localManifestFileName(m_fileName));
     lockFile.unlock();
+    if (!downloading())
+    {
+        deletePartialFile();
+    }
     emit hasFileChanged();
     emit fileContentChanged();
 
@@ -358,8 +374,8 @@ void DataManagement::Downloadable_SingleFile::startDownload()
     auto oldDownloadProgress = m_downloadProgress;
     auto oldIsDownloading = downloading();
 
-    // Clear temporary file
-    delete m_saveFile;
+    // Close partial file of an earlier download
+    delete m_partialFile;
 
     // Create directory that will hold the local file, if it does not yet exist
     QDir const dir(QFileInfo(m_fileName).dir());
@@ -368,14 +384,39 @@ void DataManagement::Downloadable_SingleFile::startDownload()
         dir.mkpath(QStringLiteral("."));
     }
 
-    // Copy the temporary file to the local file
-    m_saveFile = new QSaveFile(m_fileName, this);
-    m_saveFile->open(QIODevice::WriteOnly);
-
-    // Start download
-    QNetworkRequest const request(m_url);
+    // Open the partial file. If it holds data from an earlier attempt and a
+    // validator of the remote file is known, then resume the download.
+    // Otherwise, start from scratch.
+    auto validator = partialFileValidator();
+    m_partialFile = new QFile(partialFileName(), this);
+    if (!m_partialFile->open(QIODevice::ReadWrite))
+    {
+        deletePartialFile();
+        emit error(objectName(), tr("the file %1 could not be opened for writing").arg(partialFileName()));
+        return;
+    }
+    m_resumeOffset = validator.isEmpty() ? 0 : m_partialFile->size();
+    if (!m_partialFile->resize(m_resumeOffset) || !m_partialFile->seek(m_resumeOffset))
+    {
+        deletePartialFile();
+        emit error(objectName(), tr("the file %1 could not be written").arg(partialFileName()));
+        return;
+    }
+    m_expectedFileSize = -1;
+    m_headersChecked = false;
+
+    // Start download. Ask for data without content encoding, so that byte
+    // ranges refer to the file itself.
+    QNetworkRequest request(m_url);
+    request.setRawHeader("Accept-Encoding", "identity");
+    if (m_resumeOffset > 0)
+    {
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(m_resumeOffset) + "-");
+        request.setRawHeader("If-Range", validator);
+    }
     m_networkReplyDownloadFile = GlobalObject::networkAccessManager()->get(request);
     connect(m_networkReplyDownloadFile, &QNetworkReply::finished, this, &Downloadable_SingleFile::downloadFileFinished);
+    connect(m_networkReplyDownloadFile, &QNetworkReply::metaDataChanged, this, &Downloadable_SingleFile::downloadFileMetaDataReceiver);
     connect(m_networkReplyDownloadFile, &QNetworkReply::readyRead, this, &Downloadable_SingleFile::downloadFilePartialDataReceiver);
     connect(m_networkReplyDownloadFile, &QNetworkReply::downloadProgress, this, &Downloadable_SingleFile::downloadFileProgressReceiver);
     connect(m_networkReplyDownloadFile, &QNetworkReply::errorOccurred, this, &Downloadable_SingleFile::downloadFileErrorReceiver);
@@ -425,10 +466,19 @@ void DataManagement::Downloadable_SingleFile::stopDownload()
     // Save old value to see if anything changed
     auto oldUpdateSize = updateSize();
 
-    // Stop the download
-    m_networkReplyDownloadFile->deleteLater();
-    m_networkReplyDownloadFile = nullptr;
-    delete m_saveFile;
+    // Stop the download. The partial file is closed, but kept.
+    if (!m_networkReplyDownloadFile.isNull())
+    {
+        m_networkReplyDownloadFile->deleteLater();
+        m_networkReplyDownloadFile = nullptr;
+    }
+    delete m_partialFile;
+    if (!m_tileDeltaUpdate.isNull())
+    {
+        m_bytesReceived += m_tileDeltaUpdate->bytesReceived();
+        m_tileDeltaUpdate->deleteLater();
+        m_tileDeltaUpdate = nullptr;
+    }
 
     // Emit signals as appropriate
     if (oldUpdateSize != updateSize())
@@ -441,10 +491,16 @@ void DataManagement::Downloadable_SingleFile::stopDownload()
 
 void DataManagement::Downloadable_SingleFile::update()
 {
-    if (updateSize() != 0)
+    if (updateSize() == 0)
     {
-        startDownload();
+        return;
+    }
+    if (m_deltaUpdatesAvailable && TileDeltaUpdate::canUpdate(m_fileName))
+    {
+        startDeltaUpdate();
+        return;
     }
+    startDownload();
 }
 
 
@@ -462,8 +518,17 @@ void DataManagement::Downloadable_SingleFile::downloadFileErrorReceiver(QNetwork
         return;
     }
 
+    // If the server cannot satisfy the range request, then the partial data
+    // is useless
+    bool const rangeNotSatisfiable = !m_networkReplyDownloadFile.isNull() &&
+        (m_networkReplyDownloadFile->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 416);
+
     // Stop the download
     stopDownload();
+    if (rangeNotSatisfiable)
+    {
+        deletePartialFile();
+    }
 
     // Do not do anything about SSL errors; this has already been handled by the SSLErrorHandler
     if ((code == QNetworkReply::SslHandshakeFailedError) &&
@@ -637,8 +702,7 @@ void DataManagement::Downloadable_SingleFile::downloadFileErrorReceiver(QNetwork
 void DataManagement::Downloadable_SingleFile::downloadFileFinished()
 {
     // Paranoid safety checks
-    //  Q_ASSERT(!_networkReplyDownloadFile.isNull() && !_tmpFile.isNull());
-    if (m_networkReplyDownloadFile.isNull() || m_saveFile.isNull())
+    if (m_networkReplyDownloadFile.isNull() || m_partialFile.isNull())
     {
         stopDownload();
         return;
@@ -649,8 +713,32 @@ void DataManagement::Downloadable_SingleFile::downloadFileFinished()
         return;
     }
 
-    // Read the last remaining bits of data, then close the temporary file
+    // Read the last remaining bits of data, then close the partial file
     downloadFilePartialDataReceiver();
+    if (m_partialFile.isNull())
+    {
+        return;
+    }
+    // Buffered data is written now. If this fails, the partial file is
+    // incomplete, even if the server did not announce a file size.
+    if (!m_partialFile->flush())
+    {
+        stopDownload();
+        deletePartialFile();
+        emit error(objectName(), tr("the downloaded data could not be written to disk"));
+        return;
+    }
+    auto fileSize = m_partialFile->size();
+    m_partialFile->close();
+
+    // Verify that the file is complete
+    if ((m_expectedFileSize >= 0) && (fileSize != m_expectedFileSize))
+    {
+        stopDownload();
+        deletePartialFile();
+        emit error(objectName(), tr("the size of the downloaded file does not match the size announced by the server"));
+        return;
+    }
 
     // Download is now finished to 100%
     if (m_downloadProgress != 100)
@@ -663,19 +751,54 @@ void DataManagement::Downloadable_SingleFile::downloadFileFinished()
     auto oldUpdateSize = updateSize();
     bool const oldHasLocalFile = hasFile();
 
-    // Copy the temporary file to the local file
+    // Replace the local file by the partial file. The old file is moved aside
+    // first and restored if the partial file cannot be moved into place, so
+    // that the user never loses the old file.
     emit aboutToChangeFile(m_fileName);
     QLockFile lockFile(m_fileName + ".lock");
     lockFile.lock();
-    m_saveFile->commit();
+    auto backupFileName = m_fileName + u".old"_qs;
+    QFile::remove(backupFileName);
+    auto success = !QFile::exists(m_fileName) || QFile::rename(m_fileName, backupFileName);
+    if (success)
+    {
+        success = QFile::rename(partialFileName(), m_fileName);
+        if (success)
+        {
+            QFile::remove(backupFileName);
+        }
+        else
+        {
+            QFile::rename(backupFileName, m_fileName);
+        }
+    }
     lockFile.unlock();
-    emit fileContentChanged();
+    if (success)
+    {
+        emit fileContentChanged();
+    }
 
-    // Delete the data structures for the download
-    delete m_saveFile;
+    // Delete the data structures for the download. If the file could not be
+    // moved into place, the partial file is deleted as well.
+    delete m_partialFile;
+    if (success)
+    {
+        QFile::remove(partialFileInfoName());
+    }
+    else
+    {
+        deletePartialFile();
+    }
     m_networkReplyDownloadFile->deleteLater();
     m_networkReplyDownloadFile = nullptr;
 
+    // Fetch the tile manifest, to allow for delta updates later, if the
+    // server publishes one
+    if (success && m_deltaUpdatesAvailable && ((m_contentType == BaseMapVector) || (m_contentType == BaseMapRaster) || (m_contentType == TerrainMap)))
+    {
+        TileDeltaUpdate::downloadManifest(m_url, m_fileName, this);
+    }
+
     // Emit signals as appropriate
     if (oldUpdateSize != updateSize())
     {
@@ -686,6 +809,80 @@ void DataManagement::Downloadable_SingleFile::downloadFileFinished()
         emit hasFileChanged();
     }
     emit downloadingChanged();
+    if (!success)
+    {
+        emit error(objectName(), tr("the downloaded file could not be saved"));
+    }
+}
+
+
+void DataManagement::Downloadable_SingleFile::downloadFileMetaDataReceiver()
+{
+    // Paranoid safety checks
+    if (m_networkReplyDownloadFile.isNull() || m_partialFile.isNull())
+    {
+        return;
+    }
+
+    // Check the headers only once, and only for the final response
+    auto statusCode = m_networkReplyDownloadFile->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (m_headersChecked || ((statusCode >= 300) && (statusCode < 400)))
+    {
+        return;
+    }
+    m_headersChecked = true;
+
+    if (statusCode == 206)
+    {
+        // The server sends the remainder of the file. The header
+        // Content-Range has the form "bytes 1000-4999/5000".
+        auto contentRange = QString::fromLatin1(m_networkReplyDownloadFile->rawHeader("Content-Range")).trimmed();
+        bool okFirst = false;
+        bool okTotal = false;
+        auto first = contentRange.section(u' ', 1).section(u'-', 0, 0).toLongLong(&okFirst);
+        auto total = contentRange.section(u'/', 1).toLongLong(&okTotal);
+        if (!okFirst || (first != m_resumeOffset))
+        {
+            stopDownload();
+            deletePartialFile();
+            emit error(objectName(), tr("the server sent an unexpected part of the file"));
+            return;
+        }
+        m_expectedFileSize = okTotal ? total : -1;
+    }
+    else
+    {
+        // The server sends the full file, either because this is a new
+        // download, because the remote file has changed, or because the
+        // server does not support range requests
+        m_resumeOffset = 0;
+        if (!m_partialFile->resize(0) || !m_partialFile->seek(0))
+        {
+            stopDownload();
+            deletePartialFile();
+            emit error(objectName(), tr("the downloaded data could not be written to disk"));
+            return;
+        }
+        auto contentLength = m_networkReplyDownloadFile->header(QNetworkRequest::ContentLengthHeader);
+        m_expectedFileSize = contentLength.isValid() ? contentLength.toLongLong() : -1;
+    }
+
+    // Save the validator of the remote file. Weak ETags cannot be used with
+    // If-Range, so Last-Modified is used instead.
+    auto validator = m_networkReplyDownloadFile->rawHeader("ETag");
+    if (validator.isEmpty() || validator.startsWith("W/"))
+    {
+        validator = m_networkReplyDownloadFile->rawHeader("Last-Modified");
+    }
+    if (validator.isEmpty())
+    {
+        validator = m_remoteFileValidator;
+    }
+    QFile infoFile(partialFileInfoName());
+    if (infoFile.open(QIODevice::WriteOnly))
+    {
+        infoFile.write(validator);
+    }
 }
 
 
@@ -696,7 +893,7 @@ void DataManagement::Downloadable_SingleFile::downloadFileProgressReceiver(qint6
     // If the content is compressed, then Qt does not know the total size and will set 'bytesTotal' to -1. In that case, the number _remoteFileSize might be a better estimate.
     if ((bytesTotal < 0) && (m_remoteFileSize > 0))
     {
-        bytesTotal = m_remoteFileSize;
+        bytesTotal = m_remoteFileSize - m_resumeOffset;
     }
     if (bytesTotal <= 0)
     {
@@ -704,7 +901,8 @@ void DataManagement::Downloadable_SingleFile::downloadFileProgressReceiver(qint6
     }
     else
     {
-        m_downloadProgress = qRound((100.0 * static_cast<double>(bytesReceived)) / static_cast<double>(bytesTotal));
+        // Count data that was already present when the download was resumed
+        m_downloadProgress = qRound((100.0 * static_cast<double>(m_resumeOffset + bytesReceived)) / static_cast<double>(m_resumeOffset + bytesTotal));
     }
 
     // Whatever, make sure that the number computed is between 0 and 100
@@ -720,7 +918,7 @@ void DataManagement::Downloadable_SingleFile::downloadFileProgressReceiver(qint6
 void DataManagement::Downloadable_SingleFile::downloadFilePartialDataReceiver()
 {
     // Paranoid safety checks
-    if (m_networkReplyDownloadFile.isNull() || m_saveFile.isNull())
+    if (m_networkReplyDownloadFile.isNull() || m_partialFile.isNull())
     {
         stopDownload();
         return;
@@ -730,8 +928,150 @@ void DataManagement::Downloadable_SingleFile::downloadFilePartialDataReceiver()
         return;
     }
 
-    // Write all available data to the temporary file
-    m_saveFile->write(m_networkReplyDownloadFile->readAll());
+    // Make sure that the headers have been checked before data is written
+    if (!m_headersChecked)
+    {
+        downloadFileMetaDataReceiver();
+        if (m_partialFile.isNull())
+        {
+            return;
+        }
+    }
+
+    // Write all available data to the partial file. If the disk is full or
+    // the file cannot be written for other reasons, the download is aborted.
+    auto data = m_networkReplyDownloadFile->readAll();
+    m_bytesReceived += data.size();
+    if (m_partialFile->write(data) != data.size())
+    {
+        stopDownload();
+        deletePartialFile();
+        emit error(objectName(), tr("the downloaded data could not be written to disk"));
+    }
+}
+
+
+void DataManagement::Downloadable_SingleFile::deletePartialFile()
+{
+    delete m_partialFile;
+    QFile::remove(partialFileName());
+    QFile::remove(partialFileInfoName());
+}
+
+
+void DataManagement::Downloadable_SingleFile::startDeltaUpdate()
+{
+    // Do not begin a new download if one is already running
+    if (downloading())
+    {
+        return;
+    }
+
+    // Save old value to see if anything changed
+    auto oldUpdateSize = updateSize();
+    auto oldDownloadProgress = m_downloadProgress;
+
+    m_tileDeltaUpdate = new TileDeltaUpdate(m_url, m_fileName, m_remoteFileSize, this);
+    connect(m_tileDeltaUpdate, &TileDeltaUpdate::readyToApply, this, &Downloadable_SingleFile::tileDeltaUpdateReady);
+    connect(m_tileDeltaUpdate, &TileDeltaUpdate::downloadProgressChanged, this, [this](int percentage)
+    {
+        m_downloadProgress = percentage;
+        emit downloadProgressChanged(m_downloadProgress);
+    });
+    connect(m_tileDeltaUpdate, &TileDeltaUpdate::failed, this, [this]()
+    {
+        // Fall back to downloading the full file
+        m_bytesReceived += m_tileDeltaUpdate->bytesReceived();
+        m_tileDeltaUpdate->deleteLater();
+        m_tileDeltaUpdate = nullptr;
+        startDownload();
+    });
+    m_tileDeltaUpdate->start();
+    m_downloadProgress = 0;
+
+    // Emit signals as appropriate
+    if (oldUpdateSize != updateSize())
+    {
+        emit updateSizeChanged();
+    }
+    if (m_downloadProgress != oldDownloadProgress)
+    {
+        emit downloadProgressChanged(m_downloadProgress);
+    }
+    emit downloadingChanged();
+}
+
+
+void DataManagement::Downloadable_SingleFile::tileDeltaUpdateReady()
+{
+    // Paranoid safety checks
+    if (m_tileDeltaUpdate.isNull())
+    {
+        return;
+    }
+
+    // Write the changed tiles into the local file, in a background thread
+    emit aboutToChangeFile(m_fileName);
+    QPointer<TileDeltaUpdate> const tileDeltaUpdate = m_tileDeltaUpdate;
+    m_tileDeltaUpdate->apply().then(this, [this, tileDeltaUpdate](const QString& errorMessage)
+    {
+        tileDeltaUpdateApplied(tileDeltaUpdate, errorMessage);
+    });
+}
+
+
+void DataManagement::Downloadable_SingleFile::tileDeltaUpdateApplied(const QPointer<TileDeltaUpdate>& tileDeltaUpdate, const QString& errorMessage)
+{
+    emit fileContentChanged();
+
+    // Do nothing more if the update has been stopped in the meantime
+    if (tileDeltaUpdate.isNull() || (tileDeltaUpdate != m_tileDeltaUpdate))
+    {
+        return;
+    }
+
+    // Save old value to see if anything changed
+    auto oldUpdateSize = updateSize();
+
+    m_bytesReceived += m_tileDeltaUpdate->bytesReceived();
+    m_tileDeltaUpdate->deleteLater();
+    m_tileDeltaUpdate = nullptr;
+
+    // If the local file could not be modified, then download the full file
+    if (!errorMessage.isEmpty())
+    {
+        startDownload();
+        return;
+    }
+
+    // Download is now finished to 100%
+    if (m_downloadProgress != 100)
+    {
+        m_downloadProgress = 100;
+        emit downloadProgressChanged(m_downloadProgress);
+    }
+
+    // Emit signals as appropriate
+    if (oldUpdateSize != updateSize())
+    {
+        emit updateSizeChanged();
+    }
+    emit downloadingChanged();
+}
+
+
+auto DataManagement::Downloadable_SingleFile::partialFileValidator() const -> QByteArray
+{
+    if (!QFile::exists(partialFileName()))
+    {
+        return {};
+    }
+    QFile infoFile(partialFileInfoName());
+    if (!infoFile.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+    return infoFile.readAll().trimmed();
 }
 
 
@@ -758,6 +1098,11 @@ void DataManagement::Downloadable_SingleFile::downloadHeaderFinished()
         m_networkReplyDownloadHeader->header(QNetworkRequest::LastModifiedHeader).toDateTime();
     m_remoteFileSize =
         m_networkReplyDownloadHeader->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+    m_remoteFileValidator = m_networkReplyDownloadHeader->rawHeader("ETag");
+    if (m_remoteFileValidator.isEmpty() || m_remoteFileValidator.startsWith("W/"))
+    {
+        m_remoteFileValidator = m_networkReplyDownloadHeader->rawHeader("Last-Modified");
+    }
 
     // Emit signals as appropriate
     if (m_remoteFileDate != old_remoteFileDate)
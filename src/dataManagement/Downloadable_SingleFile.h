@@ -26,9 +26,9 @@
 #include <QNetworkReply>
 #include <QPointer>
 #include <QQmlEngine>
-#include <QSaveFile>
 
 #include "Downloadable_Abstract.h"
+#include "dataManagement/TileDeltaUpdate.h"
 
 namespace DataManagement
 {
@@ -142,6 +142,16 @@ public:
     // Getter Methods
     //
 
+    /*! \brief Number of bytes received
+     *
+     *  This method counts the bytes that this instance has received from the
+     *  network for downloads and delta updates, since it was constructed. The
+     *  count includes data of downloads that were later stopped or failed.
+     *
+     *  @returns Number of bytes received
+     */
+    [[nodiscard]] auto bytesReceived() const -> qint64;
+
     /*! \brief Implementation of pure virtual getter method from Downloadable_Abstract
      *
      * @returns Property description
@@ -152,7 +162,7 @@ public:
      *
      * @returns Property downloading
      */
-    [[nodiscard]] auto downloading() -> bool override { return !m_networkReplyDownloadFile.isNull(); }
+    [[nodiscard]] auto downloading() -> bool override { return !m_networkReplyDownloadFile.isNull() || !m_tileDeltaUpdate.isNull(); }
 
     /*! \brief Getter function for the property with the same name
      *
@@ -232,6 +242,17 @@ public:
      */
     void setRemoteFileSize(qint64 size);
 
+    /*! \brief Specify if the server publishes tile manifests
+     *
+     * If set to true, the tile manifest is downloaded together with MBTILES
+     * files, and later updates are attempted as delta updates. The value is
+     * typically read from the file maps.json. Defaults to false.
+     *
+     * @param available True if the server publishes a tile manifest for the
+     * remote file
+     */
+    void setDeltaUpdatesAvailable(bool available) { m_deltaUpdatesAvailable = available; }
+
 
 
     //
@@ -240,7 +261,8 @@ public:
 
     /*! \brief Implementation of pure virtual method from Downloadable_Abstract
      *
-     * This method deletes the local file. The singals
+     * This method deletes the local file, its tile manifest, and any
+     * partially downloaded data of a download that is not running. The singals
      * aboutToChangeLocalFile() and localFileChanged() are emitted
      * appropriately, and a QLockFile is used at fileName()+".lock".
      */
@@ -252,17 +274,25 @@ public:
      * already in progress, nothing will happen.  Otherwise, the following will
      * take place.
      *
-     * -# Data is retrieved from the remote server and stored in a temporary
-     *    file. The signal downloadProgress() will be emitted regularly.
+     * -# Data is retrieved from the remote server and stored in the partial
+     *    file fileName()+".part". The signal downloadProgress() will be
+     *    emitted regularly.
      *
      * -# In case of an error, the signal error() is emitted and the download
-     *    stops.
+     *    stops. The partial file is kept.
      *
      * -# Optionally, the download can be stopped using the method
-     *    stopFileDownload().
+     *    stopFileDownload(). The partial file is kept.
+     *
+     * If a partial file from an earlier attempt exists, together with a
+     * validator (ETag or Last-Modified) of the remote file, the download
+     * resumes with an HTTP range request. If the remote file has changed in
+     * the meantime, the server sends the full file and the partial data is
+     * discarded.
      *
-     * Once all data has been downloaded successfully to the temporary file, the
-     * process continues as follows.
+     * Once all data has been downloaded successfully to the partial file, and
+     * its size agrees with the size announced by the server, the process
+     * continues as follows.
      *
      * -# The signal aboutToChangeLocalFile() is emitted. As the name suggests,
      *    this indicates that the local file is about to change and that it
@@ -270,12 +300,16 @@ public:
      *
      * -# A QLockFile is created at fileName()+".lock"
      *
-     * -# The local file is overwritten by the newly downloaded data.
+     * -# The local file is replaced by the partial file.
      *
      * -# The QLockFile is removed
      *
      * -# The signal fileChanged() is emitted to indicate that the file is
      *    again ready to be used.
+     *
+     * For MBTILES files, the tile manifest of the remote file is downloaded
+     * afterwards, so that later updates can be done with TileDeltaUpdate. This
+     * happens only if setDeltaUpdatesAvailable() has been set to true.
      */
     Q_INVOKABLE void startDownload() override;
 
@@ -295,13 +329,20 @@ public:
 
     /*! \brief Stops download process
      *
-     * This method stops the currenly running download process gracefully and
-     * deletes any partially downloaded data. No signal will be emitted.  If no
-     * download is in progress, nothing will happen.
+     * This method stops the currenly running download process gracefully.
+     * Partially downloaded data is kept, so that the next call to
+     * startDownload() can resume the download. No signal will be emitted.  If
+     * no download is in progress, nothing will happen.
      */
     Q_INVOKABLE void stopDownload() override;
 
-    /*! \brief Implementation of pure virtual method from Downloadable_Abstract */
+    /*! \brief Implementation of pure virtual method from Downloadable_Abstract
+     *
+     * If delta updates are available and the local file is an MBTILES file
+     * with a tile manifest, this method attempts to download only the changed
+     * tiles, using TileDeltaUpdate. If
+     * that is not possible, the full file is downloaded with startDownload().
+     */
     Q_INVOKABLE void update() override;
 
 signals:
@@ -363,6 +404,41 @@ private:
     // _networkReplyDownload.
     void downloadFilePartialDataReceiver();
 
+    // Called once the headers of the remote file have been received, this
+    // method checks if the server honoured the range request. If the server
+    // sends the full file, the partial file is truncated. The validators of
+    // the remote file are saved, so that the download can be resumed later.
+    // Connected to &QNetworkReply::metaDataChanged of
+    // m_networkReplyDownloadFile.
+    void downloadFileMetaDataReceiver();
+
+    // Deletes the partial file and its validators
+    void deletePartialFile();
+
+    // Starts a delta update of an MBTILES file. If the delta update fails,
+    // the full file is downloaded instead.
+    void startDeltaUpdate();
+
+    // Called once all changed tiles of a delta update have been downloaded,
+    // this method starts writing them into the local file, in a background
+    // thread. Connected to &TileDeltaUpdate::readyToApply of
+    // m_tileDeltaUpdate.
+    void tileDeltaUpdateReady();
+
+    // Called in the GUI thread once the background thread started by
+    // tileDeltaUpdateReady() has finished.
+    void tileDeltaUpdateApplied(const QPointer<TileDeltaUpdate>& tileDeltaUpdate, const QString& errorMessage);
+
+    // Reads the validators of the partial file. Returns an empty QByteArray if
+    // no validator is known.
+    [[nodiscard]] auto partialFileValidator() const -> QByteArray;
+
+    // Name of the file holding the data of an incomplete download
+    [[nodiscard]] auto partialFileName() const -> QString { return m_fileName + u".part"_qs; }
+
+    // Name of the file holding the validator of an incomplete download
+    [[nodiscard]] auto partialFileInfoName() const -> QString { return m_fileName + u".partinfo"_qs; }
+
     // Called once download of the remote file header data is finished, this
     // method updates the properties remoteFileDate and remoteFileSize, and
     // _networkReplyDownloadHeader by calling deleteLater. Connected to
@@ -372,6 +448,10 @@ private:
     // This member holds the download progress.
     int m_downloadProgress{0};
 
+    // Number of bytes received from the network, not counting the running
+    // delta update
+    qint64 m_bytesReceived{0};
+
     // NetworkReply for downloading of remote file data. Set to nullptr when no
     // download is in progress.
     QPointer<QNetworkReply> m_networkReplyDownloadFile;
@@ -380,9 +460,29 @@ private:
     // no download is in progress.
     QPointer<QNetworkReply> m_networkReplyDownloadHeader;
 
-    // Temporary file for storing partiall data when downloading the remote
-    // file. Set to nullptr when no download is in progress.
-    QPointer<QSaveFile> m_saveFile{};
+    // Partial file for storing data when downloading the remote file. Set to
+    // nullptr when no download is in progress.
+    QPointer<QFile> m_partialFile{};
+
+    // Delta update of an MBTILES file. Set to nullptr when no delta update is
+    // in progress.
+    QPointer<TileDeltaUpdate> m_tileDeltaUpdate;
+
+    // Number of bytes that were already present in the partial file when the
+    // current download started
+    qint64 m_resumeOffset{0};
+
+    // Expected size of the complete file, as announced by the server for the
+    // current download, or -1 if unknown
+    qint64 m_expectedFileSize{-1};
+
+    // Set once the headers of the current download have been checked by
+    // downloadFileMetaDataReceiver()
+    bool m_headersChecked{false};
+
+    // Validator of the remote file (ETag, or Last-Modified if no ETag is
+    // provided), as found by the last call to startInfoDownload()
+    QByteArray m_remoteFileValidator;
 
     // URL of the remote file, as set in the constructor
     QUrl m_url;
@@ -397,6 +497,9 @@ private:
     // Size of the remote file, set directly via a setter method or by calling
     // downloadRemoteFileInfo().
     qint64 m_remoteFileSize{-1};
+
+    // True if the server publishes a tile manifest for the remote file
+    bool m_deltaUpdatesAvailable{false};
 };
 
 } // namespace DataManagement
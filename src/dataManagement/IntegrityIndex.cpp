@@ -0,0 +1,427 @@
+/***************************************************************************
+ *   Copyright (C) 2019-2024 by Stefan Kebekus                             *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QDataStream>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include "dataManagement/IntegrityIndex.h"
+
+
+namespace {
+
+// Magic number and version of the index file
+constexpr quint32 indexMagic = 0x49444958;
+constexpr quint32 indexVersion = 2;
+
+// Files with these suffixes are checked. Other files, such as partial
+// downloads, are only listed.
+bool isDataFile(const QString& fileName)
+{
+    return fileName.endsWith(u".geojson"_qs)
+           || fileName.endsWith(u".mbtiles"_qs)
+           || fileName.endsWith(u".raster"_qs)
+           || fileName.endsWith(u".terrain"_qs)
+           || fileName.endsWith(u".txt"_qs);
+}
+
+} // namespace
+
+
+
+//
+// Constructor and destructor
+//
+
+DataManagement::IntegrityIndex::IntegrityIndex(const QString& directory, const QString& indexFileName, QObject* parent)
+    : QObject(parent), m_directory(directory), m_indexFileName(indexFileName)
+{
+    load();
+}
+
+
+DataManagement::IntegrityIndex::~IntegrityIndex()
+{
+    m_canceled = true;
+    m_checking.waitForFinished();
+    save();
+}
+
+
+
+//
+// Getter Methods
+//
+
+bool DataManagement::IntegrityIndex::isCurrent() const
+{
+    if (m_directories.isEmpty())
+    {
+        return false;
+    }
+    for (auto [directory, lastModified] : m_directories.asKeyValueRange())
+    {
+        QFileInfo const info(directory);
+        if (!info.isDir() || (info.lastModified() != lastModified))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+//
+// Methods
+//
+
+void DataManagement::IntegrityIndex::commit(const QString& fileName)
+{
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    recordDirectories(fileName);
+    if (!QFile::exists(fileName))
+    {
+        m_entries.remove(fileName);
+        m_pending.removeAll(fileName);
+        save();
+        return;
+    }
+
+    m_entries[fileName] = {};
+    if (!m_pending.contains(fileName))
+    {
+        m_pending.append(fileName);
+    }
+    processPending();
+}
+
+
+QStringList DataManagement::IntegrityIndex::files()
+{
+    if (!isCurrent())
+    {
+        rescan();
+    }
+    QStringList result;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+    {
+        if (isDataFile(it.key()))
+        {
+            result.append(it.key());
+        }
+    }
+    return result;
+}
+
+
+QStringList DataManagement::IntegrityIndex::partialFiles()
+{
+    if (!isCurrent())
+    {
+        rescan();
+    }
+    QStringList result;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+    {
+        if (it.key().endsWith(u".part"_qs))
+        {
+            result.append(it.key());
+        }
+    }
+    return result;
+}
+
+
+void DataManagement::IntegrityIndex::rescan()
+{
+    m_directories.clear();
+    m_directories[m_directory] = QFileInfo(m_directory).lastModified();
+    QDirIterator dirIterator(m_directory, QDir::Dirs|QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (dirIterator.hasNext())
+    {
+        dirIterator.next();
+        m_directories[dirIterator.filePath()] = dirIterator.fileInfo().lastModified();
+    }
+
+    QSet<QString> files;
+    QDirIterator fileIterator(m_directory, QDir::Files, QDirIterator::Subdirectories);
+    while (fileIterator.hasNext())
+    {
+        fileIterator.next();
+        auto fileName = fileIterator.filePath();
+        files.insert(fileName);
+        if (!m_entries.contains(fileName))
+        {
+            m_entries[fileName] = {};
+            m_pending.append(fileName);
+        }
+    }
+    m_entries.removeIf([&files](const QHash<QString, Entry>::iterator& entry) { return !files.contains(entry.key()); });
+
+    save();
+    processPending();
+}
+
+
+void DataManagement::IntegrityIndex::verify()
+{
+    bool hasRemovals = false;
+    for (auto it = m_entries.begin(); it != m_entries.end(); )
+    {
+        QFileInfo const info(it.key());
+        if (!info.exists())
+        {
+            it = m_entries.erase(it);
+            hasRemovals = true;
+            continue;
+        }
+        auto changed = (info.size() != it->size) || (info.lastModified() != it->lastModified);
+        auto unchecked = isDataFile(it.key()) && !it->checked;
+        if ((changed || unchecked) && !m_pending.contains(it.key()))
+        {
+            m_pending.append(it.key());
+        }
+        ++it;
+    }
+    if (hasRemovals)
+    {
+        save();
+    }
+    processPending();
+}
+
+
+
+//
+// Private Methods
+//
+
+auto DataManagement::IntegrityIndex::check(const QString& fileName, const std::atomic<bool>& canceled) -> Entry
+{
+    Entry entry;
+    QFileInfo const info(fileName);
+    if (!info.exists())
+    {
+        return entry;
+    }
+    entry.size = info.size();
+    entry.lastModified = info.lastModified();
+    if (!isDataFile(fileName))
+    {
+        return entry;
+    }
+
+    // If the file cannot be opened, it is left unchecked and checked again
+    // later. This is no indication that the file is damaged.
+    QFile file(fileName);
+    if (canceled || !file.open(QIODevice::ReadOnly))
+    {
+        return entry;
+    }
+    entry.checked = true;
+    entry.damaged = !looksComplete(file, entry.size);
+    return entry;
+}
+
+
+bool DataManagement::IntegrityIndex::looksComplete(QFile& file, qint64 size)
+{
+    auto fileName = file.fileName();
+
+    // MBTILES files are SQLite databases. The header records the page size
+    // and, if the change counters agree, the number of pages.
+    if (fileName.endsWith(u".mbtiles"_qs) || fileName.endsWith(u".raster"_qs) || fileName.endsWith(u".terrain"_qs))
+    {
+        if ((size < 100) || !file.seek(0))
+        {
+            return false;
+        }
+        auto header = file.read(100);
+        if ((header.size() != 100) || !header.startsWith(QByteArrayView("SQLite format 3\0", 16)))
+        {
+            return false;
+        }
+        const auto* data = header.constData();
+        qint64 pageSize = qFromBigEndian<quint16>(data+16);
+        if (pageSize == 1)
+        {
+            pageSize = 65536;
+        }
+        if (pageSize < 512)
+        {
+            return false;
+        }
+        auto changeCounter = qFromBigEndian<quint32>(data+24);
+        auto pageCount = qFromBigEndian<quint32>(data+28);
+        auto versionValidFor = qFromBigEndian<quint32>(data+92);
+        if ((changeCounter == versionValidFor) && (pageCount > 0))
+        {
+            return size >= pageSize*pageCount;
+        }
+        return (size % pageSize) == 0;
+    }
+
+    // GeoJSON files must end with a closing bracket
+    if (fileName.endsWith(u".geojson"_qs))
+    {
+        if (!file.seek(qMax(qint64(0), size-64)))
+        {
+            return false;
+        }
+        auto tail = file.read(64).trimmed();
+        return tail.endsWith('}') || tail.endsWith(']');
+    }
+
+    return true;
+}
+
+
+void DataManagement::IntegrityIndex::recordDirectories(const QString& fileName)
+{
+    auto directory = QFileInfo(fileName).path();
+    while (directory.startsWith(m_directory))
+    {
+        QFileInfo const info(directory);
+        if (info.isDir())
+        {
+            m_directories[directory] = info.lastModified();
+        }
+        else
+        {
+            m_directories.remove(directory);
+        }
+        if (directory.size() <= m_directory.size())
+        {
+            break;
+        }
+        directory = directory.section(u'/', 0, -2);
+    }
+}
+
+
+void DataManagement::IntegrityIndex::processPending()
+{
+    if (m_checking.isRunning() || m_pending.isEmpty())
+    {
+        return;
+    }
+
+    auto fileNames = m_pending;
+    m_pending.clear();
+    m_checking = QtConcurrent::run([fileNames, this]()
+    {
+        QList<QPair<QString, Entry>> results;
+        foreach(auto fileName, fileNames)
+        {
+            auto entry = check(fileName, m_canceled);
+            if (m_canceled)
+            {
+                break;
+            }
+            results.append({fileName, entry});
+        }
+        return results;
+    });
+
+    m_checking.then(this, [this](const QList<QPair<QString, Entry>>& results)
+    {
+        foreach(auto result, results)
+        {
+            // Files committed again in the meantime are checked once more
+            if (m_pending.contains(result.first))
+            {
+                continue;
+            }
+            if (result.second.size < 0)
+            {
+                m_entries.remove(result.first);
+                continue;
+            }
+            m_entries[result.first] = result.second;
+            if (result.second.damaged)
+            {
+                emit damaged(result.first);
+            }
+        }
+        save();
+        processPending();
+    });
+}
+
+
+void DataManagement::IntegrityIndex::load()
+{
+    QFile file(m_indexFileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if ((magic != indexMagic) || (version != indexVersion))
+    {
+        return;
+    }
+
+    QHash<QString, QDateTime> directories;
+    qsizetype numEntries = 0;
+    stream >> directories >> numEntries;
+    QHash<QString, Entry> entries;
+    for (qsizetype i = 0; (i < numEntries) && (stream.status() == QDataStream::Ok); i++)
+    {
+        QString fileName;
+        Entry entry;
+        stream >> fileName >> entry.size >> entry.lastModified >> entry.checked >> entry.damaged;
+        entries[fileName] = entry;
+    }
+    if (stream.status() != QDataStream::Ok)
+    {
+        return;
+    }
+    m_directories = directories;
+    m_entries = entries;
+}
+
+
+void DataManagement::IntegrityIndex::save()
+{
+    QSaveFile file(m_indexFileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << indexMagic << indexVersion << m_directories << m_entries.size();
+    for (auto [fileName, entry] : m_entries.asKeyValueRange())
+    {
+        stream << fileName << entry.size << entry.lastModified << entry.checked << entry.damaged;
+    }
+    file.commit();
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   Copyright (C) 2019-2024 by Stefan Kebekus                             *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#pragma once
+
+#include <QDateTime>
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <atomic>
+
+namespace DataManagement
+{
+
+/*! \brief Integrity index for the files in a data directory
+ *
+ *  This class keeps a small, persistent index of the files in a directory
+ *  and its subdirectories. For every file, the index stores size and
+ *  modification time, together with the result of a cheap structural check
+ *  that detects truncated files. For MBTILES files, the size of the file is
+ *  compared to the size recorded in the SQLite header. For GeoJSON files, the
+ *  file must end with a closing bracket. The check reads only a few bytes of
+ *  every file.
+ *
+ *  Files are checked in a background thread, one at a time, when they are
+ *  committed with commit(), or when verify() finds that size or modification
+ *  time have changed since the last check. Files that cannot be opened, for
+ *  instance because another process locks them, are left unchecked and
+ *  checked again by the next call to verify(). Files found to be damaged are
+ *  reported with the signal damaged().
+ *
+ *  In addition, the index stores the modification times of the directories.
+ *  As long as these have not changed, the list of files can be taken from
+ *  the index, and there is no need to scan the directory tree.
+ */
+
+class IntegrityIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*! \brief Standard constructor
+     *
+     *  The constructor reads the index file, if it exists.
+     *
+     *  @param directory Directory whose files are indexed, without trailing
+     *  slash
+     *
+     *  @param indexFileName Name of the file that stores the index. The file
+     *  should not be contained in the directory.
+     *
+     *  @param parent The standard QObject parent pointer
+     */
+    IntegrityIndex(const QString& directory, const QString& indexFileName, QObject* parent = nullptr);
+
+    /*! \brief Standard destructor
+     *
+     *  The destructor waits for the background thread and saves the index.
+     */
+    ~IntegrityIndex() override;
+
+
+    //
+    // Getter Methods
+    //
+
+    /*! \brief Check if the list of files in the index is current
+     *
+     *  @returns True if none of the indexed directories was changed since the
+     *  last call to rescan() or commit(), and no directory was added
+     */
+    [[nodiscard]] bool isCurrent() const;
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Record a change of a file
+     *
+     *  Call this method whenever the app has written, replaced or deleted a
+     *  file in the directory. If the file exists, it is checked in the
+     *  background. Otherwise, it is removed from the index.
+     *
+     *  @param fileName Full path of the file
+     */
+    void commit(const QString& fileName);
+
+    /*! \brief List of data files in the directory
+     *
+     *  If the index is current, the list is taken from the index. Otherwise,
+     *  the directory is scanned with rescan(). Only data files are listed,
+     *  that is, files that the index checks. Partial downloads, manifests and
+     *  other auxiliary files are omitted.
+     *
+     *  @returns Full paths of all data files in the directory and its
+     *  subdirectories
+     */
+    [[nodiscard]] QStringList files();
+
+    /*! \brief List of partial downloads in the directory
+     *
+     *  Like files(), but lists the partial downloads, that is, the files
+     *  with suffix ".part".
+     *
+     *  @returns Full paths of all partial downloads in the directory and its
+     *  subdirectories
+     */
+    [[nodiscard]] QStringList partialFiles();
+
+    /*! \brief Scan the directory
+     *
+     *  This method scans the directory tree, records the modification times
+     *  of all directories, adds new files to the index and removes entries of
+     *  files that no longer exist. New files are checked in the background.
+     */
+    void rescan();
+
+    /*! \brief Verify files lazily
+     *
+     *  This method compares size and modification time of all indexed files
+     *  with the values in the index. Files that have changed or could not be
+     *  checked before are checked in the background. Entries of files that no
+     *  longer exist are removed.
+     */
+    void verify();
+
+signals:
+    /*! \brief Damaged file found
+     *
+     *  This signal is emitted when the structural check finds that a file is
+     *  truncated. It is not emitted if the file cannot be opened.
+     *
+     *  @param fileName Full path of the file
+     */
+    void damaged(const QString& fileName);
+
+private:
+    Q_DISABLE_COPY_MOVE(IntegrityIndex)
+
+    // Entry of the index
+    struct Entry
+    {
+        qint64 size {-1};
+        QDateTime lastModified;
+        bool checked {false};
+        bool damaged {false};
+    };
+
+    // Computes an entry for the file. This method is reentrant and meant to
+    // be run in a background thread. If canceled is set, or if the file
+    // cannot be opened, the entry is marked as unchecked. If the file does
+    // not exist, an entry with negative size is returned.
+    static Entry check(const QString& fileName, const std::atomic<bool>& canceled);
+
+    // Cheap structural check that detects truncated files. The file must be
+    // open.
+    static bool looksComplete(QFile& file, qint64 size);
+
+    // Records the current modification times of the directories that
+    // contain the file
+    void recordDirectories(const QString& fileName);
+
+    // Checks files in m_pending, in a background thread
+    void processPending();
+
+    // Reads and writes the index file
+    void load();
+    void save();
+
+    QString m_directory;
+    QString m_indexFileName;
+
+    // Index of files and directories, keyed by full path
+    QHash<QString, Entry> m_entries;
+    QHash<QString, QDateTime> m_directories;
+
+    // Files waiting to be checked, and the check running in the background
+    QStringList m_pending;
+    QFuture<QList<QPair<QString, Entry>>> m_checking;
+    std::atomic<bool> m_canceled {false};
+};
+
+} // namespace DataManagement
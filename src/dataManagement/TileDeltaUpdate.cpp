@@ -0,0 +1,396 @@
+/***************************************************************************
+ *   Copyright (C) 2019-2024 by Stefan Kebekus                             *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "GlobalObject.h"
+#include "dataManagement/TileDeltaUpdate.h"
+#include "fileFormats/MBTILES.h"
+
+
+namespace {
+
+// URL of the manifest that describes a remote MBTILES file
+QUrl manifestURL(const QUrl& url)
+{
+    auto result = url;
+    result.setPath(url.path() + u".manifest"_qs);
+    return result;
+}
+
+} // namespace
+
+
+DataManagement::TileDeltaUpdate::TileDeltaUpdate(const QUrl& url, QString fileName, qint64 remoteFileSize, QObject* parent)
+    : QObject(parent), m_url(url), m_fileName(std::move(fileName)), m_remoteFileSize(remoteFileSize)
+{
+}
+
+
+DataManagement::TileDeltaUpdate::~TileDeltaUpdate()
+{
+    // The worker thread reads from the staging file, which is deleted with
+    // this object
+    m_applying.waitForFinished();
+
+    if (!m_manifestReply.isNull())
+    {
+        m_manifestReply->abort();
+        delete m_manifestReply;
+    }
+    foreach(auto reply, m_tileReplies)
+    {
+        if (!reply.isNull())
+        {
+            reply->abort();
+            delete reply;
+        }
+    }
+}
+
+
+
+//
+// Methods
+//
+
+auto DataManagement::TileDeltaUpdate::apply() -> QFuture<QString>
+{
+    if (m_failed || !m_requestQueue.isEmpty() || !m_tileReplies.isEmpty() || m_applying.isValid())
+    {
+        return QtFuture::makeReadyValueFuture(tr("the update is incomplete"));
+    }
+    m_stagingFile.flush();
+
+    // The worker thread reads the staged data through its own file handle and
+    // works on copies of all data, so that it never touches this QObject
+    m_applying = QtConcurrent::run([fileName = m_fileName,
+                                    stagingFileName = m_stagingFile.fileName(),
+                                    stagedTiles = m_stagedTiles,
+                                    removedTiles = m_removedTiles,
+                                    metaData = m_metaData,
+                                    remoteManifest = m_remoteManifest]() -> QString
+    {
+        QFile stagingFile(stagingFileName);
+        if (!stagingFile.open(QIODevice::ReadOnly))
+        {
+            return tr("the downloaded tiles could not be read");
+        }
+        // A staged tile that cannot be read in full aborts the update, so
+        // that the tile is never replaced by truncated data
+        auto tileData = [&stagingFile, &stagedTiles](const QString& key) -> std::optional<QByteArray>
+        {
+            auto stagedTile = stagedTiles.value(key);
+            if (!stagingFile.seek(stagedTile.offset))
+            {
+                return std::nullopt;
+            }
+            auto data = stagingFile.read(stagedTile.size);
+            if (data.size() != stagedTile.size)
+            {
+                return std::nullopt;
+            }
+            return data;
+        };
+
+        QLockFile lockFile(fileName + u".lock"_qs);
+        lockFile.lock();
+        auto result = FileFormats::MBTILES::writeTiles(fileName, stagedTiles.keys(), tileData, removedTiles, metaData);
+        if (result.isEmpty())
+        {
+            // The local file now agrees with the remote manifest
+            QSaveFile manifestFile(localManifestFileName(fileName));
+            if (manifestFile.open(QIODevice::WriteOnly))
+            {
+                manifestFile.write(remoteManifest);
+                manifestFile.commit();
+            }
+
+            // Mark the local file as current, in the same way a full download would
+            QFile file(fileName);
+            if (file.open(QIODevice::ReadWrite))
+            {
+                file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+            }
+        }
+        lockFile.unlock();
+        return result;
+    });
+    return m_applying;
+}
+
+
+auto DataManagement::TileDeltaUpdate::canUpdate(const QString& fileName) -> bool
+{
+    if (!fileName.endsWith(u".mbtiles") && !fileName.endsWith(u".raster") && !fileName.endsWith(u".terrain"))
+    {
+        return false;
+    }
+    return QFile::exists(fileName) && QFile::exists(localManifestFileName(fileName));
+}
+
+
+void DataManagement::TileDeltaUpdate::downloadManifest(const QUrl& url, const QString& fileName, QObject* context)
+{
+    // A manifest of an older version of the file would be misleading
+    QFile::remove(localManifestFileName(fileName));
+
+    auto* reply = GlobalObject::networkAccessManager()->get(QNetworkRequest(manifestURL(url)));
+    reply->setParent(context);
+    connect(reply, &QNetworkReply::finished, context, [reply, fileName]()
+    {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            return;
+        }
+        auto data = reply->readAll();
+        if (!QJsonDocument::fromJson(data).isObject())
+        {
+            return;
+        }
+        QSaveFile manifestFile(localManifestFileName(fileName));
+        if (manifestFile.open(QIODevice::WriteOnly))
+        {
+            manifestFile.write(data);
+            manifestFile.commit();
+        }
+    });
+}
+
+
+void DataManagement::TileDeltaUpdate::start()
+{
+    if (!m_manifestReply.isNull() || m_failed)
+    {
+        return;
+    }
+    m_manifestReply = GlobalObject::networkAccessManager()->get(QNetworkRequest(manifestURL(m_url)));
+    connect(m_manifestReply, &QNetworkReply::finished, this, &TileDeltaUpdate::manifestFinished);
+}
+
+
+
+//
+// Private Methods
+//
+
+void DataManagement::TileDeltaUpdate::fail()
+{
+    if (m_failed)
+    {
+        return;
+    }
+    m_failed = true;
+    m_requestQueue.clear();
+    foreach(auto reply, m_tileReplies)
+    {
+        if (!reply.isNull())
+        {
+            reply->abort();
+            reply->deleteLater();
+        }
+    }
+    m_tileReplies.clear();
+    emit failed();
+}
+
+
+void DataManagement::TileDeltaUpdate::manifestFinished()
+{
+    // Paranoid safety checks
+    if (m_manifestReply.isNull())
+    {
+        fail();
+        return;
+    }
+    m_manifestReply->deleteLater();
+    if (m_manifestReply->error() != QNetworkReply::NoError)
+    {
+        fail();
+        return;
+    }
+    m_remoteManifest = m_manifestReply->readAll();
+
+    // Read local and remote manifest
+    QFile localManifestFile(localManifestFileName(m_fileName));
+    if (!localManifestFile.open(QIODevice::ReadOnly))
+    {
+        fail();
+        return;
+    }
+    auto localManifest = QJsonDocument::fromJson(localManifestFile.readAll()).object();
+    auto remoteManifest = QJsonDocument::fromJson(m_remoteManifest).object();
+    auto localTiles = tileInfos(localManifest);
+    auto remoteTiles = tileInfos(remoteManifest);
+    m_tileURL = remoteManifest[u"tileURL"_qs].toString();
+    if (localTiles.isEmpty() || remoteTiles.isEmpty() || m_tileURL.isEmpty())
+    {
+        fail();
+        return;
+    }
+    auto metaData = remoteManifest[u"metadata"_qs].toObject();
+    for (auto it = metaData.constBegin(); it != metaData.constEnd(); ++it)
+    {
+        m_metaData.insert(it.key(), it.value().toString());
+    }
+
+    // Compare manifests
+    qint64 fullSize = 0;
+    for (auto it = remoteTiles.constBegin(); it != remoteTiles.constEnd(); ++it)
+    {
+        fullSize += it->size;
+        auto localTile = localTiles.constFind(it.key());
+        if ((localTile != localTiles.constEnd()) && (localTile->hash == it->hash))
+        {
+            continue;
+        }
+        m_changedTiles.insert(it.key(), it.value());
+        m_deltaSize += it->size;
+    }
+    for (auto it = localTiles.constBegin(); it != localTiles.constEnd(); ++it)
+    {
+        if (!remoteTiles.contains(it.key()))
+        {
+            m_removedTiles.append(it.key());
+        }
+    }
+
+    // If the delta is large, then a full download is cheaper
+    auto referenceSize = (m_remoteFileSize > 0) ? m_remoteFileSize : fullSize;
+    if (static_cast<double>(m_deltaSize) > maxDeltaFraction*static_cast<double>(referenceSize))
+    {
+        fail();
+        return;
+    }
+
+    if (!m_stagingFile.open())
+    {
+        fail();
+        return;
+    }
+    m_requestQueue = m_changedTiles.keys();
+    sendRequests();
+}
+
+
+void DataManagement::TileDeltaUpdate::sendRequests()
+{
+    if (m_failed)
+    {
+        return;
+    }
+
+    while (!m_requestQueue.isEmpty() && (m_tileReplies.size() < maxRequestsInFlight))
+    {
+        auto key = m_requestQueue.takeLast();
+        auto parts = key.split(u'/');
+        if (parts.size() != 3)
+        {
+            fail();
+            return;
+        }
+        auto tileURL = m_tileURL;
+        tileURL.replace(u"{z}"_qs, parts[0]).replace(u"{x}"_qs, parts[1]).replace(u"{y}"_qs, parts[2]);
+
+        auto* reply = GlobalObject::networkAccessManager()->get(QNetworkRequest(manifestURL(m_url).resolved(QUrl(tileURL))));
+        m_tileReplies.append(reply);
+        connect(reply, &QNetworkReply::finished, this, [this, reply, key]() { tileFinished(reply, key); });
+    }
+
+    if (m_requestQueue.isEmpty() && m_tileReplies.isEmpty())
+    {
+        emit readyToApply();
+    }
+}
+
+
+void DataManagement::TileDeltaUpdate::tileFinished(QNetworkReply* reply, const QString& key)
+{
+    m_tileReplies.removeAll(reply);
+    reply->deleteLater();
+    if (m_failed)
+    {
+        return;
+    }
+    if (reply->error() != QNetworkReply::NoError)
+    {
+        fail();
+        return;
+    }
+
+    // Check the data against the manifest
+    auto data = reply->readAll();
+    auto hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+    if (hash != m_changedTiles.value(key).hash)
+    {
+        fail();
+        return;
+    }
+
+    // Stage the data
+    StagedTile stagedTile;
+    stagedTile.offset = m_stagingFile.size();
+    stagedTile.size = data.size();
+    m_stagingFile.seek(stagedTile.offset);
+    if (m_stagingFile.write(data) != data.size())
+    {
+        fail();
+        return;
+    }
+    m_stagedTiles.insert(key, stagedTile);
+
+    // Update progress
+    m_bytesStaged += data.size();
+    auto oldDownloadProgress = m_downloadProgress;
+    if (m_deltaSize > 0)
+    {
+        m_downloadProgress = qBound(0, qRound((100.0*static_cast<double>(m_bytesStaged))/static_cast<double>(m_deltaSize)), 100);
+    }
+    if (m_downloadProgress != oldDownloadProgress)
+    {
+        emit downloadProgressChanged(m_downloadProgress);
+    }
+
+    sendRequests();
+}
+
+
+auto DataManagement::TileDeltaUpdate::tileInfos(const QJsonObject& manifest) -> QHash<QString, TileInfo>
+{
+    QHash<QString, TileInfo> result;
+    auto tiles = manifest[u"tiles"_qs].toObject();
+    result.reserve(tiles.size());
+    for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it)
+    {
+        auto array = it.value().toArray();
+        TileInfo info;
+        info.hash = array.at(0).toString().toLatin1().toLower();
+        info.size = array.at(1).toInteger();
+        result.insert(it.key(), info);
+    }
+    return result;
+}
@@ -0,0 +1,260 @@
+/***************************************************************************
+ *   Copyright (C) 2019-2024 by Stefan Kebekus                             *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTemporaryFile>
+
+namespace DataManagement
+{
+
+/*! \brief Delta update of an MBTILES file
+ *
+ *  This class updates a local MBTILES file by downloading only those tiles
+ *  that have changed on the server. It relies on a tile manifest that the
+ *  server publishes next to every MBTILES file, at the URL of the file with
+ *  ".manifest" appended. The manifest is a JSON document of the following
+ *  form.
+ *
+ *  @code
+ *  {
+ *    "tileURL": "tiles/{z}/{x}/{y}",
+ *    "metadata": { "name": "…", … },
+ *    "tiles": { "7/68/42": ["<SHA-1 of tile data, hex>", <size in bytes>], … }
+ *  }
+ *  @endcode
+ *
+ *  The tileURL is resolved relative to the URL of the manifest. A copy of the
+ *  manifest describing the local file is kept at localManifestFileName(). An
+ *  update runs as follows.
+ *
+ *  -# The remote manifest is downloaded and compared to the local copy.
+ *
+ *  -# If there is no local manifest, or if the changed tiles are larger than
+ *     maxDeltaFraction times the size of the full file, the signal failed() is
+ *     emitted and the caller is expected to download the full file instead.
+ *
+ *  -# Changed tiles are downloaded, a few at a time. Tile data is checked
+ *     against the manifest and staged in a temporary file. The signal
+ *     downloadProgressChanged() is emitted regularly.
+ *
+ *  -# The signal readyToApply() is emitted. The caller should then make sure
+ *     that nobody uses the local file and call apply(), which writes all
+ *     changes into the local file in one SQLite transaction, in a background
+ *     thread.
+ *
+ *  Deleting the object stops the update.
+ */
+
+class TileDeltaUpdate : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*! \brief Standard constructor
+     *
+     *  @param url URL of the remote MBTILES file
+     *
+     *  @param fileName Name of the local MBTILES file
+     *
+     *  @param remoteFileSize Size of the remote MBTILES file, or -1 if unknown
+     *
+     *  @param parent The standard QObject parent pointer.
+     */
+    explicit TileDeltaUpdate(const QUrl& url, QString fileName, qint64 remoteFileSize, QObject* parent = nullptr);
+
+    /*! \brief Standard destructor
+     *
+     *  The destructor stops all running downloads.
+     */
+    ~TileDeltaUpdate() override;
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Write the changes into the local file
+     *
+     *  This method must only be called after readyToApply() has been emitted.
+     *  The changes are written in a background thread, while a QLockFile at
+     *  the name of the local file with ".lock" appended is held. On success,
+     *  the local manifest is updated and the modification time of the local
+     *  file is set to the current time. The destructor waits for the
+     *  background thread to finish.
+     *
+     *  @returns A future holding an empty string on success, or a
+     *  human-readable, translated error message
+     */
+    [[nodiscard]] auto apply() -> QFuture<QString>;
+
+    /*! \brief Number of bytes received
+     *
+     *  @returns Number of bytes of tile data that have been downloaded and
+     *  staged so far
+     */
+    [[nodiscard]] auto bytesReceived() const -> qint64 { return m_bytesStaged; }
+
+    /*! \brief Check if a delta update can be attempted
+     *
+     *  @param fileName Name of a local file
+     *
+     *  @returns True if the local file is an MBTILES file for which a local
+     *  manifest exists
+     */
+    [[nodiscard]] static auto canUpdate(const QString& fileName) -> bool;
+
+    /*! \brief Download the manifest of a remote MBTILES file
+     *
+     *  This method downloads the manifest that describes the remote file and
+     *  stores it at localManifestFileName(). It should be called once the full
+     *  file has been downloaded. The method runs asynchronously and fails
+     *  silently if the server does not publish a manifest.
+     *
+     *  @param url URL of the remote MBTILES file
+     *
+     *  @param fileName Name of the local MBTILES file
+     *
+     *  @param context Object that owns the network request
+     */
+    static void downloadManifest(const QUrl& url, const QString& fileName, QObject* context);
+
+    /*! \brief Name of the local manifest
+     *
+     *  @param fileName Name of the local MBTILES file
+     *
+     *  @returns Name of the file that holds the manifest of the local file
+     */
+    [[nodiscard]] static auto localManifestFileName(const QString& fileName) -> QString { return fileName + u".manifest"_qs; }
+
+    /*! \brief Start the update */
+    void start();
+
+signals:
+    /*! \brief Download progress
+     *
+     * @param percentage An integer between 0 and 100
+     */
+    void downloadProgressChanged(int percentage);
+
+    /*! \brief Delta update not possible
+     *
+     *  This signal is emitted if the delta update cannot be completed, for
+     *  instance because the server does not publish a manifest, because the
+     *  delta is too large, or because of network errors. The local file is
+     *  unchanged.
+     */
+    void failed();
+
+    /*! \brief All changed tiles have been downloaded
+     *
+     *  @see apply()
+     */
+    void readyToApply();
+
+private:
+    Q_DISABLE_COPY_MOVE(TileDeltaUpdate)
+
+    // If the changed tiles are larger than this fraction of the full file, a
+    // delta update is not worth the effort
+    static constexpr double maxDeltaFraction = 0.5;
+
+    // Maximal number of tile requests that run at the same time
+    static constexpr int maxRequestsInFlight = 4;
+
+    // Emits failed() once and stops all network activity
+    void fail();
+
+    // Called once the remote manifest has been downloaded. Compares remote and
+    // local manifest and starts downloading tiles.
+    void manifestFinished();
+
+    // Sends tile requests until maxRequestsInFlight requests are running.
+    // Emits readyToApply() once all tiles have been staged.
+    void sendRequests();
+
+    // Called once a tile has been downloaded. Checks and stages the data.
+    void tileFinished(QNetworkReply* reply, const QString& key);
+
+    // Information about one tile, as given in a manifest
+    struct TileInfo
+    {
+        QByteArray hash;
+        qint64 size {0};
+    };
+
+    // Location of staged tile data in m_stagingFile
+    struct StagedTile
+    {
+        qint64 offset {0};
+        qint64 size {0};
+    };
+
+    // Reads the tiles of a manifest
+    static auto tileInfos(const QJsonObject& manifest) -> QHash<QString, TileInfo>;
+
+    // Construction data
+    QUrl m_url;
+    QString m_fileName;
+    qint64 m_remoteFileSize {-1};
+
+    // Remote manifest, as downloaded from the server
+    QByteArray m_remoteManifest;
+
+    // Metadata of the remote file
+    QMap<QString, QString> m_metaData;
+
+    // Template of tile URLs, with placeholders {z}, {x} and {y}
+    QString m_tileURL;
+
+    // Changed tiles, and tiles that exist locally but no longer on the server
+    QHash<QString, TileInfo> m_changedTiles;
+    QStringList m_removedTiles;
+
+    // Tiles that still need to be requested
+    QStringList m_requestQueue;
+
+    // Running network requests
+    QPointer<QNetworkReply> m_manifestReply;
+    QList<QPointer<QNetworkReply>> m_tileReplies;
+
+    // Staged tile data
+    QTemporaryFile m_stagingFile;
+    QHash<QString, StagedTile> m_stagedTiles;
+
+    // Progress
+    qint64 m_deltaSize {0};
+    qint64 m_bytesStaged {0};
+    int m_downloadProgress {0};
+
+    // Set once failed() has been emitted
+    bool m_failed {false};
+
+    // Future of the background thread started by apply()
+    QFuture<QString> m_applying;
+};
+
+} // namespace DataManagement
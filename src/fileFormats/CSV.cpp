@@ -128,7 +128,7 @@ QStringList FileFormats::CSV::parseCSV(const QString& string)
 
 FileFormats::CSV::CSV(const QString& fileName)
 {
-    auto file = FileFormats::DataFileAbstract::openFileURL(fileName);
+    auto file = FileFormats::DataFileAbstract::openSequentialFileURL(fileName);
     auto success = file->open(QIODevice::ReadOnly);
     if (!success)
     {
@@ -22,14 +22,63 @@
 
 #include "fileFormats/DataFileAbstract.h"
 
-QSharedPointer<QFile> FileFormats::DataFileAbstract::openFileURL(const QString& fileName)
+namespace {
+
+// Size of the chunks used when copying files
+constexpr qint64 chunkSize = 1024*1024;
+
+// Copies all data from source to destination, chunk by chunk. Both devices
+// must be open. Returns false on error, or if progress returns false.
+bool copyData(QIODevice& source, QIODevice& destination, const FileFormats::DataFileAbstract::ProgressCallback& progress = {})
 {
-    if (fileName.startsWith(u"file://"_qs))
+    QByteArray buffer(chunkSize, Qt::Uninitialized);
+    auto bytesTotal = source.isSequential() ? 0 : source.size();
+    qint64 bytesCopied = 0;
+    while(true)
     {
-        auto* file = new QFile(fileName.mid(7));
-        return QSharedPointer<QFile>(file);
+        auto bytesRead = source.read(buffer.data(), chunkSize);
+        if (bytesRead < 0)
+        {
+            return false;
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        if (destination.write(buffer.constData(), bytesRead) != bytesRead)
+        {
+            return false;
+        }
+        bytesCopied += bytesRead;
+        if (progress && !progress(bytesCopied, bytesTotal))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+bool FileFormats::DataFileAbstract::copyFileURL(const QString& fileName, const QString& newFileName, const ProgressCallback& progress)
+{
+    auto source = openSequentialFileURL(fileName);
+    QFile destination(newFileName);
+    auto success = source->open(QIODeviceBase::ReadOnly) &&
+                   destination.open(QIODeviceBase::WriteOnly|QIODeviceBase::Truncate) &&
+                   copyData(*source, destination, progress);
+    destination.close();
+    if (!success)
+    {
+        QFile::remove(newFileName);
     }
+    return success;
+}
 
+
+QSharedPointer<QFile> FileFormats::DataFileAbstract::openFileURL(const QString& fileName)
+{
     if (fileName.startsWith(u"content://"_qs))
     {
         auto* file = new QTemporaryFile();
@@ -37,12 +86,24 @@ QSharedPointer<QFile> FileFormats::DataFileAbstract::openFileURL(const QString&
 
         QFile contentFile(fileName);
         contentFile.open(QIODeviceBase::ReadOnly);
-        auto buffer = contentFile.readAll();
-        file->write(buffer);
+        copyData(contentFile, *file);
         file->close();
         return QSharedPointer<QFile>(file);
     }
 
+    return openSequentialFileURL(fileName);
+}
+
+
+QSharedPointer<QFile> FileFormats::DataFileAbstract::openSequentialFileURL(const QString& fileName)
+{
+    if (fileName.startsWith(u"file://"_qs))
+    {
+        auto* file = new QFile(fileName.mid(7));
+        return QSharedPointer<QFile>(file);
+    }
+
+    // Android content URLs can be read directly by QFile
     auto *file = new QFile(fileName);
     return QSharedPointer<QFile>(file);
 }
@@ -23,6 +23,7 @@
 #include <QFile>
 #include <QObject>
 #include <QSharedPointer>
+#include <functional>
 
 namespace FileFormats
 {
@@ -89,10 +90,37 @@ public:
     // Methods
     //
 
+    /*! \brief Progress callback for copyFileURL()
+     *
+     *  The callback is called after every chunk, with the number of bytes
+     *  copied so far and the size of the source, which is 0 if the size is
+     *  not known. If the callback returns false, copying is canceled.
+     */
+    using ProgressCallback = std::function<bool(qint64 bytesCopied, qint64 bytesTotal)>;
+
+    /*! \brief Copy file, file URL or Android content URL
+     *
+     *  This method copies data from a file, file URL or Android content URL
+     *  to a local file, in chunks of fixed size, so that the file never needs
+     *  to be held in memory. The method can be called from any thread.
+     *
+     *  @param fileName A file name, a file URL or an Android content URL
+     *
+     *  @param newFileName Name of the local file that is created. An existing
+     *  file of that name is overwritten.
+     *
+     *  @param progress Optional callback that reports progress and allows
+     *  canceling
+     *
+     *  @returns True on success. On failure or cancellation, newFileName is
+     *  removed.
+     */
+    static bool copyFileURL(const QString& fileName, const QString& newFileName, const ProgressCallback& progress = {});
+
     /*! \brief Open file, file URL or Android content URL
      *
      *  This method opens a file. It handles file URLs and Android content URLs. The
-     *  latter are downloaded to a temporary file.
+     *  latter are copied to a temporary file, using copyFileURL().
      *
      *  @param fileName A file name, a file URL or an Android content URL
      *
@@ -101,6 +129,19 @@ public:
      */
     [[nodiscard]] static QSharedPointer<QFile> openFileURL(const QString& fileName);
 
+    /*! \brief Open file, file URL or Android content URL for sequential reading
+     *
+     *  This method is similar to openFileURL(), but does not copy Android
+     *  content URLs to a temporary file. It should be used by readers that
+     *  read their input from beginning to end, without seeking.
+     *
+     *  @param fileName A file name, a file URL or an Android content URL
+     *
+     *  @returns A shared pointer to a file, which needs to be opened before
+     *  use. The file might be sequential.
+     */
+    [[nodiscard]] static QSharedPointer<QFile> openSequentialFileURL(const QString& fileName);
+
 protected:
     void addWarning(const QString& warning) { m_warnings += warning; }
     void setError(const QString& newError) { m_error = newError; }
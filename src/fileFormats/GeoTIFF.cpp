@@ -49,7 +49,7 @@ FileFormats::GeoTIFF::GeoTIFF(QIODevice& device)
 // Private Methods
 //
 
-QList<double> FileFormats::GeoTIFF::getTransformation(const QMap<quint16, QVariantList>& TIFFFields)
+QList<double> FileFormats::GeoTIFF::getTransformation(const QMap<quint16, FileFormats::TIFF::Field>& TIFFFields)
 {
     auto transformation = readTransformation(TIFFFields);
     if (transformation.size() == 16)
@@ -78,7 +78,7 @@ QList<double> FileFormats::GeoTIFF::getTransformation(const QMap<quint16, QVaria
     };
 }
 
-QList<FileFormats::GeoTIFF::Tiepoint> FileFormats::GeoTIFF::readTiepoints(const QMap<quint16, QVariantList>& TIFFFields)
+QList<FileFormats::GeoTIFF::Tiepoint> FileFormats::GeoTIFF::readTiepoints(const QMap<quint16, FileFormats::TIFF::Field>& TIFFFields)
 {
     // Handle Tag 33922, compute top left of the bounding box
     if (!TIFFFields.contains(33922))
@@ -93,24 +93,24 @@ QList<FileFormats::GeoTIFF::Tiepoint> FileFormats::GeoTIFF::readTiepoints(const
     for(auto numTiepoint = 0; numTiepoint < numTiepoints; numTiepoint++)
     {
         bool ok = false;
-        auto x  = TIFFFields.value(33922).at(0+6*numTiepoint).toDouble(&ok);
+        auto x  = values.toDouble(0+6*numTiepoint, &ok);
         if (!ok)
         {
             throw QObject::tr("Invalid data for tag 33922.", "FileFormats::GeoTIFF");
         }
-        auto y  = TIFFFields.value(33922).at(1+6*numTiepoint).toDouble(&ok);
+        auto y  = values.toDouble(1+6*numTiepoint, &ok);
         if (!ok)
         {
             throw QObject::tr("Invalid data for tag 33922.", "FileFormats::GeoTIFF");
         }
         QPointF const rasterPoint(x,y);
 
-        auto lat = TIFFFields.value(33922).at(4+6*numTiepoint).toDouble(&ok);
+        auto lat = values.toDouble(4+6*numTiepoint, &ok);
         if (!ok)
         {
             throw QObject::tr("Invalid data for tag 33922.", "FileFormats::GeoTIFF");
         }
-        auto lon = TIFFFields.value(33922).at(3+6*numTiepoint).toDouble(&ok);
+        auto lon = values.toDouble(3+6*numTiepoint, &ok);
         if (!ok)
         {
             throw QObject::tr("Invalid data for tag 33922.", "FileFormats::GeoTIFF");
@@ -126,7 +126,7 @@ QList<FileFormats::GeoTIFF::Tiepoint> FileFormats::GeoTIFF::readTiepoints(const
     return tiepoints;
 }
 
-QString FileFormats::GeoTIFF::readName(const QMap<quint16, QVariantList>& TIFFFields)
+QString FileFormats::GeoTIFF::readName(const QMap<quint16, FileFormats::TIFF::Field>& TIFFFields)
 {
     // Handle Tag 270, name
     if (!TIFFFields.contains(270))
@@ -139,10 +139,10 @@ QString FileFormats::GeoTIFF::readName(const QMap<quint16, QVariantList>& TIFFFi
     {
         throw QObject::tr("No data for tag 270.", "FileFormats::GeoTIFF");
     }
-    return values.constFirst().toString();
+    return values.toString();
 }
 
-QSizeF FileFormats::GeoTIFF::readPixelSize(const QMap<quint16, QVariantList> &TIFFFields)
+QSizeF FileFormats::GeoTIFF::readPixelSize(const QMap<quint16, FileFormats::TIFF::Field> &TIFFFields)
 {
     if (!TIFFFields.contains(33550)) {
         return {};
@@ -157,10 +157,10 @@ QSizeF FileFormats::GeoTIFF::readPixelSize(const QMap<quint16, QVariantList> &TI
 
     bool globalOK = true;
     bool ok = false;
-    auto pixelWidth = values.at(0).toDouble(&ok);
+    auto pixelWidth = values.toDouble(0, &ok);
     globalOK = globalOK && ok;
 
-    auto pixelHeight = values.at(1).toDouble(&ok);
+    auto pixelHeight = values.toDouble(1, &ok);
     globalOK = globalOK && ok;
 
     if (!globalOK)
@@ -171,7 +171,7 @@ QSizeF FileFormats::GeoTIFF::readPixelSize(const QMap<quint16, QVariantList> &TI
     return {qAbs(pixelWidth), qAbs(pixelHeight)};
 }
 
-QList<double> FileFormats::GeoTIFF::readTransformation(const QMap<quint16, QVariantList> &TIFFFields)
+QList<double> FileFormats::GeoTIFF::readTransformation(const QMap<quint16, FileFormats::TIFF::Field> &TIFFFields)
 {
     if (!TIFFFields.contains(34264)) {
         return {};
@@ -187,7 +187,7 @@ QList<double> FileFormats::GeoTIFF::readTransformation(const QMap<quint16, QVari
     for(int i=0; i<16; i++)
     {
         bool ok = false;
-        transformation[i] = values.at(i).toDouble(&ok);
+        transformation[i] = values.toDouble(i, &ok);
         globalOK = globalOK && ok;
     }
     if (!globalOK)
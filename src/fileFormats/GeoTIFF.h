@@ -22,7 +22,6 @@
 
 #include <QGeoRectangle>
 #include <QPointF>
-#include <QVariant>
 
 #include "TIFF.h"
 
@@ -129,7 +128,7 @@ private:
      *
      * 3. An empty list is returned.
      */
-    [[nodiscard]] static QList<double> getTransformation(const QMap<quint16, QVariantList> &TIFFFields);
+    [[nodiscard]] static QList<double> getTransformation(const QMap<quint16, FileFormats::TIFF::Field> &TIFFFields);
 
     /* This method interprets the TIFFFields and looks for the tag 33922, which is used to
      * specify the tiepoints.  Returns a list with the data retrieved, or an empty
@@ -137,7 +136,7 @@ private:
      *
      * An expection might be thrown if the tag exists, but contains invalid data.
      */
-    [[nodiscard]] static QList<Tiepoint> readTiepoints(const QMap<quint16, QVariantList> &TIFFFields);
+    [[nodiscard]] static QList<Tiepoint> readTiepoints(const QMap<quint16, FileFormats::TIFF::Field> &TIFFFields);
 
     /* This method interprets the TIFFFields and looks for the tag 270, which is used to
      * specify the image name.  Returns a QString with the data retrieved, or an empty
@@ -145,7 +144,7 @@ private:
      *
      * An expection might be thrown if the tag exists, but contains invalid data.
      */
-    [[nodiscard]] static QString readName(const QMap<quint16, QVariantList>& TIFFFields);
+    [[nodiscard]] static QString readName(const QMap<quint16, FileFormats::TIFF::Field>& TIFFFields);
 
     /* This method interprets the TIFFFields and looks for the tag 33550, which is used to
      * specify the geographic size of a pixel.  Returns a QSizeF with the data retrieved,
@@ -153,7 +152,7 @@ private:
      *
      * An expection might be thrown if the tag exists, but contains invalid data.
      */
-    [[nodiscard]] static QSizeF readPixelSize(const QMap<quint16, QVariantList> &TIFFFields);
+    [[nodiscard]] static QSizeF readPixelSize(const QMap<quint16, FileFormats::TIFF::Field> &TIFFFields);
 
     /* This method interprets the TIFFFields and looks for the tag 34264, which is used to
      * specify a 4x4 transformation matrix. Returns a list of 16 doubles on success, in order
@@ -161,7 +160,7 @@ private:
      *
      * An expection might be thrown if the tag exists, but contains invalid data.
      */
-    [[nodiscard]] static QList<double> readTransformation(const QMap<quint16, QVariantList> &TIFFFields);
+    [[nodiscard]] static QList<double> readTransformation(const QMap<quint16, FileFormats::TIFF::Field> &TIFFFields);
 
     /* This methods interprets the data found in m_TIFFFields and writes to
      * m_name and m_topLeft etc. On failure, it throws a QString with a human-readable,
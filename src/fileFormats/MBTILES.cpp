@@ -26,6 +26,35 @@
 #include "fileFormats/DataFileAbstract.h"
 #include "fileFormats/MBTILES.h"
 
+
+namespace {
+
+// Parses a tile key of the form "zoom/x/y" and returns zoom level, column and
+// row in the TMS scheme used in MBTILES. Returns false if the key is invalid.
+bool parseTileKey(const QString& key, int& zoom, int& column, int& row)
+{
+    auto parts = key.split(u'/');
+    if (parts.size() != 3)
+    {
+        return false;
+    }
+    bool okZoom = false;
+    bool okX = false;
+    bool okY = false;
+    zoom = parts[0].toInt(&okZoom);
+    column = parts[1].toInt(&okX);
+    auto y = parts[2].toInt(&okY);
+    if (!okZoom || !okX || !okY || (zoom < 0) || (zoom > 30))
+    {
+        return false;
+    }
+    row = (1<<zoom)-1-y;
+    return true;
+}
+
+} // namespace
+
+
 FileFormats::MBTILES::MBTILES(const QString& fileName)
     : m_fileName(fileName)
 {
@@ -164,3 +193,150 @@ auto FileFormats::MBTILES::tile(int zoom, int x, int y) -> QByteArray
 
     return {};
 }
+
+
+auto FileFormats::MBTILES::createFile(const QString& fileName) -> QString
+{
+    QFile::remove(fileName);
+
+    auto databaseConnectionName = QStringLiteral("GeoMaps::MBTILES::createFile %1,%2").arg(fileName).arg(QRandomGenerator::global()->generate());
+    QString result;
+    {
+        auto dataBase = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), databaseConnectionName);
+        dataBase.setDatabaseName(fileName);
+        result = [&]() -> QString
+        {
+            if (!dataBase.open())
+            {
+                return QObject::tr("Unable to open database connection to MBTILES file.", "FileFormats::MBTILES");
+            }
+
+            QSqlQuery query(dataBase);
+            if (!query.exec(QStringLiteral("create table metadata (name text, value text);")) ||
+                !query.exec(QStringLiteral("create table tiles (zoom_level integer, tile_column integer, tile_row integer, tile_data blob);")) ||
+                !query.exec(QStringLiteral("create unique index tile_index on tiles (zoom_level, tile_column, tile_row);")))
+            {
+                return QObject::tr("Unable to create MBTILES file.", "FileFormats::MBTILES");
+            }
+            return {};
+        }();
+        dataBase.close();
+    }
+    QSqlDatabase::removeDatabase(databaseConnectionName);
+    if (!result.isEmpty())
+    {
+        QFile::remove(fileName);
+    }
+    return result;
+}
+
+
+auto FileFormats::MBTILES::writeTiles(const QString& fileName,
+                                      const QStringList& tileKeys,
+                                      const std::function<std::optional<QByteArray>(const QString&)>& tileData,
+                                      const QStringList& removedTileKeys,
+                                      const QMap<QString, QString>& metaData) -> QString
+{
+    auto databaseConnectionName = QStringLiteral("GeoMaps::MBTILES::writeTiles %1,%2").arg(fileName).arg(QRandomGenerator::global()->generate());
+    QString result;
+    {
+        auto dataBase = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), databaseConnectionName);
+        dataBase.setDatabaseName(fileName);
+        result = [&]() -> QString
+        {
+            if (!dataBase.open())
+            {
+                return QObject::tr("Unable to open database connection to MBTILES file.", "FileFormats::MBTILES");
+            }
+
+            // Tiles can only be written if "tiles" is a table
+            QSqlQuery query(dataBase);
+            if (!query.exec(QStringLiteral("select type from sqlite_master where name='tiles';")) ||
+                !query.first() || (query.value(0).toString() != u"table"_qs))
+            {
+                return QObject::tr("The MBTILES file cannot be modified.", "FileFormats::MBTILES");
+            }
+
+            if (!dataBase.transaction())
+            {
+                return QObject::tr("Unable to modify MBTILES file.", "FileFormats::MBTILES");
+            }
+
+            QSqlQuery deleteTile(dataBase);
+            deleteTile.prepare(QStringLiteral("delete from tiles where zoom_level=? and tile_column=? and tile_row=?;"));
+            QSqlQuery insertTile(dataBase);
+            insertTile.prepare(QStringLiteral("insert into tiles (zoom_level, tile_column, tile_row, tile_data) values (?, ?, ?, ?);"));
+            QSqlQuery deleteMetaData(dataBase);
+            deleteMetaData.prepare(QStringLiteral("delete from metadata where name=?;"));
+            QSqlQuery insertMetaData(dataBase);
+            insertMetaData.prepare(QStringLiteral("insert into metadata (name, value) values (?, ?);"));
+
+            // Delete a tile. Tiles are deleted before they are inserted, so
+            // that the method does not depend on a unique index.
+            auto remove = [&](const QString& key, int& zoom, int& column, int& row)
+            {
+                if (!parseTileKey(key, zoom, column, row))
+                {
+                    return false;
+                }
+                deleteTile.addBindValue(zoom);
+                deleteTile.addBindValue(column);
+                deleteTile.addBindValue(row);
+                return deleteTile.exec();
+            };
+
+            bool success = true;
+            int zoom = 0;
+            int column = 0;
+            int row = 0;
+            foreach(auto key, removedTileKeys)
+            {
+                success = success && remove(key, zoom, column, row);
+            }
+            foreach(auto key, tileKeys)
+            {
+                if (!success)
+                {
+                    break;
+                }
+                auto data = tileData(key);
+                if (!data.has_value())
+                {
+                    success = false;
+                    break;
+                }
+                success = remove(key, zoom, column, row);
+                if (!success)
+                {
+                    break;
+                }
+                insertTile.addBindValue(zoom);
+                insertTile.addBindValue(column);
+                insertTile.addBindValue(row);
+                insertTile.addBindValue(data.value());
+                success = insertTile.exec();
+            }
+            for (auto [name, value] : metaData.asKeyValueRange())
+            {
+                if (!success)
+                {
+                    break;
+                }
+                deleteMetaData.addBindValue(name);
+                insertMetaData.addBindValue(name);
+                insertMetaData.addBindValue(value);
+                success = deleteMetaData.exec() && insertMetaData.exec();
+            }
+
+            if (!success || !dataBase.commit())
+            {
+                dataBase.rollback();
+                return QObject::tr("Unable to modify MBTILES file.", "FileFormats::MBTILES");
+            }
+            return {};
+        }();
+        dataBase.close();
+    }
+    QSqlDatabase::removeDatabase(databaseConnectionName);
+    return result;
+}
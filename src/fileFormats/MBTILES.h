@@ -22,6 +22,8 @@
 
 #include <QFile>
 #include <QMap>
+#include <functional>
+#include <optional>
 #include <QObject>
 #include <QSharedPointer>
 
@@ -121,6 +123,56 @@ namespace FileFormats
       return m_fileName;
     }
 
+    /*! \brief Create an empty MBTILES file
+     *
+     *  This method creates a new MBTILES file with empty tables "metadata" and
+     *  "tiles". An existing file of the same name is overwritten. Use the
+     *  method writeTiles() to fill the file with data.
+     *
+     *  @param fileName Name of the MBTILES file
+     *
+     *  @returns An empty string on success, or a human-readable, translated
+     *  error message
+     */
+    [[nodiscard]] static QString createFile(const QString& fileName);
+
+    /*! \brief Modify tiles of an existing MBTILES file
+     *
+     *  This method adds, replaces and removes tiles of an MBTILES file and
+     *  updates its metadata. All changes are made in one SQLite transaction, so
+     *  that the file is either updated completely or left unchanged.
+     *
+     *  Tiles are specified by keys of the form "zoom/x/y", where the
+     *  coordinates are interpreted as in the method tile().
+     *
+     *  @note MBTILES files where "tiles" is a view rather than a table cannot
+     *  be modified, and the method fails.
+     *
+     *  @param fileName Name of a local MBTILES file
+     *
+     *  @param tileKeys Keys of tiles that are added or replaced
+     *
+     *  @param tileData Function that returns the data for a given tile key.
+     *  The function is called exactly once for every key in tileKeys, so that
+     *  the data need not be held in memory all at once. If the function
+     *  returns std::nullopt, for instance because the data cannot be read,
+     *  then the transaction is aborted, the file is left unchanged and the
+     *  method fails.
+     *
+     *  @param removedTileKeys Keys of tiles that are removed. Tiles are
+     *  removed only if listed here.
+     *
+     *  @param metaData Metadata entries that are added or replaced
+     *
+     *  @returns An empty string on success, or a human-readable, translated
+     *  error message
+     */
+    [[nodiscard]] static QString writeTiles(const QString& fileName,
+                                            const QStringList& tileKeys,
+                                            const std::function<std::optional<QByteArray>(const QString&)>& tileData,
+                                            const QStringList& removedTileKeys,
+                                            const QMap<QString, QString>& metaData);
+
   private:
     //
     Q_DISABLE_COPY_MOVE(MBTILES)
@@ -18,7 +18,11 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <QBuffer>
 #include <QFile>
+#include <QtEndian>
+#include <bit>
+#include <cmath>
 
 #include "TIFF.h"
 #include "fileFormats/DataFileAbstract.h"
@@ -48,24 +52,54 @@ enum DataType {
 
 namespace {
 
-// Checks the status of dataStream. If status is OK, this method does nothing.
-// Otherwiese, it throws a QString with a human-readable, translated error
-// message.
-void checkForError(QDataStream &dataStream)
+// Size of a single value of the given data type, in bytes, or 0 if the type
+// is unknown
+qsizetype typeSize(quint16 type)
 {
-    switch(dataStream.status())
+    switch(type)
     {
-    case QDataStream::ReadCorruptData:
-        throw QObject::tr("Found corrupt data while reading the data stream.", "FileFormats::TIFF");
-    case QDataStream::ReadPastEnd:
-        throw QObject::tr("Read past end of data stream.", "FileFormats::TIFF");
-    case QDataStream::WriteFailed:
-        throw QObject::tr("Error writing to data stream.", "FileFormats::TIFF");
-    case QDataStream::Ok:
-        break;
+    case DT_Byte:
+    case DT_SByte:
+    case DT_Ascii:
+    case DT_Undefined:
+        return 1;
+
+    case DT_Short:
+    case DT_SShort:
+        return 2;
+
+    case DT_Long:
+    case DT_SLong:
+    case DT_Ifd:
+    case DT_Float:
+        return 4;
+
+    case DT_Rational:
+    case DT_SRational:
+    case DT_Long8:
+    case DT_SLong8:
+    case DT_Ifd8:
+    case DT_Double:
+        return 8;
+
+    default:
+        return 0;
     }
 }
 
+// Reads an unsigned integer of type T from data, in the given byte order
+template<typename T>
+T readUInt(const uchar* data, bool bigEndian)
+{
+    return bigEndian ? qFromBigEndian<T>(data) : qFromLittleEndian<T>(data);
+}
+
+// Reads an unsigned integer of 4 or 8 bytes, depending on 'size'
+quint64 readOffset(const uchar* data, qsizetype size, bool bigEndian)
+{
+    return (size == 8) ? readUInt<quint64>(data, bigEndian) : readUInt<quint32>(data, bigEndian);
+}
+
 } // namespace
 
 
@@ -76,216 +110,298 @@ void checkForError(QDataStream &dataStream)
 
 FileFormats::TIFF::TIFF(const QString& fileName)
 {
-    auto inFile = FileFormats::DataFileAbstract::openFileURL(fileName);
-    if (!inFile->open(QFile::ReadOnly))
+    try
     {
-        setError(inFile->errorString());
-        return;
+        m_file = FileFormats::DataFileAbstract::openFileURL(fileName);
+        if (!m_file->open(QFile::ReadOnly))
+        {
+            throw m_file->errorString();
+        }
+        mapDevice(*m_file);
+        readTIFFData();
+    }
+    catch (QString& message)
+    {
+        setError(message);
     }
-
-    readTIFFData(*inFile.data());
 }
 
 FileFormats::TIFF::TIFF(QIODevice& device)
 {
-    readTIFFData(device);
+    try
+    {
+        mapDevice(device);
+        readTIFFData();
+    }
+    catch (QString& message)
+    {
+        setError(message);
+    }
 }
 
 
 
 //
-// Private Methods
+// Field methods
 //
 
-void FileFormats::TIFF::readTIFFData(QIODevice& device)
+quint64 FileFormats::TIFF::Field::toUInt(qsizetype index, bool* ok) const
 {
-    QDataStream dataStream(&device);
-
-    try
+    if (ok != nullptr)
     {
-        // Move to beginning of the data stream
-        if (!device.seek(0))
-        {
-            throw device.errorString();
-        }
-
-        // Check magic bytes
-        auto magicBytes = device.read(2);
-        if (magicBytes == "II")
-        {
-            dataStream.setByteOrder(QDataStream::LittleEndian);
-        }
-        else if (magicBytes == "MM")
-        {
-            dataStream.setByteOrder(QDataStream::BigEndian);
-        }
-        else
-        {
-            throw QObject::tr("Found invalid TIFF file data.", "FileFormats::TIFF");
-        }
-
-        // version
-        quint16 version = 0;
-        dataStream >> version;
-        if (version == 43)
-        {
-            throw QObject::tr("BigTIFF files are not supported.", "FileFormats::TIFF");
-        }
-        if (version != 42)
-        {
-            throw QObject::tr("Found an unsupported TIFF version.", "FileFormats::TIFF");
-        }
-
-        // ifd0Offset
-        quint32 result = 0;
-        dataStream >> result;
-        checkForError(dataStream);
-        if (!device.seek(result))
-        {
-            throw device.errorString();
-        }
-
-        quint16 tagCount = 0;
-        dataStream >> tagCount;
-        checkForError(dataStream);
-        if (tagCount > 100)
-        {
-            addWarning( QObject::tr("Found more than 100 tags in the TIFF file. Reading only the first 100.", "FileFormats::TIFF") );
-            tagCount = 100;
-        }
-
-        for (quint16 i=0; i<tagCount; ++i)
-        {
-            readTIFFField(device, dataStream);
-        }
+        *ok = false;
+    }
+    if ((index < 0) || (index >= m_count))
+    {
+        return 0;
+    }
 
-        readRasterSize();
+    quint64 result = 0;
+    switch(m_type)
+    {
+    case DT_Byte:
+        result = m_data[index];
+        break;
+    case DT_Short:
+        result = readUInt<quint16>(m_data.data() + 2*index, m_bigEndian);
+        break;
+    case DT_Long:
+    case DT_Ifd:
+        result = readUInt<quint32>(m_data.data() + 4*index, m_bigEndian);
+        break;
+    case DT_Long8:
+    case DT_Ifd8:
+        result = readUInt<quint64>(m_data.data() + 8*index, m_bigEndian);
+        break;
+    default:
+        return 0;
     }
-    catch (QString& message)
+
+    if (ok != nullptr)
     {
-        setError(message);
+        *ok = true;
     }
+    return result;
 }
 
-
-void FileFormats::TIFF::readTIFFField(QIODevice& device, QDataStream& dataStream)
+double FileFormats::TIFF::Field::toDouble(qsizetype index, bool* ok) const
 {
-    // Read tag, type, and count
-    quint16 tag = 0;
-    quint16 type = DT_Undefined;
-    quint32 count = 0;
-    dataStream >> tag;
-    dataStream >> type;
-    dataStream >> count;
-    checkForError(dataStream);
-
-    // Compute the data size of this type
-    int typeSize = 0;
-    switch(type)
+    if (ok != nullptr)
+    {
+        *ok = false;
+    }
+    if ((index < 0) || (index >= m_count))
+    {
+        return NAN;
+    }
+
+    double result = NAN;
+    const auto* data = m_data.data();
+    switch(m_type)
     {
     case DT_Byte:
+    case DT_Short:
+    case DT_Long:
+    case DT_Long8:
+        result = static_cast<double>(toUInt(index));
+        break;
     case DT_SByte:
-    case DT_Ascii:
-    case DT_Undefined:
-        typeSize = 1;
+        result = static_cast<qint8>(data[index]);
         break;
-
-    case DT_Short:
     case DT_SShort:
-        typeSize = 2;
+        result = static_cast<qint16>(readUInt<quint16>(data + 2*index, m_bigEndian));
         break;
-
-    case DT_Long:
     case DT_SLong:
-    case DT_Ifd:
-    case DT_Float:
-        typeSize = 4;
+        result = static_cast<qint32>(readUInt<quint32>(data + 4*index, m_bigEndian));
+        break;
+    case DT_SLong8:
+        result = static_cast<double>(static_cast<qint64>(readUInt<quint64>(data + 8*index, m_bigEndian)));
         break;
-
     case DT_Rational:
+        result = double(readUInt<quint32>(data + 8*index, m_bigEndian))
+                 / double(readUInt<quint32>(data + 8*index + 4, m_bigEndian));
+        break;
     case DT_SRational:
-    case DT_Long8:
-    case DT_SLong8:
-    case DT_Ifd8:
+        result = double(static_cast<qint32>(readUInt<quint32>(data + 8*index, m_bigEndian)))
+                 / double(static_cast<qint32>(readUInt<quint32>(data + 8*index + 4, m_bigEndian)));
+        break;
+    case DT_Float:
+        result = std::bit_cast<float>(readUInt<quint32>(data + 4*index, m_bigEndian));
+        break;
     case DT_Double:
-        typeSize = 8;
+        result = std::bit_cast<double>(readUInt<quint64>(data + 8*index, m_bigEndian));
         break;
-
     default:
-        typeSize = 0;
-        break;
+        return NAN;
     }
 
-    // Save file position and move to the position where the data actually
-    // resides.
-    auto filePos = device.pos();
-    auto byteSize = typeSize*count;
-    if (byteSize > 4)
+    if (ok != nullptr)
     {
-        quint32 newPos = 0;
-        dataStream >> newPos;
-        checkForError(dataStream);
-        if (!device.seek(newPos))
+        *ok = std::isfinite(result);
+    }
+    return result;
+}
+
+QString FileFormats::TIFF::Field::toString() const
+{
+    if (m_type != DT_Ascii)
+    {
+        return {};
+    }
+    const auto* begin = reinterpret_cast<const char*>(m_data.data());
+    return QString::fromLatin1(begin, qstrnlen(begin, m_data.size()));
+}
+
+
+
+//
+// Private Methods
+//
+
+void FileFormats::TIFF::mapDevice(QIODevice& device)
+{
+    // Files are mapped into memory
+    auto* fileDevice = qobject_cast<QFileDevice*>(&device);
+    if (fileDevice != nullptr)
+    {
+        auto size = fileDevice->size();
+        const auto* data = (size > 0) ? fileDevice->map(0, size) : nullptr;
+        if (data != nullptr)
         {
-            throw device.errorString();
+            m_data = {data, static_cast<size_t>(size)};
+            return;
         }
     }
 
-    // Read data entries from the device
-    QVariantList values;
-    switch (type)
+    // Buffers are read in place
+    auto* buffer = qobject_cast<QBuffer*>(&device);
+    if (buffer != nullptr)
     {
-    case DT_Ascii:
+        m_buffer = buffer->data();
+    }
+    else
     {
-        auto tmpString = device.read(count);
-        if (tmpString.size() != count)
+        if (device.isSequential() || !device.seek(0))
         {
             throw QObject::tr("Cannot read data.", "FileFormats::TIFF");
         }
-        foreach(auto subStrings, tmpString.split(0))
+        m_buffer = device.readAll();
+    }
+    m_data = {reinterpret_cast<const uchar*>(m_buffer.constData()), static_cast<size_t>(m_buffer.size())};
+}
+
+
+void FileFormats::TIFF::readTIFFData()
+{
+    const auto* data = m_data.data();
+    auto size = static_cast<quint64>(m_data.size());
+    if (size < 8)
+    {
+        throw QObject::tr("Found invalid TIFF file data.", "FileFormats::TIFF");
+    }
+
+    // Check magic bytes
+    bool bigEndian = false;
+    if ((data[0] == 'I') && (data[1] == 'I'))
+    {
+        bigEndian = false;
+    }
+    else if ((data[0] == 'M') && (data[1] == 'M'))
+    {
+        bigEndian = true;
+    }
+    else
+    {
+        throw QObject::tr("Found invalid TIFF file data.", "FileFormats::TIFF");
+    }
+
+    // Version. Classic TIFF files use 32-bit offsets and 12-byte directory
+    // entries, BigTIFF files use 64-bit offsets and 20-byte entries.
+    auto version = readUInt<quint16>(data+2, bigEndian);
+    qsizetype offsetSize = 4;
+    quint64 ifd0Offset = 0;
+    if (version == 42)
+    {
+        ifd0Offset = readUInt<quint32>(data+4, bigEndian);
+    }
+    else if (version == 43)
+    {
+        offsetSize = 8;
+        if ((size < 16) || (readUInt<quint16>(data+4, bigEndian) != 8) || (readUInt<quint16>(data+6, bigEndian) != 0))
         {
-            values.append(QString::fromLatin1(subStrings));
+            throw QObject::tr("Found invalid TIFF file data.", "FileFormats::TIFF");
         }
+        ifd0Offset = readUInt<quint64>(data+8, bigEndian);
     }
-    break;
-    case DT_Short:
-        values.reserve(count);
-        for (quint32 i = 0; i < count; ++i)
+    else
+    {
+        throw QObject::tr("Found an unsupported TIFF version.", "FileFormats::TIFF");
+    }
+    auto countSize = static_cast<quint64>((offsetSize == 8) ? 8 : 2);
+    auto entrySize = static_cast<quint64>((offsetSize == 8) ? 20 : 12);
+
+    // Number of directory entries
+    if ((ifd0Offset > size) || (size - ifd0Offset < countSize))
+    {
+        throw QObject::tr("Read past end of data stream.", "FileFormats::TIFF");
+    }
+    auto tagCount = (countSize == 8) ? readUInt<quint64>(data+ifd0Offset, bigEndian)
+                                     : readUInt<quint16>(data+ifd0Offset, bigEndian);
+    if (tagCount > (size - ifd0Offset - countSize)/entrySize)
+    {
+        throw QObject::tr("Read past end of data stream.", "FileFormats::TIFF");
+    }
+
+    // Directory entries
+    const auto* entry = data + ifd0Offset + countSize;
+    for (quint64 i=0; i<tagCount; ++i, entry += entrySize)
+    {
+        Field field;
+        field.m_bigEndian = bigEndian;
+        auto tag = readUInt<quint16>(entry, bigEndian);
+        field.m_type = readUInt<quint16>(entry+2, bigEndian);
+        auto count = readOffset(entry+4, offsetSize, bigEndian);
+        const auto* valueField = entry + 4 + offsetSize;
+
+        // Fields of unknown type are ignored
+        auto valueSize = static_cast<quint64>(typeSize(field.m_type));
+        if (valueSize == 0)
         {
-            quint16 tmpInt = 0;
-            dataStream >> tmpInt;
-            checkForError(dataStream);
-            values.append(tmpInt);
+            continue;
         }
-        break;
-    case DT_Double:
-        values.reserve(count);
-        for (quint32 i = 0; i < count; ++i)
+        if (count > size/valueSize)
         {
-            double tmpFloat = NAN;
-            dataStream >> tmpFloat;
-            checkForError(dataStream);
-            values.append(tmpFloat);
+            throw QObject::tr("Read past end of data stream.", "FileFormats::TIFF");
         }
-        break;
-    default:
-        break;
-    }
+        auto byteSize = count*valueSize;
 
-    // Position the device at the byte following the current entry
-    if (!device.seek(filePos+4))
-    {
-        throw device.errorString();
+        // Values are stored in the entry itself if they fit, and elsewhere in
+        // the file otherwise
+        if (byteSize <= static_cast<quint64>(offsetSize))
+        {
+            field.m_data = {valueField, static_cast<size_t>(byteSize)};
+        }
+        else
+        {
+            auto valueOffset = readOffset(valueField, offsetSize, bigEndian);
+            if ((valueOffset > size) || (size - valueOffset < byteSize))
+            {
+                throw QObject::tr("Read past end of data stream.", "FileFormats::TIFF");
+            }
+            field.m_data = {data + valueOffset, static_cast<size_t>(byteSize)};
+        }
+        field.m_count = static_cast<qsizetype>(count);
+        m_TIFFFields[tag] = field;
     }
 
-    m_TIFFFields[tag] = values;
+    readRasterSize();
 }
 
 
 void FileFormats::TIFF::readRasterSize()
 {
     // Handle Tag 256, compute width
-    quint16 width = 0;
+    quint64 width = 0;
     {
         if (m_TIFFFields.contains(256))
         {
@@ -295,8 +411,8 @@ void FileFormats::TIFF::readRasterSize()
                 throw QObject::tr("No data for tag 256.", "FileFormats::TIFF");
             }
             bool ok = false;
-            width = values.constLast().toUInt(&ok);
-            if (!ok)
+            width = values.toUInt(values.size()-1, &ok);
+            if (!ok || (width > INT_MAX))
             {
                 throw QObject::tr("Invalid data for tag 256.", "FileFormats::TIFF");
             }
@@ -308,7 +424,7 @@ void FileFormats::TIFF::readRasterSize()
     }
 
     // Handle Tag 257, compute height
-    quint16 height = 0;
+    quint64 height = 0;
     {
         if (m_TIFFFields.contains(257))
         {
@@ -318,8 +434,8 @@ void FileFormats::TIFF::readRasterSize()
                 throw QObject::tr("No data for tag 257.", "FileFormats::TIFF");
             }
             bool ok = false;
-            height = values.constLast().toUInt(&ok);
-            if (!ok)
+            height = values.toUInt(values.size()-1, &ok);
+            if (!ok || (height > INT_MAX))
             {
                 throw QObject::tr("Invalid data for tag 257.", "FileFormats::TIFF");
             }
@@ -330,5 +446,5 @@ void FileFormats::TIFF::readRasterSize()
         }
     }
 
-    m_rasterSize = QSize(width, height);
+    m_rasterSize = QSize(static_cast<int>(width), static_cast<int>(height));
 }
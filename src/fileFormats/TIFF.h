@@ -20,8 +20,10 @@
 
 #pragma once
 
+#include <QFile>
+#include <QSharedPointer>
 #include <QSize>
-#include <QVariant>
+#include <span>
 
 #include "DataFileAbstract.h"
 
@@ -30,14 +32,85 @@ namespace FileFormats
 
 /*! \brief TIFF support
  *
- *  This class reads GeoTIFF files. It extracts image dimension as well
- *  as the TIFF fields. It does not read the raster data.
+ *  This class reads TIFF and BigTIFF files. It extracts image dimension as
+ *  well as the TIFF fields of the first image file directory. It does not
+ *  read the raster data.
  *
+ *  Whenever possible, the file is mapped into memory and the fields are read
+ *  in place. Values are not copied or converted until they are accessed, so
+ *  that reading the header of a large file costs little more than the I/O
+ *  required to load the pages that contain the image file directory.
  */
 
 class TIFF : public DataFileAbstract
 {
 public:
+    /*! \brief TIFF field
+     *
+     *  A field holds an array of values of one TIFF data type. The values are
+     *  not copied: they are decoded from the underlying TIFF data, in the
+     *  byte order of the file, whenever one of the accessor methods is called.
+     *  A field is therefore valid only as long as the TIFF object that it was
+     *  obtained from exists.
+     */
+    class Field
+    {
+        friend class TIFF;
+
+    public:
+        /*! \brief Test if the field holds values
+         *
+         *  @returns True if size() is zero
+         */
+        [[nodiscard]] bool isEmpty() const { return m_count == 0; }
+
+        /*! \brief Number of values
+         *
+         *  @returns Number of values. For fields of type ASCII, this is the
+         *  number of bytes, including terminating zeros.
+         */
+        [[nodiscard]] qsizetype size() const { return m_count; }
+
+        /*! \brief Value, as an integer
+         *
+         *  @param index Index of the value
+         *
+         *  @param ok If not nullptr, set to true on success and to false if
+         *  the index is out of range or if the field does not hold unsigned
+         *  integers
+         *
+         *  @returns Value, or 0 on failure
+         */
+        [[nodiscard]] quint64 toUInt(qsizetype index, bool* ok = nullptr) const;
+
+        /*! \brief Value, as a floating point number
+         *
+         *  @param index Index of the value
+         *
+         *  @param ok If not nullptr, set to true on success and to false if
+         *  the index is out of range or if the field does not hold numbers
+         *
+         *  @returns Value, or NaN on failure
+         */
+        [[nodiscard]] double toDouble(qsizetype index, bool* ok = nullptr) const;
+
+        /*! \brief Value, as a string
+         *
+         *  @returns For fields of type ASCII, the first string stored in the
+         *  field. For all other fields, an empty string.
+         */
+        [[nodiscard]] QString toString() const;
+
+    private:
+        // TIFF data type, number of values, and the raw bytes in the byte
+        // order of the file
+        quint16 m_type {0};
+        qsizetype m_count {0};
+        std::span<const uchar> m_data;
+        bool m_bigEndian {false};
+    };
+
+
     /*! \brief Constructor
      *
      *  The constructor opens and reads the TIFF file. It does not read
@@ -49,11 +122,13 @@ public:
 
     /*! \brief Constructor
      *
-     *  The constructor opens and rteads the TIFF file. It does not read
+     *  The constructor opens and reads the TIFF file. It does not read
      *  the raster data and is therefore lightweight.
      *
      *  \param device Device from which the TIFF is read. The device must be
-     *  opened and seekable. The device will not be closed by this method.
+     *  opened and seekable. The device will not be closed by this method. If
+     *  the device is a file, then it is mapped into memory, and the fields
+     *  remain valid only as long as the device stays open.
      */
     TIFF(QIODevice& device);
 
@@ -67,13 +142,13 @@ public:
      *
      * @returns TIFF-internal data fields
      */
-    [[nodiscard]] QMap<quint16, QVariantList> fields() { return m_TIFFFields; }
+    [[nodiscard]] QMap<quint16, FileFormats::TIFF::Field> fields() const { return m_TIFFFields; }
 
     /*! \brief Size of the TIFF raster image
      *
      * @returns Size of the TIFF raster image, or an invalid size in case or error.
      */
-    [[nodiscard]] QSize rasterSize() { return m_rasterSize; }
+    [[nodiscard]] QSize rasterSize() const { return m_rasterSize; }
 
 
     //
@@ -87,42 +162,40 @@ public:
     [[nodiscard]] static QStringList mimeTypes() { return {u"image/tiff"_qs}; }
 
 private:
-    /* This methods reads the TIFF data from the device. On success, it fills
-     * the memeber m_TIFFFields with appropriate data. On failure, it throws a
-     * QString with a human-readable, translated error message.
-     *
-     * @param device QIODevice from which the TIFF header will be read. This
-     * device must be seekable.
+    Q_DISABLE_COPY_MOVE(TIFF)
+
+    /* This method makes the content of the device available in m_data, by
+     * memory mapping if possible, and by reading the device otherwise. On
+     * failure, it throws a QString with a human-readable, translated error
+     * message.
      */
-    void readTIFFData(QIODevice& device);
+    void mapDevice(QIODevice& device);
 
-    /* This methods reads a single TIFF field from the device. On success, it
-     * adds an entry to the member m_TIFFFields and positions the device on the
-     * byte following the structure. On failure, it throws a QString with a
-     * human-readable, translated error message.
-     *
-     * This method only reads values of type ASCII, SHORT and DOUBLE. Values of
-     * other types will be ignored.
-     *
-     * @param device QIODevice from which the TIFF header will be read. This
-     * device must be open, seekable, and positioned to the beginning of the
-     * TIFF field structure.
-     *
-     * @param dataStream QDataStream that is connected to the device and has the
-     * correct endianness set.
+    /* This methods reads the TIFF data from m_data. On success, it fills the
+     * member m_TIFFFields with appropriate data. On failure, it throws a
+     * QString with a human-readable, translated error message.
      */
-    void readTIFFField(QIODevice& device, QDataStream& dataStream);
+    void readTIFFData();
 
     /* This method interprets m_TIFFFields, extracts the size of the raster
      * image and writes the result into m_rasterSize.
      */
     void readRasterSize();
 
+    // File opened by the constructor, if any. The memory mapping is released
+    // when the file is closed.
+    QSharedPointer<QFile> m_file;
+
+    // Content of the TIFF file. This points either to a memory mapping, or to
+    // the content of m_buffer.
+    std::span<const uchar> m_data;
+    QByteArray m_buffer;
+
     // Size of the raster imags
     QSize m_rasterSize {};
 
     // TIFF tags and associated data
-    QMap<quint16, QVariantList> m_TIFFFields;
+    QMap<quint16, FileFormats::TIFF::Field> m_TIFFFields;
 };
 
 } // namespace FileFormats
@@ -58,16 +58,67 @@ GeoMaps::VAC FileFormats::TripKit::extract(const QString& directoryPath, qsizety
     }
     auto entry = m_entries.at(index);
 
-    auto imageData = m_zip.extract(entry.path);
-    if (imageData.isEmpty())
+    auto zipIndex = zipIndexOf(entry);
+    if (zipIndex < 0)
     {
-        imageData = m_zip.extract("charts/"+entry.name+"-geo."+entry.ending);
+        return {};
     }
-    if (imageData.isEmpty())
+    if (!QDir().mkpath(directoryPath))
     {
         return {};
     }
+    auto file = m_zip.openFile(zipIndex);
+    return convert(entry, file.data(), directoryPath);
+}
+
+
+void FileFormats::TripKit::extractParallel(const QString& directoryPath, const ChartFunction& function)
+{
     if (!QDir().mkpath(directoryPath))
+    {
+        return;
+    }
+
+    // Charts that are not found in the archive are reported right away
+    QHash<qsizetype, qsizetype> entryIndices;
+    QList<qsizetype> zipIndices;
+    for(qsizetype index=0; index<m_entries.size(); index++)
+    {
+        auto zipIndex = zipIndexOf(m_entries.at(index));
+        if ((zipIndex < 0) || entryIndices.contains(zipIndex))
+        {
+            if (!function(index, {}))
+            {
+                return;
+            }
+            continue;
+        }
+        entryIndices.insert(zipIndex, index);
+        zipIndices.append(zipIndex);
+    }
+
+    m_zip.extractParallel(zipIndices, [&](qsizetype zipIndex, QIODevice* file)
+    {
+        auto index = entryIndices.value(zipIndex);
+        return function(index, convert(m_entries.at(index), file, directoryPath));
+    });
+}
+
+
+qsizetype FileFormats::TripKit::zipIndexOf(const chartEntry& entry) const
+{
+    auto zipIndex = m_zip.indexOf(entry.path);
+    if (zipIndex < 0)
+    {
+        zipIndex = m_zip.indexOf("charts/"+entry.name+"-geo."+entry.ending);
+    }
+    return zipIndex;
+}
+
+
+GeoMaps::VAC FileFormats::TripKit::convert(const chartEntry& entry, QIODevice* file, const QString& directoryPath)
+{
+    if (file == nullptr)
     {
         return {};
     }
@@ -75,20 +126,42 @@ GeoMaps::VAC FileFormats::TripKit::extract(const QString& directoryPath, qsizety
     auto newFileName = u"%1/%2.webp"_qs.arg(directoryPath, entry.name);
     if (entry.ending == u"webp"_qs)
     {
+        // Stream the file, without holding it in memory
         QFile out(newFileName);
         if (!out.open(QIODeviceBase::WriteOnly))
         {
             return {};
         }
-        if (out.write(imageData) != imageData.size())
+        constexpr qint64 chunkSize = 1024*1024;
+        QByteArray buffer(chunkSize, Qt::Uninitialized);
+        qint64 bytesWritten = 0;
+        while(true)
         {
-            return {};
+            auto numBytesRead = file->read(buffer.data(), chunkSize);
+            if (numBytesRead < 0)
+            {
+                return {};
+            }
+            if (numBytesRead == 0)
+            {
+                break;
+            }
+            if (out.write(buffer.constData(), numBytesRead) != numBytesRead)
+            {
+                return {};
+            }
+            bytesWritten += numBytesRead;
         }
         out.close();
+        if (bytesWritten == 0)
+        {
+            QFile::remove(newFileName);
+            return {};
+        }
     }
     else
     {
-        auto image = QImage::fromData(imageData);
+        auto image = QImage::fromData(file->readAll());
         if (image.isNull())
         {
             return {};
@@ -99,6 +99,29 @@ public:
      */
     [[nodiscard]] GeoMaps::VAC extract(const QString& directoryPath, qsizetype index);
 
+    /*! \brief Function that receives an extracted chart
+     *
+     *  The function receives the index of the chart and the VAC, which is
+     *  invalid in case of error. It returns false to stop the extraction.
+     */
+    using ChartFunction = std::function<bool(qsizetype index, const GeoMaps::VAC& vac)>;
+
+    /*! \brief Extract all visual approach charts in parallel
+     *
+     *  This method extracts and converts all charts, in the same way as
+     *  extract(), on several worker threads. Every worker holds at most one
+     *  chart in memory at a time. The function is called once for every
+     *  chart, from the worker threads, and must therefore be thread-safe. The
+     *  method returns once all charts have been handled, or once the function
+     *  has returned false.
+     *
+     *  @param directoryPath Name of a directory where the VACs will be stored.
+     *  The directory and its parents are created if necessary
+     *
+     *  @param function Function that receives the extracted charts
+     */
+    void extractParallel(const QString& directoryPath, const ChartFunction& function);
+
 
     //
     // Static methods
@@ -129,6 +152,14 @@ private:
         QGeoCoordinate bottomLeft;
         QGeoCoordinate bottomRight;
     };
+
+    // Index of the chart in the ZIP file, or -1 if the chart cannot be found
+    [[nodiscard]] qsizetype zipIndexOf(const chartEntry& entry) const;
+
+    // Reads the chart from file and stores it in directoryPath, converting to
+    // webp if necessary. Returns an invalid VAC in case of error. This method
+    // is thread-safe.
+    [[nodiscard]] static GeoMaps::VAC convert(const chartEntry& entry, QIODevice* file, const QString& directoryPath);
     QList<TripKit::chartEntry> m_entries;
 
     FileFormats::ZipFile m_zip;
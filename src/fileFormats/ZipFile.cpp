@@ -21,11 +21,67 @@
 #include <QDataStream>
 #include <QFile>
 #include <QString>
+#include <QThread>
+#include <QtConcurrent>
+#include <atomic>
 #include <zip.h>
 
 #include "fileFormats/ZipFile.h"
 
 
+namespace {
+
+// Sequential QIODevice that reads a file from a zip archive
+class ZipFileDevice : public QIODevice
+{
+public:
+    ZipFileDevice(zip_file_t* zipFile, qint64 size)
+        : m_zipFile(zipFile), m_size(size)
+    {
+    }
+
+    ~ZipFileDevice() override
+    {
+        zip_fclose(m_zipFile);
+    }
+
+    [[nodiscard]] bool isSequential() const override { return true; }
+
+    [[nodiscard]] qint64 size() const override { return m_size; }
+
+    [[nodiscard]] qint64 bytesAvailable() const override
+    {
+        return (m_size-m_bytesRead) + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        auto numBytesRead = zip_fread(m_zipFile, data, maxSize);
+        if (numBytesRead > 0)
+        {
+            m_bytesRead += numBytesRead;
+        }
+        return numBytesRead;
+    }
+
+    qint64 writeData(const char* /*data*/, qint64 /*maxSize*/) override
+    {
+        return -1;
+    }
+
+private:
+    Q_DISABLE_COPY_MOVE(ZipFileDevice)
+
+    zip_file_t* m_zipFile;
+    qint64 m_size;
+    qint64 m_bytesRead {0};
+};
+
+} // namespace
+
+
+
 FileFormats::ZipFile::ZipFile(const QString& fileName)
 {
     m_file = openFileURL(fileName);
@@ -62,6 +118,12 @@ FileFormats::ZipFile::ZipFile(const QString& fileName)
         }
         m_fileNames += QString::fromUtf8(zStat.name);
         m_fileSizes += (qsizetype) zStat.size;
+
+        auto normalizedName = normalizedFileName(m_fileNames.constLast());
+        if (!m_index.contains(normalizedName))
+        {
+            m_index.insert(normalizedName, i);
+        }
     }
 }
 
@@ -96,11 +158,11 @@ QByteArray FileFormats::ZipFile::extract(qsizetype index)
         return {};
     }
     auto numBytesRead = zip_fread(zipFile, data.data(), fileSize);
+    zip_fclose(zipFile);
     if (numBytesRead != fileSize)
     {
         return {};
     }
-    zip_fclose(zipFile);
 
     return data;
 }
@@ -108,12 +170,115 @@ QByteArray FileFormats::ZipFile::extract(qsizetype index)
 
 QByteArray FileFormats::ZipFile::extract(const QString& fileName)
 {
-    auto idx = m_fileNames.indexOf(fileName);
-    if (idx == -1)
+    return extract(indexOf(fileName));
+}
+
+
+QSharedPointer<QIODevice> FileFormats::ZipFile::openFile(qsizetype index)
+{
+    if (m_zip == nullptr)
+    {
+        return {};
+    }
+    if ((index < 0) || (index >= m_fileNames.size()))
+    {
+        return {};
+    }
+
+    auto* zipFile = zip_fopen_index(static_cast<zip_t*>(m_zip), index, 0);
+    if (zipFile == nullptr)
+    {
+        return {};
+    }
+    auto device = QSharedPointer<QIODevice>(new ZipFileDevice(zipFile, m_fileSizes.at(index)));
+    device->open(QIODeviceBase::ReadOnly);
+    return device;
+}
+
+
+bool FileFormats::ZipFile::extractToFile(qsizetype index, const QString& newFileName, const ProgressCallback& progress)
+{
+    auto device = openFile(index);
+    if (device.isNull())
     {
-        auto windowsStyleFileName = fileName;
-        windowsStyleFileName.replace('/', '\\');
-        idx = m_fileNames.indexOf(windowsStyleFileName);
+        return false;
     }
-    return extract(idx);
+
+    QFile out(newFileName);
+    if (!out.open(QIODeviceBase::WriteOnly|QIODeviceBase::Truncate))
+    {
+        return false;
+    }
+
+    constexpr qint64 chunkSize = 1024*1024;
+    QByteArray buffer(chunkSize, Qt::Uninitialized);
+    qint64 bytesWritten = 0;
+    bool success = true;
+    while(true)
+    {
+        auto numBytesRead = device->read(buffer.data(), chunkSize);
+        if (numBytesRead <= 0)
+        {
+            success = (numBytesRead == 0);
+            break;
+        }
+        if (out.write(buffer.constData(), numBytesRead) != numBytesRead)
+        {
+            success = false;
+            break;
+        }
+        bytesWritten += numBytesRead;
+        if (progress && !progress(bytesWritten, m_fileSizes.at(index)))
+        {
+            success = false;
+            break;
+        }
+    }
+    out.close();
+
+    success = success && (bytesWritten == m_fileSizes.at(index));
+    if (!success)
+    {
+        QFile::remove(newFileName);
+    }
+    return success;
+}
+
+
+void FileFormats::ZipFile::extractParallel(const QList<qsizetype>& indices, const FileFunction& function) const
+{
+    if ((m_zip == nullptr) || indices.isEmpty())
+    {
+        return;
+    }
+
+    // Distribute the files among the workers. Neighbouring indices go to
+    // different workers, so that large files tend to be spread evenly.
+    auto numWorkers = qBound(qsizetype(1), qsizetype(QThread::idealThreadCount()), indices.size());
+    QList<QList<qsizetype>> chunks(numWorkers);
+    for(qsizetype i=0; i<indices.size(); i++)
+    {
+        chunks[i % numWorkers].append(indices[i]);
+    }
+
+    // Every worker opens its own copy of the archive. The file m_file is
+    // local, so that this does not copy any data.
+    auto archiveName = m_file->fileName();
+    std::atomic<bool> stopped {false};
+    QtConcurrent::blockingMap(chunks, [&](const QList<qsizetype>& chunk)
+    {
+        FileFormats::ZipFile worker(archiveName);
+        foreach(auto index, chunk)
+        {
+            if (stopped)
+            {
+                return;
+            }
+            auto device = worker.openFile(index);
+            if (!function(index, device.data()))
+            {
+                stopped = true;
+            }
+        }
+    });
 }
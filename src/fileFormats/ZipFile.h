@@ -20,6 +20,10 @@
 
 #pragma once
 
+#include <QHash>
+#include <QIODevice>
+#include <functional>
+
 #include "fileFormats/DataFileAbstract.h"
 
 
@@ -28,7 +32,9 @@ namespace FileFormats
 
 /*! \brief ZIP Archive
  *
- *  This class reads a ZIP file and allows extracting individual files.
+ *  This class reads a ZIP file and allows extracting individual files, either
+ *  in one piece or as a stream. Instances of this class must not be shared
+ *  between threads. Use extractParallel() to extract files on several cores.
  */
 class ZipFile : public DataFileAbstract
 {
@@ -57,6 +63,19 @@ public:
      */
     [[nodiscard]] QStringList fileNames() const { return m_fileNames; }
 
+    /*! \brief Index of a file in the zip archive
+     *
+     *  File names are compared after replacing windows-style path separators
+     *  '\\' by '/', so that archives produced on Windows can be read with
+     *  the usual path names. The lookup uses a hash table and is fast.
+     *
+     *  @param fileName File name
+     *
+     *  @returns Index of the file in the list returned by fileNames, or -1 if
+     *  no such file exists
+     */
+    [[nodiscard]] qsizetype indexOf(const QString& fileName) const { return m_index.value(normalizedFileName(fileName), -1); }
+
     /*! \brief Content of file in the zip archive
      *
      *  @param index Index of the file in the list returned by fileNames
@@ -78,6 +97,58 @@ public:
      */
     [[nodiscard]] QByteArray extract(const QString& fileName);
 
+    /*! \brief Stream for reading a file in the zip archive
+     *
+     *  This method returns a sequential QIODevice that decompresses the file
+     *  while it is read, so that the file never needs to be held in memory
+     *  as a whole. The device must not outlive this instance.
+     *
+     *  @param index Index of the file in the list returned by fileNames
+     *
+     *  @returns A device that is open for reading, or nullptr in case of
+     *  error.
+     */
+    [[nodiscard]] QSharedPointer<QIODevice> openFile(qsizetype index);
+
+    /*! \brief Extract file in the zip archive to a local file
+     *
+     *  The file is decompressed and written in chunks.
+     *
+     *  @param index Index of the file in the list returned by fileNames
+     *
+     *  @param newFileName Name of the local file. An existing file is
+     *  overwritten.
+     *
+     *  @param progress Optional callback that reports progress and allows
+     *  to cancel the extraction
+     *
+     *  @returns True on success. On failure or cancellation, newFileName is
+     *  removed.
+     */
+    [[nodiscard]] bool extractToFile(qsizetype index, const QString& newFileName, const ProgressCallback& progress = {});
+
+    /*! \brief Function that processes one file of the archive
+     *
+     *  The function receives the index of the file and a stream as returned by
+     *  openFile(), or nullptr if the file cannot be read. It returns false to
+     *  stop processing of the remaining files.
+     */
+    using FileFunction = std::function<bool(qsizetype index, QIODevice* file)>;
+
+    /*! \brief Process files of the zip archive in parallel
+     *
+     *  This method calls the function for every given index, on several
+     *  worker threads. Every worker opens the archive with a libzip handle of
+     *  its own, because libzip handles cannot be shared between threads. The
+     *  function must therefore be thread-safe. The method returns once all
+     *  files have been processed, or once the function has returned false.
+     *
+     *  @param indices Indices of files in the list returned by fileNames
+     *
+     *  @param function Function that processes one file
+     */
+    void extractParallel(const QList<qsizetype>& indices, const FileFunction& function) const;
+
 
     //
     // Static methods
@@ -92,10 +163,20 @@ public:
 private:
     Q_DISABLE_COPY_MOVE(ZipFile)
 
+    // File name with windows-style path separators replaced by '/'
+    [[nodiscard]] static QString normalizedFileName(const QString& fileName)
+    {
+        auto result = fileName;
+        return result.replace(u'\\', u'/');
+    }
+
     void* m_zip {nullptr};
     QSharedPointer<QFile> m_file;
     QStringList m_fileNames;
     QList<qsizetype> m_fileSizes;
+
+    // Maps normalized file names to indices in m_fileNames
+    QHash<QString, qsizetype> m_index;
 };
 
 } // namespace FileFormats
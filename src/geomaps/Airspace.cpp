@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include <QJsonArray>
+#include <algorithm>
 
 #include "Airspace.h"
 #include "units/Distance.h"
@@ -46,11 +47,20 @@ GeoMaps::Airspace::Airspace(const QJsonObject &geoJSONObject) {
         return;
     }
     auto polygonCoordinates = polygonArray[0].toArray();
+    m_latitudes.reserve(polygonCoordinates.size());
+    m_longitudes.reserve(polygonCoordinates.size());
     foreach (auto coordinate, polygonCoordinates) {
         auto coordinateArray = coordinate.toArray();
-        auto geoCoordinate =
-                QGeoCoordinate(coordinateArray[1].toDouble(), coordinateArray[0].toDouble());
-        m_polygon.addCoordinate(geoCoordinate);
+        m_latitudes.append(coordinateArray[1].toDouble());
+        m_longitudes.append(coordinateArray[0].toDouble());
+    }
+    if (!m_latitudes.isEmpty()) {
+        auto [latMin, latMax] = std::minmax_element(m_latitudes.cbegin(), m_latitudes.cend());
+        auto [lonMin, lonMax] = std::minmax_element(m_longitudes.cbegin(), m_longitudes.cend());
+        m_latMin = *latMin;
+        m_latMax = *latMax;
+        m_lonMin = *lonMin;
+        m_lonMax = *lonMax;
     }
 
     // Get properties
@@ -72,47 +82,99 @@ GeoMaps::Airspace::Airspace(const QJsonObject &geoJSONObject) {
         return;
     }
     m_upperBound = properties[QStringLiteral("TOP")].toString();
+    m_upperLimit = parseVerticalLimit(m_upperBound);
 
     if (!properties.contains(QStringLiteral("BOT"))) {
         return;
     }
     m_lowerBound = properties[QStringLiteral("BOT")].toString();
+    m_lowerLimit = parseVerticalLimit(m_lowerBound);
+    if (m_lowerLimit.height.isFinite()) {
+        m_estimatedLowerBoundMSL = m_lowerLimit.height;
+    }
 }
 
 
-auto GeoMaps::Airspace::estimatedLowerBoundMSL() const -> Units::Distance
+auto GeoMaps::Airspace::contains(const QGeoCoordinate& coordinate) const -> bool
 {
-    double result = 0.0;
-    bool ok = false;
+    if (!coordinate.isValid() || m_latitudes.isEmpty()) {
+        return false;
+    }
+
+    auto lat = coordinate.latitude();
+    auto lon = coordinate.longitude();
+    if ((lat < m_latMin) || (lat > m_latMax) || (lon < m_lonMin) || (lon > m_lonMax)) {
+        return false;
+    }
+
+    // Even-odd rule: count the edges that cross the ray from the coordinate
+    // towards increasing longitude
+    bool result = false;
+    const auto* lats = m_latitudes.constData();
+    const auto* lons = m_longitudes.constData();
+    auto numVertices = m_latitudes.size();
+    for(qsizetype i = 0, j = numVertices-1; i < numVertices; j = i++) {
+        if ((lats[i] > lat) != (lats[j] > lat)) {
+            auto crossingLon = lons[i] + (lat-lats[i])*(lons[j]-lons[i])/(lats[j]-lats[i]);
+            if (lon < crossingLon) {
+                result = !result;
+            }
+        }
+    }
+    return result;
+}
 
-    QString AL = m_lowerBound.simplified();
 
-    if (AL.startsWith(u"FL"_qs, Qt::CaseInsensitive)) {
-        result = AL.remove(0, 2).toDouble(&ok);
+auto GeoMaps::Airspace::polygon() const -> QGeoPolygon
+{
+    QGeoPolygon result;
+    for(qsizetype i = 0; i < m_latitudes.size(); i++) {
+        result.addCoordinate(QGeoCoordinate(m_latitudes[i], m_longitudes[i]));
+    }
+    return result;
+}
+
+
+auto GeoMaps::Airspace::parseVerticalLimit(const QString& limit) -> VerticalLimit
+{
+    QString AL = limit.simplified().toUpper();
+
+    if ((AL == u"GND"_qs) || (AL == u"SFC"_qs)) {
+        return {Units::Distance::fromFT(0.0), AGL};
+    }
+    if (AL == u"UNL"_qs) {
+        return {Units::Distance::fromFT(qInf()), MSL};
+    }
+
+    bool ok = false;
+    if (AL.startsWith(u"FL"_qs)) {
+        auto flightLevel = AL.remove(0, 2).toDouble(&ok);
         if (ok) {
-            return Units::Distance::fromFT(100*result);
+            return {Units::Distance::fromFT(100*flightLevel), FL};
         }
-        return Units::Distance::fromFT(0.0);
+        return {};
     }
 
-    if (AL.endsWith(u"msl"_qs)) {
+    Reference reference = MSL;
+    if (AL.endsWith(u"MSL"_qs)) {
         AL.chop(3);
         AL = AL.simplified();
     }
-    if (AL.endsWith(u"agl"_qs)) {
+    if (AL.endsWith(u"AGL"_qs) || AL.endsWith(u"GND"_qs)) {
         AL.chop(3);
         AL = AL.simplified();
+        reference = AGL;
     }
-    if (AL.endsWith(u"ft"_qs)) {
+    if (AL.endsWith(u"FT"_qs)) {
         AL.chop(2);
         AL = AL.simplified();
     }
 
-    result = AL.toDouble(&ok);
+    auto height = AL.toDouble(&ok);
     if (ok) {
-        return Units::Distance::fromFT(result);
+        return {Units::Distance::fromFT(height), reference};
     }
-    return Units::Distance::fromFT(0.0);
+    return {};
 }
 
 
@@ -152,7 +214,8 @@ auto GeoMaps::operator==(const GeoMaps::Airspace& A, const GeoMaps::Airspace& B)
             (A.m_CAT == B.m_CAT) &&
             (A.m_upperBound == B.m_upperBound) &&
             (A.m_lowerBound == B.m_lowerBound) &&
-            (A.m_polygon == B.m_polygon) );
+            (A.m_latitudes == B.m_latitudes) &&
+            (A.m_longitudes == B.m_longitudes) );
 }
 
 
@@ -162,6 +225,7 @@ auto GeoMaps::qHash(const GeoMaps::Airspace& A) -> size_t
     result += qHash(A.CAT());
     result += qHash(A.upperBound());
     result += qHash(A.lowerBound());
-    result += qHash(A.polygon());
+    result += qHash(A.m_latitudes);
+    result += qHash(A.m_longitudes);
     return result;
 }
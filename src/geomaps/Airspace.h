@@ -27,7 +27,14 @@
 
 namespace GeoMaps {
 
-/*! \brief A very simple class that describes an airspace */
+/*! \brief A very simple class that describes an airspace
+ *
+ *  The lateral limits are stored as flat arrays of latitudes and longitudes,
+ *  together with a bounding box, and the vertical limits are parsed into
+ *  numbers when the airspace is constructed. Queries such as contains() and
+ *  estimatedLowerBoundMSL() therefore need neither string operations nor
+ *  QtPositioning.
+ */
 
 class Airspace {
     Q_GADGET
@@ -35,7 +42,37 @@ class Airspace {
     /*! \brief Comparison */
     friend auto operator==(const GeoMaps::Airspace&, const GeoMaps::Airspace&) -> bool;
 
+    /*! \brief Hash function */
+    friend auto qHash(const GeoMaps::Airspace&) -> size_t;
+
 public:
+    /*! \brief Reference of a vertical limit */
+    enum Reference {
+        /*! \brief Height above mean sea level */
+        MSL = 0,
+
+        /*! \brief Height above ground level */
+        AGL = 1,
+
+        /*! \brief Flight level, height above the 1013.25 hPa pressure level */
+        FL = 2,
+
+        /*! \brief The limit could not be parsed */
+        Unknown = 3
+    };
+    Q_ENUM(Reference)
+
+    /*! \brief Vertical limit of an airspace, in numeric form */
+    struct VerticalLimit {
+        /*! \brief Height, relative to reference. For flight levels, this is
+         *  100ft times the flight level. NaN if the reference is Unknown, and
+         *  infinite for unlimited airspaces. */
+        Units::Distance height;
+
+        /*! \brief Reference of the height */
+        Reference reference {Unknown};
+    };
+
     /*! \brief Constructs an invalid airspace */
     Airspace() = default;
 
@@ -58,7 +95,47 @@ public:
      * @returns Estimated lower bound of the airspace, above main sea
      * level
      */
-    [[nodiscard]] auto estimatedLowerBoundMSL() const -> Units::Distance;
+    [[nodiscard]] auto estimatedLowerBoundMSL() const -> Units::Distance { return m_estimatedLowerBoundMSL; }
+
+    /*! \brief Check if a coordinate is contained in the lateral limits
+     *
+     * @param coordinate Coordinate
+     *
+     * @returns True if the coordinate is valid and lies inside the polygon
+     * that describes the lateral limits of the airspace
+     */
+    [[nodiscard]] auto contains(const QGeoCoordinate& coordinate) const -> bool;
+
+    /*! \brief Latitudes of the polygon vertices
+     *
+     * @returns Latitudes of the vertices of the polygon that describes the
+     * lateral limits, in degrees
+     */
+    [[nodiscard]] auto latitudes() const -> const QList<double>& { return m_latitudes; }
+
+    /*! \brief Longitudes of the polygon vertices
+     *
+     * @returns Longitudes of the vertices of the polygon that describes the
+     * lateral limits, in degrees
+     */
+    [[nodiscard]] auto longitudes() const -> const QList<double>& { return m_longitudes; }
+
+    /*! \brief Check if the bounding box intersects a given box
+     *
+     * @param latMin Minimal latitude of the box, in degrees
+     *
+     * @param latMax Maximal latitude of the box, in degrees
+     *
+     * @param lonMin Minimal longitude of the box, in degrees
+     *
+     * @param lonMax Maximal longitude of the box, in degrees
+     *
+     * @returns True if the bounding box of the polygon intersects the box
+     */
+    [[nodiscard]] auto intersectsBox(double latMin, double latMax, double lonMin, double lonMax) const -> bool
+    {
+        return (m_latMin <= latMax) && (m_latMax >= latMin) && (m_lonMin <= lonMax) && (m_lonMax >= lonMin);
+    }
 
     /*! \brief Validity */
     Q_PROPERTY(bool isValid READ isValid CONSTANT)
@@ -67,7 +144,7 @@ public:
      *
      * @returns Property isValid
      */
-    [[nodiscard]] auto isValid() const -> bool { return !m_polygon.isEmpty(); }
+    [[nodiscard]] auto isValid() const -> bool { return !m_latitudes.isEmpty(); }
 
     /*! \brief Lower limit of the airspace
      *
@@ -83,6 +160,12 @@ public:
      */
     [[nodiscard]] auto lowerBound() const -> QString { return m_lowerBound; }
 
+    /*! \brief Lower limit of the airspace, in numeric form
+     *
+     * @returns Lower limit, parsed from lowerBound
+     */
+    [[nodiscard]] auto lowerLimit() const -> VerticalLimit { return m_lowerLimit; }
+
     /*! \brief Lower limit of the airspace
      *
      * A string that describes the lower bound of the airspace in metric terms
@@ -111,7 +194,7 @@ public:
      *
      * @returns Property polygon
      */
-    [[nodiscard]] auto polygon() const -> QGeoPolygon { return m_polygon; }
+    [[nodiscard]] auto polygon() const -> QGeoPolygon;
 
     /* \brief Category of the airspace
      *
@@ -139,6 +222,12 @@ public:
      */
     [[nodiscard]] auto upperBound() const -> QString { return m_upperBound; }
 
+    /*! \brief Upper limit of the airspace, in numeric form
+     *
+     * @returns Upper limit, parsed from upperBound
+     */
+    [[nodiscard]] auto upperLimit() const -> VerticalLimit { return m_upperLimit; }
+
     /*! \brief Upper limit of the airspace
      *
      * A string that describes the upper bound of the airspace in metric terms
@@ -156,11 +245,24 @@ private:
     // in meters. If the height string cannot be parsed, returns the original string
     [[nodiscard]] static auto makeMetric(const QString& standard) -> QString;
 
+    // Parses a height string such as "4500", "1500 AGL", "GND" or "FL 130"
+    [[nodiscard]] static auto parseVerticalLimit(const QString& limit) -> VerticalLimit;
+
     QString m_name{};
     QString m_CAT{};
     QString m_upperBound{};
     QString m_lowerBound{};
-    QGeoPolygon m_polygon{};
+    VerticalLimit m_upperLimit{};
+    VerticalLimit m_lowerLimit{};
+    Units::Distance m_estimatedLowerBoundMSL{Units::Distance::fromFT(0.0)};
+
+    // Vertices of the polygon, in degrees, and its bounding box
+    QList<double> m_latitudes{};
+    QList<double> m_longitudes{};
+    double m_latMin{qQNaN()};
+    double m_latMax{qQNaN()};
+    double m_lonMin{qQNaN()};
+    double m_lonMax{qQNaN()};
 };
 
 /*! \brief Comparison */
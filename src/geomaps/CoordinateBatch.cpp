@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtMath>
+#include <cmath>
+
+#include "geomaps/CoordinateBatch.h"
+
+
+namespace {
+
+// Earth radius in meters, as used by QGeoCoordinate::distanceTo
+constexpr double earthRadiusInM = 6371007.2;
+
+// Unit vector of a coordinate, in an earth-centered frame
+struct UnitVector
+{
+    double x;
+    double y;
+    double z;
+};
+
+auto unitVector(const QGeoCoordinate& coordinate) -> UnitVector
+{
+    auto lat = qDegreesToRadians(coordinate.latitude());
+    auto lon = qDegreesToRadians(coordinate.longitude());
+    return {std::cos(lat)*std::cos(lon), std::cos(lat)*std::sin(lon), std::sin(lat)};
+}
+
+// The two kernels below contain only multiplications and additions on
+// contiguous arrays. Compilers vectorize them at -O3, the optimization level
+// of release builds. Trigonometric functions are applied in separate loops.
+
+// Squared lengths of the chords between p0 and the points (x[i], y[i], z[i])
+void squaredChords(const double* x, const double* y, const double* z, UnitVector p0, double* result, qsizetype size)
+{
+    for(qsizetype i=0; i<size; i++)
+    {
+        auto dx = x[i]-p0.x;
+        auto dy = y[i]-p0.y;
+        auto dz = z[i]-p0.z;
+        result[i] = dx*dx + dy*dy + dz*dz;
+    }
+}
+
+// Scalar products of v with the points (x[i], y[i], z[i])
+void scalarProducts(const double* x, const double* y, const double* z, UnitVector v, double* result, qsizetype size)
+{
+    for(qsizetype i=0; i<size; i++)
+    {
+        result[i] = x[i]*v.x + y[i]*v.y + z[i]*v.z;
+    }
+}
+
+} // namespace
+
+
+GeoMaps::CoordinateBatch::CoordinateBatch(const QList<QGeoCoordinate>& coordinates)
+{
+    reserve(coordinates.size());
+    for(const auto& coordinate : coordinates)
+    {
+        append(coordinate);
+    }
+}
+
+
+void GeoMaps::CoordinateBatch::append(const QGeoCoordinate& coordinate)
+{
+    if (!coordinate.isValid())
+    {
+        m_x.append(qQNaN());
+        m_y.append(qQNaN());
+        m_z.append(qQNaN());
+        return;
+    }
+    auto p = unitVector(coordinate);
+    m_x.append(p.x);
+    m_y.append(p.y);
+    m_z.append(p.z);
+}
+
+
+void GeoMaps::CoordinateBatch::reserve(qsizetype size)
+{
+    m_x.reserve(size);
+    m_y.reserve(size);
+    m_z.reserve(size);
+}
+
+
+QList<double> GeoMaps::CoordinateBatch::distancesFrom(const QGeoCoordinate& origin) const
+{
+    // The great-circle distance follows from the chord length c as
+    // 2 R asin(c/2). NaN entries propagate.
+    auto result = squaredChordsFrom(origin);
+    for(auto& distance : result)
+    {
+        distance = 2.0*earthRadiusInM*std::asin(0.5*std::sqrt(std::min(distance, 4.0)));
+    }
+    return result;
+}
+
+
+QList<double> GeoMaps::CoordinateBatch::azimuthsFrom(const QGeoCoordinate& origin) const
+{
+    auto numCoordinates = size();
+    if (!origin.isValid())
+    {
+        return QList<double>(numCoordinates, qQNaN());
+    }
+
+    // Unit vectors pointing east and north at origin. The components of a
+    // point along these vectors determine the initial course from origin.
+    auto lat0 = qDegreesToRadians(origin.latitude());
+    auto lon0 = qDegreesToRadians(origin.longitude());
+    UnitVector const east {-std::sin(lon0), std::cos(lon0), 0.0};
+    UnitVector const north {-std::sin(lat0)*std::cos(lon0), -std::sin(lat0)*std::sin(lon0), std::cos(lat0)};
+
+    QList<double> eastComponents(numCoordinates);
+    QList<double> result(numCoordinates);
+    scalarProducts(m_x.constData(), m_y.constData(), m_z.constData(), east, eastComponents.data(), numCoordinates);
+    scalarProducts(m_x.constData(), m_y.constData(), m_z.constData(), north, result.data(), numCoordinates);
+    for(qsizetype i=0; i<numCoordinates; i++)
+    {
+        auto azimuthInDEG = qRadiansToDegrees(std::atan2(eastComponents[i], result[i]));
+        result[i] = std::fmod(azimuthInDEG+360.0, 360.0);
+    }
+    return result;
+}
+
+
+qsizetype GeoMaps::CoordinateBatch::nearest(const QGeoCoordinate& origin) const
+{
+    // Chord lengths grow with distance, so there is no need to compute
+    // distances
+    auto chords = squaredChordsFrom(origin);
+
+    qsizetype result = -1;
+    for(qsizetype i=0; i<chords.size(); i++)
+    {
+        if (qIsNaN(chords[i]))
+        {
+            continue;
+        }
+        if ((result < 0) || (chords[i] < chords[result]))
+        {
+            result = i;
+        }
+    }
+    return result;
+}
+
+
+QList<double> GeoMaps::CoordinateBatch::squaredChordsFrom(const QGeoCoordinate& origin) const
+{
+    auto numCoordinates = size();
+    if (!origin.isValid())
+    {
+        return QList<double>(numCoordinates, qQNaN());
+    }
+
+    QList<double> result(numCoordinates);
+    squaredChords(m_x.constData(), m_y.constData(), m_z.constData(), unitVector(origin), result.data(), numCoordinates);
+    return result;
+}
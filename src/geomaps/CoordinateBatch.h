@@ -0,0 +1,175 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QGeoCoordinate>
+#include <QList>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+
+namespace GeoMaps
+{
+
+/*! \brief Batch of coordinates for fast distance and bearing computations
+ *
+ *  This class stores a list of coordinates as unit vectors in an
+ *  earth-centered frame, with separate arrays for the x, y and z components.
+ *  Distances and bearings from one point to all coordinates of the batch are
+ *  computed in two steps. First, a loop that contains only multiplications
+ *  and additions computes chord lengths or components of the unit vectors.
+ *  Compilers vectorize this loop in release builds. Second, a scalar loop
+ *  applies asin or atan2 where needed. Methods that only compare distances,
+ *  such as nearest() and sortByDistance(), skip the second step.
+ *
+ *  Conversions to unit vectors are computed only once, when coordinates are
+ *  appended, and the overhead of QGeoCoordinate is avoided. Results agree
+ *  with QGeoCoordinate::distanceTo and QGeoCoordinate::azimuthTo, which use
+ *  the same spherical earth model.
+ *
+ *  The class pays off for lists of many coordinates that are searched
+ *  repeatedly. For a handful of coordinates, QGeoCoordinate::distanceTo is
+ *  just as fast.
+ *
+ *  Sorting a list of N items by distance using QGeoCoordinate::distanceTo
+ *  in the comparator computes about 2 N log N distances. The method
+ *  sortByDistance() computes N chord lengths only.
+ */
+
+class CoordinateBatch
+{
+public:
+    /*! \brief Constructs an empty batch */
+    CoordinateBatch() = default;
+
+    /*! \brief Constructs a batch from a list of coordinates
+     *
+     *  @param coordinates List of coordinates, possibly invalid
+     */
+    explicit CoordinateBatch(const QList<QGeoCoordinate>& coordinates);
+
+    /*! \brief Append coordinate
+     *
+     *  @param coordinate Coordinate. Invalid coordinates are accepted and
+     *  have NaN distance and azimuth.
+     */
+    void append(const QGeoCoordinate& coordinate);
+
+    /*! \brief Reserve memory
+     *
+     *  @param size Number of coordinates
+     */
+    void reserve(qsizetype size);
+
+    /*! \brief Number of coordinates in the batch
+     *
+     *  @returns Number of coordinates
+     */
+    [[nodiscard]] qsizetype size() const { return m_x.size(); }
+
+    /*! \brief Distances from a given point
+     *
+     *  @param origin Point
+     *
+     *  @returns List of distances in meters, one for every coordinate in the
+     *  batch. Entries are NaN if origin or the coordinate is invalid.
+     */
+    [[nodiscard]] QList<double> distancesFrom(const QGeoCoordinate& origin) const;
+
+    /*! \brief Azimuths from a given point
+     *
+     *  @param origin Point
+     *
+     *  @returns List of initial courses from origin to the coordinates of the
+     *  batch, in degrees between 0 and 360. Entries are NaN if origin or the
+     *  coordinate is invalid.
+     */
+    [[nodiscard]] QList<double> azimuthsFrom(const QGeoCoordinate& origin) const;
+
+    /*! \brief Coordinate closest to a given point
+     *
+     *  @param origin Point
+     *
+     *  @returns Index of the coordinate closest to origin, or -1 if origin is
+     *  invalid or if the batch contains no valid coordinate
+     */
+    [[nodiscard]] qsizetype nearest(const QGeoCoordinate& origin) const;
+
+    /*! \brief Sort list by distance
+     *
+     *  Sorts a list so that items closest to origin come first. Items with
+     *  invalid coordinates come last. The sort is stable, so the order of the
+     *  list is left unchanged if origin is invalid.
+     *
+     *  @param list List to be sorted
+     *
+     *  @param origin Point
+     *
+     *  @param coordinateOf Function that returns the coordinate of an item
+     */
+    template<typename T, typename F>
+    static void sortByDistance(QList<T>& list, const QGeoCoordinate& origin, F coordinateOf)
+    {
+        CoordinateBatch batch;
+        batch.reserve(list.size());
+        for(const auto& item : std::as_const(list))
+        {
+            batch.append(coordinateOf(item));
+        }
+        auto chords = batch.squaredChordsFrom(origin);
+        for(auto& chord : chords)
+        {
+            if (qIsNaN(chord))
+            {
+                chord = std::numeric_limits<double>::infinity();
+            }
+        }
+
+        QList<qsizetype> order(list.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&chords](qsizetype a, qsizetype b) { return chords[a] < chords[b]; });
+
+        QList<T> result;
+        result.reserve(list.size());
+        for(auto index : order)
+        {
+            result.append(list[index]);
+        }
+        list = result;
+    }
+
+private:
+    // Squared lengths of the chords from origin to the coordinates, on the
+    // unit sphere. These grow with the distance. Entries are NaN if origin or
+    // the coordinate is invalid.
+    [[nodiscard]] QList<double> squaredChordsFrom(const QGeoCoordinate& origin) const;
+
+    // Components of the unit vectors of the coordinates. The components are
+    // NaN for invalid coordinates.
+    QList<double> m_x;
+    QList<double> m_y;
+    QList<double> m_z;
+};
+
+} // namespace GeoMaps
@@ -129,7 +129,7 @@ bool GeoMaps::GPX::isValid(const QString& fileName)
 
 auto GeoMaps::GPX::read(const QString& fileName) -> QVector<GeoMaps::Waypoint>
 {
-    auto file = FileFormats::DataFileAbstract::openFileURL(fileName);
+    auto file = FileFormats::DataFileAbstract::openSequentialFileURL(fileName);
     if (!file->open(QIODevice::ReadOnly))
     {
         return {};
@@ -31,7 +31,7 @@
 
 GeoMaps::GeoJSON::fileContent GeoMaps::GeoJSON::inspect(const QString& fileName)
 {
-    auto file = FileFormats::DataFileAbstract::openFileURL(fileName);
+    auto file = FileFormats::DataFileAbstract::openSequentialFileURL(fileName);
     if (!file->open(QIODevice::ReadOnly))
     {
         return GeoMaps::GeoJSON::invalid;
@@ -77,7 +77,7 @@ GeoMaps::GeoJSON::fileContent GeoMaps::GeoJSON::inspect(const QString& fileName)
 
 auto GeoMaps::GeoJSON::read(const QString &fileName) -> QVector<GeoMaps::Waypoint>
 {
-    auto file = FileFormats::DataFileAbstract::openFileURL(fileName);
+    auto file = FileFormats::DataFileAbstract::openSequentialFileURL(fileName);
     if (!file->open(QIODevice::ReadOnly))
     {
         return {};
@@ -31,6 +31,7 @@
 #include "Librarian.h"
 #include "dataManagement/DataManager.h"
 #include "fileFormats/MBTILES.h"
+#include "geomaps/CoordinateBatch.h"
 #include "geomaps/GeoMapProvider.h"
 #include "geomaps/WaypointLibrary.h"
 #include "navigation/Navigator.h"
@@ -166,10 +167,34 @@ auto GeoMaps::GeoMapProvider::styleFileURL() -> QString
 }
 
 
+//
+// Setter Methods
+//
+
+void GeoMaps::GeoMapProvider::setCurrentVAC(const GeoMaps::VAC& vac)
+{
+    if (vac == m_currentVAC)
+    {
+        return;
+    }
+    m_currentVAC = vac;
+    updateVACTiles();
+    emit currentVACChanged();
+}
+
+
+
 //
 // Methods
 //
 
+auto GeoMaps::GeoMapProvider::airspaces() -> QList<GeoMaps::Airspace>
+{
+    QMutexLocker const lock(&_aviationDataMutex);
+    return _airspaces_;
+}
+
+
 auto GeoMaps::GeoMapProvider::airspaces(const QGeoCoordinate& position) -> QVariantList
 {
     // Lock data
@@ -178,7 +203,7 @@ auto GeoMaps::GeoMapProvider::airspaces(const QGeoCoordinate& position) -> QVari
     QVector<Airspace> result;
     result.reserve(10);
     foreach(auto airspace, _airspaces_) {
-        if (airspace.polygon().contains(position)) {
+        if (airspace.contains(position)) {
             result.append(airspace);
         }
     }
@@ -196,48 +221,125 @@ auto GeoMaps::GeoMapProvider::airspaces(const QGeoCoordinate& position) -> QVari
 auto GeoMaps::GeoMapProvider::closestWaypoint(QGeoCoordinate position, const QGeoCoordinate& distPosition) -> Waypoint
 {
     position.setAltitude(qQNaN());
+    return closestWaypoints({position}, Units::Distance::fromM(position.distanceTo(distPosition))).value(0);
+}
 
-    Waypoint result;
-    const auto wayppoints = waypoints();
-    for(const auto& waypoint : wayppoints) {
-        if (!waypoint.isValid()) {
+auto GeoMaps::GeoMapProvider::closestWaypoints(const QList<QGeoCoordinate>& positions, Units::Distance maxDistance) -> QList<Waypoint>
+{
+    // Bounding box of the positions, enlarged by maxDistance
+    double latMin = 90.0;
+    double latMax = -90.0;
+    double lonMin = 180.0;
+    double lonMax = -180.0;
+    for(const auto& position : positions)
+    {
+        if (!position.isValid())
+        {
             continue;
         }
-        if (!result.isValid()) {
-            result = waypoint;
-        }
-        if (position.distanceTo(waypoint.coordinate()) < position.distanceTo(result.coordinate())) {
-            result = waypoint;
-        }
+        latMin = qMin(latMin, position.latitude());
+        latMax = qMax(latMax, position.latitude());
+        lonMin = qMin(lonMin, position.longitude());
+        lonMax = qMax(lonMax, position.longitude());
+    }
+    auto extraLat = qRadiansToDegrees(qMax(0.0, maxDistance.toM())/6371007.2);
+    latMin -= extraLat;
+    latMax += extraLat;
+    auto minCos = qMin(qCos(qDegreesToRadians(qBound(-90.0, latMin, 90.0))), qCos(qDegreesToRadians(qBound(-90.0, latMax, 90.0))));
+    bool checkLongitude = (latMin > -80.0) && (latMax < 80.0);
+    auto extraLon = 0.0;
+    if (checkLongitude)
+    {
+        extraLon = extraLat/minCos;
+        lonMin -= extraLon;
+        lonMax += extraLon;
+        checkLongitude = (lonMin > -180.0) && (lonMax < 180.0);
     }
 
-    const auto wpLibrary = GlobalObject::waypointLibrary()->waypoints();
-    for(const auto& wayppoint : wpLibrary) {
-        if (!wayppoint.isValid()) {
+    // Grid index of the candidates. Cells are at least maxDistance wide in
+    // both directions, so every waypoint within maxDistance of a position
+    // lies in the cell of the position or in one of the eight neighbouring
+    // cells. If longitudes cannot be bounded, the cells are bands of
+    // latitude.
+    auto cellLat = qMax(extraLat, 1e-6);
+    auto cellLon = qMax(extraLon, 1e-6);
+    auto cellOf = [&](const QGeoCoordinate& coordinate)
+    {
+        auto row = qFloor((coordinate.latitude()-latMin)/cellLat);
+        auto column = checkLongitude ? qFloor((coordinate.longitude()-lonMin)/cellLon) : 0;
+        return qMakePair(row, column);
+    };
+
+    // Collect candidates once, keeping only those within the bounding box
+    auto allCandidates = waypoints();
+    allCandidates += GlobalObject::waypointLibrary()->waypoints();
+    allCandidates += GlobalObject::navigator()->flightRoute()->midFieldWaypoints();
+
+    QList<Waypoint> candidates;
+    QHash<QPair<int,int>, QList<qsizetype>> grid;
+    for(const auto& waypoint : std::as_const(allCandidates))
+    {
+        if (!waypoint.isValid())
+        {
             continue;
         }
-        if (!result.isValid()) {
-            result = wayppoint;
+        auto coordinate = waypoint.coordinate();
+        if ((coordinate.latitude() < latMin) || (coordinate.latitude() > latMax))
+        {
+            continue;
         }
-        if (position.distanceTo(wayppoint.coordinate()) < position.distanceTo(result.coordinate())) {
-            result = wayppoint;
+        if (checkLongitude && ((coordinate.longitude() < lonMin) || (coordinate.longitude() > lonMax)))
+        {
+            continue;
         }
+        grid[cellOf(coordinate)] << candidates.size();
+        candidates << waypoint;
     }
 
-    for(auto& waypoint : GlobalObject::navigator()->flightRoute()->midFieldWaypoints() ) {
-        if (!waypoint.isValid()) {
-            continue;
+    // Resolve positions, looking only at candidates in neighbouring cells
+    QList<Waypoint> result;
+    result.reserve(positions.size());
+    for(auto position : positions)
+    {
+        position.setAltitude(qQNaN());
+
+        // If several candidates are equally close, the first one in the list
+        // of candidates wins, so map waypoints take precedence
+        qsizetype closest = -1;
+        auto closestDistance = maxDistance.toM();
+        if (position.isValid())
+        {
+            auto cell = cellOf(position);
+            for(auto row = cell.first-1; row <= cell.first+1; row++)
+            {
+                for(auto column = cell.second-1; column <= cell.second+1; column++)
+                {
+                    const auto indices = grid.value(qMakePair(row, column));
+                    for(auto index : indices)
+                    {
+                        auto distance = position.distanceTo(candidates[index].coordinate());
+                        if (distance > closestDistance)
+                        {
+                            continue;
+                        }
+                        if ((closest < 0) || (distance < closestDistance) || (index < closest))
+                        {
+                            closest = index;
+                            closestDistance = distance;
+                        }
+                    }
+                }
+            }
         }
-        if (position.distanceTo(waypoint.coordinate()) < position.distanceTo(result.coordinate())) {
-            result = waypoint;
+        if (closest >= 0)
+        {
+            result << candidates[closest];
+            continue;
         }
-    }
 
-    if (position.distanceTo(result.coordinate()) > position.distanceTo(distPosition)) {
         position.setAltitude( terrainElevationAMSL(position).toM() );
-        return {position};
+        result << Waypoint(position);
     }
-
     return result;
 }
 
@@ -406,7 +508,7 @@ auto GeoMaps::GeoMapProvider::nearbyWaypoints(const QGeoCoordinate& position, co
         tWps.append(waypoint);
     }
 
-    std::sort(tWps.begin(), tWps.end(), [position](const Waypoint& first, const Waypoint& second) {return position.distanceTo(first.coordinate()) < position.distanceTo(second.coordinate()); });
+    CoordinateBatch::sortByDistance(tWps, position, [](const Waypoint& waypoint) { return waypoint.coordinate(); });
 
     return tWps.mid(0,20);
 }
@@ -417,6 +519,15 @@ auto GeoMaps::GeoMapProvider::waypoints() -> QVector<Waypoint>
     return _waypoints_;
 }
 
+void GeoMaps::GeoMapProvider::onVACTilesGenerated(const QString& fileName)
+{
+    if (fileName == m_currentVAC.fileName)
+    {
+        updateVACTiles();
+    }
+}
+
+
 
 //
 // Private Methods and Slots
@@ -574,14 +685,17 @@ void GeoMaps::GeoMapProvider::fillAviationDataCache(QStringList JSONFileNames, U
         }
     }
 
-    // Create vectors of airspaces and waypoints
+    // Create vectors of airspaces and waypoints, and a new JSONArray of
+    // features. Every object is parsed only once.
     QVector<Airspace> newAirspaces;
     QVector<Waypoint> newWaypoints;
+    QJsonArray newFeatures;
     foreach(auto object, objectVector) {
         // Check if the current object is a waypoint. If so, add it to the list of waypoints.
         Waypoint const waypoint(object);
         if (waypoint.isValid()) {
             newWaypoints.append(waypoint);
+            newFeatures += object;
             continue;
         }
 
@@ -589,26 +703,17 @@ void GeoMaps::GeoMapProvider::fillAviationDataCache(QStringList JSONFileNames, U
         Airspace const airspace(object);
         if (airspace.isValid()) {
             newAirspaces.append(airspace);
-            continue;
         }
-    }
 
-    // Then, create a new JSONArray of features and a new list of waypoints
-    QJsonArray newFeatures;
-    foreach(auto object, objectVector) {
         // Ignore all objects that are airspaces and that begin above the airspaceAltitudeLimit.
-        Airspace const airspaceTest(object);
-        if (airspaceAltitudeLimit.isFinite() && (airspaceTest.estimatedLowerBoundMSL() > airspaceAltitudeLimit)) {
+        if (airspaceAltitudeLimit.isFinite() && (airspace.estimatedLowerBoundMSL() > airspaceAltitudeLimit)) {
             continue;
         }
 
         // If 'hideGlidingSector' is set, ignore all objects that are airspaces
         // and that are gliding sectors
-        if (hideGlidingSectors) {
-            Airspace const airspaceTest(object);
-            if (airspaceTest.CAT() == u"GLD"_qs) {
-                continue;
-            }
+        if (hideGlidingSectors && (airspace.CAT() == u"GLD"_qs)) {
+            continue;
         }
 
         newFeatures += object;
@@ -654,3 +759,27 @@ void GeoMaps::GeoMapProvider::fillAviationDataCache(QStringList JSONFileNames, U
     }
 
 }
+
+void GeoMaps::GeoMapProvider::updateVACTiles()
+{
+    _tileServer.removeMbtilesFileSet(_currentVACPath);
+    _currentVACPath.clear();
+
+    QString newURL;
+    if (m_currentVAC.hasTiles())
+    {
+        auto tiles = QSharedPointer<FileFormats::MBTILES>(new FileFormats::MBTILES(m_currentVAC.tilesFileName()));
+        if (tiles->format() == FileFormats::MBTILES::Raster)
+        {
+            _currentVACPath = QString::number(QRandomGenerator::global()->bounded(static_cast<quint32>(1000000000)));
+            _tileServer.addMbtilesFileSet(_currentVACPath, {tiles});
+            newURL = _tileServer.serverUrl()+"/"+_currentVACPath;
+        }
+    }
+
+    if (newURL != m_vacTilesURL)
+    {
+        m_vacTilesURL = newURL;
+        emit vacTilesURLChanged();
+    }
+}
@@ -128,6 +128,23 @@ public:
     /*! \brief List of terrain map MBTILES */
     Q_PROPERTY(QList<QSharedPointer<FileFormats::MBTILES>> terrainMapTiles READ terrainMapTiles NOTIFY terrainMapTilesChanged)
 
+    /*! \brief VAC shown on the map
+     *
+     *  Set this property to the VAC that is shown on the map, in order to
+     *  have its tiles served. See vacTilesURL.
+     */
+    Q_PROPERTY(GeoMaps::VAC currentVAC READ currentVAC WRITE setCurrentVAC NOTIFY currentVACChanged)
+
+    /*! \brief URL of the TileJSON file describing the tiles of currentVAC
+     *
+     *  This property is empty if currentVAC has no tiles. It is updated when
+     *  currentVAC changes, and when tiles for currentVAC have been generated
+     *  in the background. To avoid that the map shows cached tiles of a
+     *  different chart, the tiles are served under a path that changes
+     *  whenever the property changes.
+     */
+    Q_PROPERTY(QString vacTilesURL READ vacTilesURL NOTIFY vacTilesURLChanged)
+
     /*! \brief Waypoints
      *
      * A list of all waypoints known to this GeoMapProvider (that is,
@@ -165,6 +182,12 @@ public:
      */
     [[nodiscard]] static auto copyrightNotice() -> QString;
 
+    /*! \brief Getter function for the property with the same name
+     *
+     * @returns Property currentVAC
+     */
+    [[nodiscard]] auto currentVAC() const -> GeoMaps::VAC { return m_currentVAC; }
+
     /*! \brief Getter function for the property with the same name
      *
      * @returns Property geoJSON
@@ -186,6 +209,12 @@ public:
         return m_terrainMapTiles;
     }
 
+    /*! \brief Getter function for the property with the same name
+     *
+     * @returns Property vacTilesURL
+     */
+    [[nodiscard]] auto vacTilesURL() const -> QString { return m_vacTilesURL; }
+
     /*! \brief Getter function for the property with the same name
      *
      * @returns Property waypoints
@@ -194,6 +223,18 @@ public:
 
 
 
+    //
+    // Setter Methods
+    //
+
+    /*! \brief Setter function for the property with the same name
+     *
+     * @param vac Property currentVAC
+     */
+    void setCurrentVAC(const GeoMaps::VAC& vac);
+
+
+
     //
     // Methods
     //
@@ -208,6 +249,12 @@ public:
      */
     Q_INVOKABLE QVariantList airspaces(const QGeoCoordinate &position);
 
+    /*! \brief List of all airspaces
+     *
+     * @returns all airspaces that are currently known
+     */
+    [[nodiscard]] QList<GeoMaps::Airspace> airspaces();
+
     /*! \brief Find closest waypoint to a given position
      *
      * @param position Position near which waypoints are searched for
@@ -222,6 +269,27 @@ public:
      */
     Q_INVOKABLE GeoMaps::Waypoint closestWaypoint(QGeoCoordinate position, const QGeoCoordinate &distPosition);
 
+    /*! \brief Find closest waypoints to a list of positions
+     *
+     * This method is equivalent to calling closestWaypoint() for every
+     * position, but much faster for long lists. The list of candidate
+     * waypoints is assembled only once, and candidates that are not within
+     * maxDistance of the bounding box of the positions are discarded. The
+     * remaining candidates are sorted into a grid whose cells are maxDistance
+     * wide, so that every position is compared only with the candidates in
+     * its own and the neighbouring cells.
+     *
+     * @param positions Positions near which waypoints are searched for
+     *
+     * @param maxDistance Maximal distance between position and waypoint
+     *
+     * @returns List of waypoints, one for every position. For every position,
+     * this is the closest waypoint, provided that the distance is not bigger
+     * than maxDistance. Otherwise, it is a generic Waypoint with the
+     * appropriate coordinate.
+     */
+    [[nodiscard]] QList<GeoMaps::Waypoint> closestWaypoints(const QList<QGeoCoordinate>& positions, Units::Distance maxDistance);
+
     /*! \brief Create invalid waypoint
      *
      *  This is a helper method for QML, where creation of waypoint objects
@@ -243,6 +311,16 @@ public:
      */
     [[nodiscard]] Q_INVOKABLE Units::Distance terrainElevationAMSL(const QGeoCoordinate& coordinate);
 
+    /*! \brief Handle newly generated VAC tiles
+     *
+     *  This method is called by VACLibrary whenever tiles for a VAC have been
+     *  generated. If the tiles belong to currentVAC, they are served and the
+     *  property vacTilesURL is updated.
+     *
+     *  @param fileName Name of the raster image file of the VAC
+     */
+    void onVACTilesGenerated(const QString& fileName);
+
     /*! \brief Create empty GeoJSON document
      *
      *  @returns Empty, but valid GeoJSON document
@@ -295,6 +373,12 @@ signals:
     /*! \brief Notification signal for the property with the same name */
     void terrainMapTilesChanged();
 
+    /*! \brief Notification signal for the property with the same name */
+    void currentVACChanged();
+
+    /*! \brief Notification signal for the property with the same name */
+    void vacTilesURLChanged();
+
     /*! \brief Notification signal for the property with the same name */
     void waypointsChanged();
 
@@ -309,6 +393,11 @@ private:
     // sets up the tile server to and generates a new style file.
     void onMBTILESChanged();
 
+    // Serves the tiles of m_currentVAC, if any, under a new path and updates
+    // m_vacTilesURL. Tiles of the VAC served previously are no longer
+    // available. Emits vacTilesURLChanged() as appropriate.
+    void updateVACTiles();
+
     // Interal function that does most of the work for aviationMapsChanged()
     // emits geoJSONChanged() when done. This function is meant to be run in a
     // separate thread.
@@ -323,10 +412,15 @@ private:
     // files changes
     QString _currentBaseMapPath;
     QString _currentTerrainMapPath;
+    QString _currentVACPath;
 
     // Tile Server
     TileServer _tileServer;
 
+    // VAC shown on the map, and URL under which its tiles are served
+    GeoMaps::VAC m_currentVAC;
+    QString m_vacTilesURL;
+
     // Temporary file that holds the current style file
     QPointer<QTemporaryFile> m_styleFile;
 
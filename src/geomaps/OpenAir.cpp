@@ -508,7 +508,7 @@ QJsonDocument GeoMaps::openAir::parse(const QString& fileName, QStringList& erro
     AirSpaceVector airSpaceVector;
 
 
-    auto inputFile = FileFormats::DataFileAbstract::openFileURL(fileName);
+    auto inputFile = FileFormats::DataFileAbstract::openSequentialFileURL(fileName);
     if (!inputFile->open(QIODeviceBase::ReadOnly))
     {
         errorList << QObject::tr("Cannot open file %1", "OpenAir").arg(fileName);
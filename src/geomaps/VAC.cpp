@@ -92,6 +92,12 @@ QString GeoMaps::VAC::infoText() const
     return result;
 }
 
+bool GeoMaps::VAC::hasTiles() const
+{
+    auto tiles = tilesFileName();
+    return !tiles.isEmpty() && QFile::exists(tiles);
+}
+
 bool GeoMaps::VAC::isValid() const
 {
     return hasValidCoordinates()
@@ -99,6 +105,16 @@ bool GeoMaps::VAC::isValid() const
            && !name.isEmpty();
 }
 
+QString GeoMaps::VAC::tilesFileName() const
+{
+    if (fileName.isEmpty())
+    {
+        return {};
+    }
+    QFileInfo const fileInfo(fileName);
+    return fileInfo.path() + u"/Tiles/"_qs + fileInfo.completeBaseName() + u".mbtiles"_qs;
+}
+
 
 
 //
@@ -102,6 +102,12 @@ public:
      */
     Q_PROPERTY(QString infoText READ infoText)
 
+    /*! \brief Existence of tiled raster data
+     *
+     * This property is true if the file 'tilesFileName' exists.
+     */
+    Q_PROPERTY(bool hasTiles READ hasTiles)
+
     /*! \brief Validity
      *
      * The VAC is considered valid if all corner coordinate are valid, the file 'fileName' exists and
@@ -127,6 +133,16 @@ public:
     /*! \brief Name of raster image file */
     Q_PROPERTY(QString fileName MEMBER fileName)
 
+    /*! \brief Name of the MBTILES file with tiled raster data
+     *
+     * Once a VAC has been imported, the raster image is converted into a
+     * pyramid of tiles at several zoom levels, so that the map needs to load
+     * only the visible part of the chart, at the resolution required. This
+     * property holds the name of the file that stores the tiles. The file
+     * might not exist. The property is empty if fileName is empty.
+     */
+    Q_PROPERTY(QString tilesFileName READ tilesFileName)
+
 
     //
     // Getter Methods
@@ -150,12 +166,24 @@ public:
      */
     [[nodiscard]] QString infoText() const;
 
+    /*! \brief Getter function for property of the same name
+     *
+     * @returns Property hasTiles
+     */
+    [[nodiscard]] bool hasTiles() const;
+
     /*! \brief Getter function for property of the same name
      *
      * @returns Property isValid
      */
     [[nodiscard]] bool isValid() const;
 
+    /*! \brief Getter function for property of the same name
+     *
+     * @returns Property tilesFileName
+     */
+    [[nodiscard]] QString tilesFileName() const;
+
 
 
     //
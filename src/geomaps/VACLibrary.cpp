@@ -20,11 +20,17 @@
 
 #include <QCoreApplication>
 #include <QDirIterator>
-#include <QImage>
+#include <QImageReader>
+#include <QMutex>
 #include <QTemporaryDir>
 #include <QTimer>
+#include <QtConcurrent>
 
+#include "GlobalObject.h"
 #include "VACLibrary.h"
+#include "geomaps/CoordinateBatch.h"
+#include "geomaps/GeoMapProvider.h"
+#include "geomaps/VACTiler.h"
 #include "fileFormats/TripKit.h"
 
 
@@ -39,6 +45,10 @@ GeoMaps::VACLibrary::VACLibrary(QObject *parent)
     // Wire up: Save library whenever the content changes
     connect(this, &GeoMaps::VACLibrary::dataChanged, this, &GeoMaps::VACLibrary::save, Qt::QueuedConnection);
 
+    // Wire up: Generate tiles for new VACs, and serve new tiles on the map
+    connect(this, &GeoMaps::VACLibrary::dataChanged, this, &GeoMaps::VACLibrary::generateTiles, Qt::QueuedConnection);
+    connect(this, &GeoMaps::VACLibrary::tilesGenerated, GlobalObject::geoMapProvider(), &GeoMaps::GeoMapProvider::onVACTilesGenerated);
+
     // Restore previously saves VAC library
     if (m_dataFile.open(QIODeviceBase::ReadOnly))
     {
@@ -53,6 +63,13 @@ GeoMaps::VACLibrary::VACLibrary(QObject *parent)
 
 GeoMaps::VACLibrary::~VACLibrary()
 {
+    if (m_tripKitImportCanceled)
+    {
+        *m_tripKitImportCanceled = true;
+    }
+    m_tripKitImport.waitForFinished();
+    m_tileGenerationCanceled = true;
+    m_tileGeneration.waitForFinished();
     save();
 }
 
@@ -74,6 +91,15 @@ QVector<GeoMaps::VAC> GeoMaps::VACLibrary::vacs()
 // Methods
 //
 
+void GeoMaps::VACLibrary::cancelTripKitImport()
+{
+    if (m_tripKitImportCanceled)
+    {
+        *m_tripKitImportCanceled = true;
+    }
+}
+
+
 void GeoMaps::VACLibrary::clear()
 {
     if (m_vacs.isEmpty())
@@ -83,6 +109,7 @@ void GeoMaps::VACLibrary::clear()
     foreach(auto vac, m_vacs)
     {
         QFile::remove(vac.fileName);
+        QFile::remove(vac.tilesFileName());
     }
     m_vacs.clear();
     emit dataChanged();
@@ -100,54 +127,105 @@ GeoMaps::VAC GeoMaps::VACLibrary::get(const QString& name)
     return {};
 }
 
-QString GeoMaps::VACLibrary::importTripKit(const QString& fileName)
+void GeoMaps::VACLibrary::importTripKit(const QString& fileName)
 {
-    // Open Trip Kit
-    FileFormats::TripKit tripKit(fileName);
-    if (!tripKit.isValid())
+    if (m_tripKitImport.isRunning())
     {
-        return tr("Unable to open TripKit file <strong>%1</strong>. Error: %2.").arg(fileName, tripKit.error());
+        return;
     }
 
-    // Create directory
+    // Charts are extracted into a staging directory next to the library, so
+    // that they can be moved into the library without copying
     QDir const dir;
     dir.mkpath(m_vacDirectory);
+    auto stagingDirectory = QSharedPointer<QTemporaryDir>::create(m_vacDirectory + u"/.import-XXXXXX"_qs);
+
+    auto canceled = std::make_shared<std::atomic<bool>>(false);
+    m_tripKitImportCanceled = canceled;
+    emit importTripKitStatus(0.0);
 
-    // Unpack the VACs into m_vacDirectory
-    auto size = tripKit.numCharts();
-    int successfulImports = 0;
-    for(auto idx=0; idx<size; idx++)
+    m_tripKitImport = QtConcurrent::run([this, fileName, stagingDirectory, canceled]() -> QString
     {
-        emit importTripKitStatus((double)idx/(double)size);
-        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+        // Open Trip Kit
+        FileFormats::TripKit tripKit(fileName);
+        if (!tripKit.isValid())
+        {
+            return tr("Unable to open TripKit file <strong>%1</strong>. Error: %2.").arg(fileName, tripKit.error());
+        }
+        if (!stagingDirectory->isValid())
+        {
+            return tr("Error: Unable to write the VAC file <strong>%1</strong>.").arg(stagingDirectory->path());
+        }
+
+        // Number of charts handed to the library in one batch
+        constexpr qsizetype batchSize = 8;
 
-        auto vac = tripKit.extract(m_vacDirectory, idx);
-        if (!vac.isValid())
+        auto size = tripKit.numCharts();
+        QMutex mutex;
+        QVector<GeoMaps::VAC> batch;
+        qsizetype processed = 0;
+        qsizetype successfulImports = 0;
+        int percent = 0;
+
+        // Hands a batch of charts to the library, on the GUI thread
+        auto commit = [this, stagingDirectory](const QVector<GeoMaps::VAC>& vacs)
         {
-            continue;
+            QMetaObject::invokeMethod(this, [this, vacs, stagingDirectory]() { addVACs(vacs); }, Qt::QueuedConnection);
+        };
+
+        tripKit.extractParallel(stagingDirectory->path(), [&](qsizetype /*index*/, const GeoMaps::VAC& vac)
+        {
+            QMutexLocker const locker(&mutex);
+            processed++;
+            if (vac.isValid())
+            {
+                successfulImports++;
+                batch.append(vac);
+            }
+            if (batch.size() >= batchSize)
+            {
+                commit(batch);
+                batch.clear();
+            }
+            auto newPercent = static_cast<int>(100*processed/qMax(qsizetype(1), size));
+            if (newPercent != percent)
+            {
+                percent = newPercent;
+                QMetaObject::invokeMethod(this, [this, newPercent]() { emit importTripKitStatus(0.01*newPercent); }, Qt::QueuedConnection);
+            }
+            return !*canceled;
+        });
+
+        // Charts in the last batch are only added if the import has not been
+        // canceled
+        if (*canceled)
+        {
+            successfulImports -= batch.size();
+            return tr("Import canceled: %1 out of %2 charts were imported.").arg(successfulImports).arg(size);
         }
-        auto oldVac = get(vac.name);
-        if (oldVac.isValid())
+        if (!batch.isEmpty())
         {
-            m_vacs.removeAll(oldVac);
+            commit(batch);
         }
 
-        m_vacs.append(vac);
-        successfulImports++;
-    }
-    emit importTripKitStatus(1.0);
-    emit dataChanged();
+        if (successfulImports == 0)
+        {
+            return tr("Error reading TripKip: No charts imported.");
+        }
+        if (successfulImports < size)
+        {
+            return tr("Error reading TripKip: Only %1 out of %2 charts were successfully imported.").arg(successfulImports).arg(size);
+        }
+        return {};
+    });
 
-    if (successfulImports == 0)
+    m_tripKitImport.then(this, [this](const QString& errorString)
     {
-        return tr("Error reading TripKip: No charts imported.");
-    }
-    if (successfulImports < size)
-    {
-        return tr("Error reading TripKip: Only %1 out of %2 charts were successfully imported.").arg(successfulImports).arg(size);
-    }
-
-    return {};
+        emit importTripKitStatus(1.0);
+        emit importingTripKitChanged();
+        emit importTripKitFinished(errorString);
+    });
+    emit importingTripKitChanged();
 }
 
 QString GeoMaps::VACLibrary::importVAC(const QString& fileName, const QString& newName)
@@ -166,8 +244,11 @@ QString GeoMaps::VACLibrary::importVAC(const QString& fileName, const QString& n
     {
         return tr("Input file <strong>%1</strong> does not contain a valid chart.").arg(_fileName);
     }
-    QImage const image(_fileName);
-    if (image.isNull())
+    // Check that the raster data can be read. The image header is read
+    // without decoding the pixels; raster data is decoded only if the file
+    // needs to be converted.
+    QImageReader imageReader(_fileName);
+    if (!imageReader.canRead() || !imageReader.size().isValid())
     {
         return tr("Unable to read raster image data from the input file <strong>%1</strong>.").arg(_fileName);
     }
@@ -201,14 +282,22 @@ QString GeoMaps::VACLibrary::importVAC(const QString& fileName, const QString& n
     }
     else
     {
+        auto const image = imageReader.read();
+        if (image.isNull())
+        {
+            return tr("Unable to read raster image data from the input file <strong>%1</strong>.").arg(_fileName);
+        }
         if (!image.save(newFileName))
         {
             return tr("Error: Unable to write the VAC file <strong>%1</strong>.").arg(newFileName);
         }
     }
 
-    // Set new file name and add to library
+    // Set new file name and add to library. Tiles of a previous chart with
+    // the same file name are outdated.
     vac.fileName = newFileName;
+    QFile::remove(vac.tilesFileName());
+    m_tileGenerationFailed.remove(newFileName);
     m_vacs.append(vac);
 
     emit dataChanged();
@@ -235,6 +324,7 @@ void GeoMaps::VACLibrary::remove(const QString& baseName)
     foreach (auto vac, vacsToDelete)
     {
         QFile::remove(vac.fileName);
+        QFile::remove(vac.tilesFileName());
         m_vacs.removeAll(vac);
     }
     emit dataChanged();
@@ -258,7 +348,10 @@ QString GeoMaps::VACLibrary::rename(const QString& oldName, const QString& newNa
 
     // Remove old VAC from list, update data and add agaib
     m_vacs.removeAll(vac);
+    auto oldTilesFileName = vac.tilesFileName();
     vac.fileName = newFileName;
+    QFile::remove(vac.tilesFileName());
+    QFile::rename(oldTilesFileName, vac.tilesFileName());
     vac.name = newName;
     m_vacs.append(vac);
 
@@ -268,7 +361,7 @@ QString GeoMaps::VACLibrary::rename(const QString& oldName, const QString& newNa
 
 QVector<GeoMaps::VAC> GeoMaps::VACLibrary::vacsByDistance(const QGeoCoordinate& position)
 {
-    std::sort(m_vacs.begin(), m_vacs.end(), [position](const GeoMaps::VAC& first, const GeoMaps::VAC& second) {return position.distanceTo(first.center()) < position.distanceTo(second.center()); });
+    CoordinateBatch::sortByDistance(m_vacs, position, [](const GeoMaps::VAC& vac) { return vac.center(); });
     return m_vacs;
 }
 
@@ -328,10 +421,129 @@ void GeoMaps::VACLibrary::janitor()
         QFile::remove(fInfo.fileName());
     }
 
+    // Remove staging directories left behind by interrupted trip kit imports
+    if (!m_tripKitImport.isRunning())
+    {
+        QDirIterator dirIterator(m_vacDirectory, {u".import-*"_qs}, QDir::Dirs|QDir::Hidden|QDir::NoDotAndDotDot);
+        while (dirIterator.hasNext())
+        {
+            QDir(dirIterator.next()).removeRecursively();
+        }
+    }
+
+    if (!m_tileGeneration.isRunning())
+    {
+        removeOrphanedTiles();
+    }
+
     if (hasChange)
     {
         emit dataChanged();
     }
+    else
+    {
+        generateTiles();
+    }
+}
+
+void GeoMaps::VACLibrary::addVACs(const QVector<GeoMaps::VAC>& vacs)
+{
+    if (vacs.isEmpty())
+    {
+        return;
+    }
+
+    foreach(auto vac, vacs)
+    {
+        auto newFileName = m_vacDirectory + "/" + QFileInfo(vac.fileName).fileName();
+        QFile::remove(newFileName);
+        if (!QFile::rename(vac.fileName, newFileName))
+        {
+            continue;
+        }
+        vac.fileName = newFileName;
+        QFile::remove(vac.tilesFileName());
+        m_tileGenerationFailed.remove(newFileName);
+
+        auto oldVac = get(vac.name);
+        if (oldVac.isValid())
+        {
+            m_vacs.removeAll(oldVac);
+        }
+        m_vacs.append(vac);
+    }
+    emit dataChanged();
+}
+
+void GeoMaps::VACLibrary::generateTiles()
+{
+    if (m_tileGeneration.isRunning())
+    {
+        return;
+    }
+
+    QVector<GeoMaps::VAC> vacsWithoutTiles;
+    foreach(auto vac, m_vacs)
+    {
+        if (!vac.hasTiles() && !m_tileGenerationFailed.contains(vac.fileName))
+        {
+            vacsWithoutTiles.append(vac);
+        }
+    }
+    if (vacsWithoutTiles.isEmpty())
+    {
+        return;
+    }
+
+    m_tileGeneration = QtConcurrent::run([this, vacsWithoutTiles]()
+    {
+        QStringList failed;
+        foreach(auto vac, vacsWithoutTiles)
+        {
+            if (m_tileGenerationCanceled)
+            {
+                break;
+            }
+            if (!GeoMaps::VACTiler::createTiles(vac, m_tileGenerationCanceled).isEmpty())
+            {
+                failed.append(vac.fileName);
+                continue;
+            }
+            QMetaObject::invokeMethod(this, [this, fileName = vac.fileName]() { emit tilesGenerated(fileName); }, Qt::QueuedConnection);
+        }
+        return failed;
+    });
+
+    m_tileGeneration.then(this, [this](const QStringList& failed)
+    {
+        foreach(auto fileName, failed)
+        {
+            m_tileGenerationFailed += fileName;
+        }
+
+        // VACs might have been removed or renamed while their tiles were generated
+        removeOrphanedTiles();
+        generateTiles();
+    });
+}
+
+void GeoMaps::VACLibrary::removeOrphanedTiles()
+{
+    QSet<QString> tilesFileNames;
+    foreach(auto vac, m_vacs)
+    {
+        tilesFileNames += QFileInfo(vac.tilesFileName()).absoluteFilePath();
+    }
+
+    QDirIterator fileIterator(m_vacDirectory + u"/Tiles"_qs, QDir::Files);
+    while (fileIterator.hasNext())
+    {
+        fileIterator.next();
+        if (!tilesFileNames.contains(fileIterator.fileInfo().absoluteFilePath()))
+        {
+            QFile::remove(fileIterator.filePath());
+        }
+    }
 }
 
 void GeoMaps::VACLibrary::save()
@@ -21,7 +21,11 @@
 #pragma once
 
 #include <QFile>
+#include <QFuture>
+#include <QSet>
 #include <QStandardPaths>
+#include <atomic>
+#include <memory>
 
 #include "geomaps/VAC.h"
 
@@ -55,6 +59,9 @@ public:
     // Properties
     //
 
+    /*! \brief True while a trip kit is being imported */
+    Q_PROPERTY(bool importingTripKit READ importingTripKit NOTIFY importingTripKitChanged)
+
     /*! \brief True if library is empty. */
     Q_PROPERTY(bool isEmpty READ isEmpty NOTIFY dataChanged)
 
@@ -69,6 +76,12 @@ public:
     // Getter Methods
     //
 
+    /*! \brief Getter function for property of the same name
+     *
+     * @returns Property importingTripKit
+     */
+    [[nodiscard]] bool importingTripKit() const { return m_tripKitImport.isRunning(); }
+
     /*! \brief Getter function for property of the same name
      *
      * @returns Property isEmpty
@@ -87,6 +100,14 @@ public:
     // Methods
     //
 
+    /*! \brief Cancel trip kit import
+     *
+     *  This method stops a running trip kit import. Charts that have already
+     *  been added to the library are kept. The signal
+     *  importTripKitFinished() is emitted once the import has stopped.
+     */
+    Q_INVOKABLE void cancelTripKitImport();
+
     /*! \brief Removes all VACs
      *
      *  This method also deletes the associated files.
@@ -103,11 +124,17 @@ public:
 
     /*! \brief Import trip kit
      *
-     *  @param fileName Name of the trip kit file
+     *  This method starts importing a trip kit in the background and returns
+     *  immediately. Charts are extracted and converted on several cores. They
+     *  are added to the library in batches, so that the library never
+     *  contains partially written charts. Progress is reported via the
+     *  signal importTripKitStatus(), and the signal importTripKitFinished()
+     *  is emitted at the end. If an import is already running, this method
+     *  does nothing.
      *
-     *  @returns A localized error message, or an empty string on success
+     *  @param fileName Name of the trip kit file
      */
-    [[nodiscard]] Q_INVOKABLE QString importTripKit(const QString& fileName);
+    Q_INVOKABLE void importTripKit(const QString& fileName);
 
     /*! \brief Import VAC
      *
@@ -162,6 +189,28 @@ signals:
      */
     void importTripKitStatus(double percent);
 
+    /*! \brief Trip kit import finished
+     *
+     *  This signal is emitted when a trip kit import started by
+     *  importTripKit() has ended, successfully or not.
+     *
+     *  @param errorString A localized error message, or an empty string on
+     *  success
+     */
+    void importTripKitFinished(const QString& errorString);
+
+    /*! \brief Notifier signal */
+    void importingTripKitChanged();
+
+    /*! \brief Tiles generated
+     *
+     *  This signal is emitted whenever tiles for a VAC have been generated in
+     *  the background.
+     *
+     *  @param fileName Name of the raster image file of the VAC
+     */
+    void tilesGenerated(const QString& fileName);
+
 private:
     Q_DISABLE_COPY_MOVE(VACLibrary)
 
@@ -173,6 +222,31 @@ private:
     // This method saves m_vacs to m_dataFile.
     void save();
 
+    // Starts generating tiles in the background for all VACs that do not
+    // have tiles yet. VACs are processed one after the other, to bound memory
+    // consumption. When done, the method is called again to handle VACs that
+    // have been added in the meantime. Does nothing if tiles are already
+    // being generated.
+    void generateTiles();
+
+    // Deletes all tiles files that do not belong to a VAC in the library
+    void removeOrphanedTiles();
+
+    // Moves the image files of the VACs into m_vacDirectory and adds the VACs
+    // to the library, replacing VACs of the same name. The signal
+    // dataChanged() is emitted once.
+    void addVACs(const QVector<GeoMaps::VAC>& vacs);
+
+    // Trip kit import running in the background, and flag used to cancel it
+    QFuture<QString> m_tripKitImport;
+    std::shared_ptr<std::atomic<bool>> m_tripKitImportCanceled;
+
+    // Tile generation running in the background, flag used to cancel it, and
+    // image files for which tile generation failed
+    QFuture<QStringList> m_tileGeneration;
+    std::atomic<bool> m_tileGenerationCanceled {false};
+    QSet<QString> m_tileGenerationFailed;
+
     QVector<GeoMaps::VAC> m_vacs;
     QString m_vacDirectory {QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/VAC"};
     QFile m_dataFile {QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/VAC.data"};
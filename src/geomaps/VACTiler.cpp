@@ -0,0 +1,224 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QBuffer>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QtMath>
+
+#include "fileFormats/MBTILES.h"
+#include "geomaps/VACTiler.h"
+
+
+namespace {
+
+// Edge length of tiles, in pixels
+constexpr int tileSize = 256;
+
+// Zoom levels. Tiles are always generated down to zoom level 6, which is the
+// minimal zoom level that the TileServer announces to the map. The maximal
+// zoom level is chosen to match the resolution of the raster image, but never
+// below 10, which is the maximal zoom level that the TileServer announces.
+constexpr int smallestMinZoom = 6;
+constexpr int smallestMaxZoom = 10;
+constexpr int largestMaxZoom = 18;
+
+// Web Mercator projection of a coordinate. The world is mapped to the unit
+// square, with (0,0) in the north-west corner.
+QPointF mercator(const QGeoCoordinate& coordinate)
+{
+    auto lat = qDegreesToRadians(qBound(-85.0511, coordinate.latitude(), 85.0511));
+    return {(coordinate.longitude() + 180.0)/360.0,
+            (1.0 - qLn(qTan(lat) + 1.0/qCos(lat))/M_PI)/2.0};
+}
+
+} // namespace
+
+
+QString GeoMaps::VACTiler::createTiles(const GeoMaps::VAC& vac, const std::atomic<bool>& canceled)
+{
+    QFileInfo const imageInfo(vac.fileName);
+    auto lastModified = imageInfo.lastModified();
+
+    QImage image(vac.fileName);
+    if (!vac.isValid() || image.isNull())
+    {
+        return QObject::tr("Unable to read raster image data from the file <strong>%1</strong>.", "GeoMaps::VACTiler").arg(vac.fileName);
+    }
+    image.convertTo(QImage::Format_ARGB32_Premultiplied);
+
+    // Corners of the raster image in Web Mercator coordinates, in the same
+    // order as the corners of the image rectangle
+    QPolygonF const mercatorQuad({mercator(vac.topLeft),
+                                  mercator(vac.topRight),
+                                  mercator(vac.bottomRight),
+                                  mercator(vac.bottomLeft)});
+    auto bounds = mercatorQuad.boundingRect();
+    auto mercatorWidth = QLineF(mercatorQuad[0], mercatorQuad[1]).length();
+    auto mercatorHeight = QLineF(mercatorQuad[0], mercatorQuad[3]).length();
+    if (qFuzzyIsNull(mercatorWidth) || qFuzzyIsNull(mercatorHeight))
+    {
+        return QObject::tr("The chart <strong>%1</strong> has invalid corner coordinates.", "GeoMaps::VACTiler").arg(vac.name);
+    }
+
+    // Resolution of the raster image, in pixels per unit of Web Mercator
+    // coordinates. Pick the smallest zoom level whose resolution is at least
+    // as good as that of the raster image.
+    auto imageResolution = [&](const QImage& img)
+    {
+        return 0.5*(img.width()/mercatorWidth + img.height()/mercatorHeight);
+    };
+    auto maxZoom = qBound(smallestMaxZoom,
+                          qCeil(std::log2(imageResolution(image)/tileSize)),
+                          largestMaxZoom);
+    auto minZoom = qBound(0,
+                          qFloor(std::log2(1.0/qMax(bounds.width(), bounds.height()))),
+                          smallestMinZoom);
+
+    // List tiles that intersect the chart, with the highest zoom level first
+    QStringList tileKeys;
+    for(auto zoom = maxZoom; zoom >= minZoom; zoom--)
+    {
+        auto numTiles = 1 << zoom;
+        auto xMin = qBound(0, qFloor(bounds.left()*numTiles), numTiles-1);
+        auto xMax = qBound(0, qFloor(bounds.right()*numTiles), numTiles-1);
+        auto yMin = qBound(0, qFloor(bounds.top()*numTiles), numTiles-1);
+        auto yMax = qBound(0, qFloor(bounds.bottom()*numTiles), numTiles-1);
+        for(auto x = xMin; x <= xMax; x++)
+        {
+            for(auto y = yMin; y <= yMax; y++)
+            {
+                QPolygonF const tileRect(QRectF(double(x)/numTiles, double(y)/numTiles, 1.0/numTiles, 1.0/numTiles));
+                if (tileRect.intersects(mercatorQuad))
+                {
+                    tileKeys.append(QStringLiteral("%1/%2/%3").arg(zoom).arg(x).arg(y));
+                }
+            }
+        }
+    }
+
+    // Render tiles. Since tiles are requested zoom level by zoom level, only
+    // one downsampled copy of the raster image needs to be kept in memory.
+    // The image is downsampled in steps of two with smooth transformation, so
+    // that the bilinear filtering used when rendering a tile does not alias.
+    // The full-resolution image is moved into levelImage, so that it is
+    // released as soon as the first downsampled copy exists.
+    auto levelImage = std::move(image);
+    auto levelZoom = -1;
+    auto tileData = [&](const QString& key) -> std::optional<QByteArray>
+    {
+        if (canceled)
+        {
+            return std::nullopt;
+        }
+
+        auto parts = key.split(u'/');
+        auto zoom = parts[0].toInt();
+        auto x = parts[1].toInt();
+        auto y = parts[2].toInt();
+
+        auto worldSize = double(tileSize)*(1 << zoom);
+        if (zoom != levelZoom)
+        {
+            levelZoom = zoom;
+            while ((imageResolution(levelImage) > 2.0*worldSize) && (levelImage.width() > 1) && (levelImage.height() > 1))
+            {
+                levelImage = levelImage.scaled(levelImage.width()/2, levelImage.height()/2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            }
+        }
+
+        // Map the image rectangle to the position of the chart within the tile
+        QPolygonF tileQuad;
+        foreach(auto point, mercatorQuad)
+        {
+            tileQuad.append(point*worldSize - QPointF(x*tileSize, y*tileSize));
+        }
+        QTransform transform;
+        if (!QTransform::quadToQuad(QPolygonF(QRectF(levelImage.rect())), tileQuad, transform))
+        {
+            return std::nullopt;
+        }
+
+        QImage tile(tileSize, tileSize, QImage::Format_ARGB32_Premultiplied);
+        tile.fill(Qt::transparent);
+        QPainter painter(&tile);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.setTransform(transform);
+        painter.drawImage(0, 0, levelImage);
+        painter.end();
+
+        QByteArray result;
+        QBuffer buffer(&result);
+        buffer.open(QIODevice::WriteOnly);
+        if (!tile.save(&buffer, "WEBP", 80))
+        {
+            return std::nullopt;
+        }
+        return result;
+    };
+
+    // Write tiles into a temporary file
+    auto tilesFileName = vac.tilesFileName();
+    auto partFileName = tilesFileName + u".part"_qs;
+    QDir().mkpath(QFileInfo(tilesFileName).path());
+
+    QMap<QString, QString> metaData;
+    metaData[u"name"_qs] = vac.name;
+    metaData[u"description"_qs] = vac.name;
+    metaData[u"type"_qs] = u"overlay"_qs;
+    metaData[u"format"_qs] = u"webp"_qs;
+    metaData[u"minzoom"_qs] = QString::number(minZoom);
+    metaData[u"maxzoom"_qs] = QString::number(maxZoom);
+    auto west = qMin(qMin(vac.topLeft.longitude(), vac.topRight.longitude()), qMin(vac.bottomLeft.longitude(), vac.bottomRight.longitude()));
+    auto east = qMax(qMax(vac.topLeft.longitude(), vac.topRight.longitude()), qMax(vac.bottomLeft.longitude(), vac.bottomRight.longitude()));
+    auto south = qMin(qMin(vac.topLeft.latitude(), vac.topRight.latitude()), qMin(vac.bottomLeft.latitude(), vac.bottomRight.latitude()));
+    auto north = qMax(qMax(vac.topLeft.latitude(), vac.topRight.latitude()), qMax(vac.bottomLeft.latitude(), vac.bottomRight.latitude()));
+    metaData[u"bounds"_qs] = QStringLiteral("%1,%2,%3,%4").arg(west).arg(south).arg(east).arg(north);
+
+    auto error = FileFormats::MBTILES::createFile(partFileName);
+    if (error.isEmpty())
+    {
+        error = FileFormats::MBTILES::writeTiles(partFileName, tileKeys, tileData, {}, metaData);
+    }
+    if (canceled)
+    {
+        error = QObject::tr("Tile generation canceled.", "GeoMaps::VACTiler");
+    }
+
+    // If the raster image has been replaced in the meantime, the tiles are
+    // outdated
+    if (error.isEmpty() && (QFileInfo(vac.fileName).lastModified() != lastModified))
+    {
+        error = QObject::tr("The file <strong>%1</strong> changed while tiles were generated.", "GeoMaps::VACTiler").arg(vac.fileName);
+    }
+
+    if (error.isEmpty())
+    {
+        QFile::remove(tilesFileName);
+        if (!QFile::rename(partFileName, tilesFileName))
+        {
+            error = QObject::tr("Unable to write the file <strong>%1</strong>.", "GeoMaps::VACTiler").arg(tilesFileName);
+        }
+    }
+    QFile::remove(partFileName);
+    return error;
+}
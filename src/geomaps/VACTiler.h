@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <atomic>
+
+#include "geomaps/VAC.h"
+
+
+namespace GeoMaps
+{
+
+/*! \brief Tile pyramids for visual approach charts
+ *
+ *  This class converts the raster image of a VAC into a pyramid of 256x256
+ *  tiles in Web Mercator projection, at all zoom levels between 6 and a
+ *  maximal zoom level that matches the resolution of the raster image. The
+ *  tiles are stored in an MBTILES file, so that they can be served to the
+ *  map by the TileServer. The map then loads only the tiles that are visible,
+ *  at the resolution required, instead of decoding and reprojecting the full
+ *  raster image whenever the chart is shown.
+ */
+
+class VACTiler
+{
+public:
+    /*! \brief Create tiles for a VAC
+     *
+     *  This method reads the raster image of the VAC and writes the MBTILES
+     *  file vac.tilesFileName(). The file is written under a temporary name
+     *  and renamed at the end, so that the tiles file is never incomplete.
+     *  Memory consumption is bounded by about 1.25 times the size of the
+     *  decoded raster image. The method is reentrant and is meant to be run in a
+     *  background thread.
+     *
+     *  @param vac Valid VAC
+     *
+     *  @param canceled Flag that is checked regularly. If the flag is set,
+     *  the method stops and does not write any file.
+     *
+     *  @returns An empty string on success, or a human-readable, translated
+     *  error message
+     */
+    [[nodiscard]] static QString createTiles(const GeoMaps::VAC& vac, const std::atomic<bool>& canceled);
+};
+
+} // namespace GeoMaps
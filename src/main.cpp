@@ -194,6 +194,10 @@ auto main(int argc, char *argv[]) -> int
 
     // Create mobile platform adaptor and ask to disable to screen saver.
     GlobalObject::platformAdaptor()->disableScreenSaver();
+
+    // Start the flight recorder. It records only if the user has enabled
+    // flight recording in the settings.
+    GlobalObject::flightRecorder();
     if (positionalArguments.length() == 1)
     {
         GlobalObject::fileExchange()->processFileOpenRequest(positionalArguments[0]);
@@ -27,6 +27,7 @@
 #include "geomaps/GeoMapProvider.h"
 #include "geomaps/GPX.h"
 #include "navigation/Navigator.h"
+#include "navigation/RouteOptimizer.h"
 
 
 //
@@ -36,9 +37,9 @@
 Navigation::FlightRoute::FlightRoute(QObject *parent)
     : QObject(parent)
 {
-    connect(this, &FlightRoute::waypointsChanged, this, &Navigation::FlightRoute::summaryChanged);
-    connect(GlobalObject::navigator(), &Navigation::Navigator::aircraftChanged, this, &Navigation::FlightRoute::summaryChanged);
-    connect(GlobalObject::navigator(), &Navigation::Navigator::windChanged, this, &Navigation::FlightRoute::summaryChanged);
+    connect(this, &FlightRoute::waypointsChanged, this, &Navigation::FlightRoute::invalidatePerformanceCache);
+    connect(GlobalObject::navigator(), &Navigation::Navigator::aircraftChanged, this, &Navigation::FlightRoute::invalidatePerformanceCache);
+    connect(GlobalObject::navigator(), &Navigation::Navigator::windChanged, this, &Navigation::FlightRoute::invalidatePerformanceCache);
 }
 
 
@@ -109,70 +110,8 @@ auto Navigation::FlightRoute::midFieldWaypoints() const -> QList<GeoMaps::Waypoi
 
 auto Navigation::FlightRoute::summary() const -> QString
 {
-
-    if (m_legs.empty())
-    {
-        return {};
-    }
-
-    QString result;
-
-    const auto aircraft = GlobalObject::navigator()->aircraft();
-    const auto wind = GlobalObject::navigator()->wind();
-    auto dist = Units::Distance::fromM(0.0);
-    auto time = Units::Timespan::fromS(0.0);
-    auto fuel = Units::Volume::fromL(0.0);
-
-    for(const auto& _leg : m_legs)
-    {
-        dist += _leg.distance();
-        if (dist.toM() > 100)
-        {
-            time += _leg.ETE(wind, aircraft);
-            fuel += _leg.Fuel(wind, aircraft);
-        }
-    }
-    if (!dist.isFinite()) {
-        return {};
-    }
-
-    result += tr("Total: %1").arg( aircraft.horizontalDistanceToString(dist) );
-
-    if (time.isFinite())
-    {
-        result += QStringLiteral(" • ETE %1 h").arg(time.toHoursAndMinutes());
-    }
-    if (fuel.isFinite())
-    {
-        result += QStringLiteral(" • %1").arg(aircraft.volumeToString(fuel));
-    }
-
-
-    QStringList complaints;
-    if ( !aircraft.cruiseSpeed().isFinite() )
-    {
-        complaints += tr("Cruise speed not specified.");
-    }
-    if (!aircraft.fuelConsumption().isFinite())
-    {
-        complaints += tr("Fuel consumption not specified.");
-    }
-    if (!wind.speed().isFinite())
-    {
-        complaints += tr("Wind speed not specified.");
-    }
-    if (!wind.directionFrom().isFinite())
-    {
-        complaints += tr("Wind direction not specified.");
-    }
-
-    if (!complaints.isEmpty())
-    {
-        result += tr("<p><font color='red'>Computation incomplete. %1</font></p>").arg(complaints.join(QStringLiteral(" ")));
-    }
-
-    return result;
-
+    updatePerformanceCache();
+    return m_performanceCache.summary;
 }
 
 
@@ -194,6 +133,63 @@ void Navigation::FlightRoute::append(const QGeoCoordinate& position)
     append( GeoMaps::Waypoint(position) );
 }
 
+auto Navigation::FlightRoute::avoidAirspaces(const QStringList& categories, Units::Distance altitudeLimit) -> QString
+{
+    if (m_waypoints.size() < 2)
+    {
+        return tr("The route needs to have at least two waypoints.");
+    }
+
+    auto airspaces = GlobalObject::geoMapProvider()->airspaces();
+
+    // Waypoints inside airspaces make avoiding them impossible
+    for(const auto& waypoint : std::as_const(m_waypoints))
+    {
+        auto names = RouteOptimizer::containingAirspaces(waypoint.coordinate(), airspaces, categories, altitudeLimit);
+        if (!names.isEmpty())
+        {
+            return tr("The waypoint %1 lies inside the airspace %2, which cannot be avoided.").arg(waypoint.extendedName(), names.constFirst());
+        }
+    }
+
+    QList<GeoMaps::Waypoint> newWaypoints;
+    newWaypoints.append(m_waypoints.constFirst());
+    qsizetype numFailedLegs = 0;
+    for(qsizetype i=1; i<m_waypoints.size(); i++)
+    {
+        auto detour = RouteOptimizer::route(m_waypoints[i-1].coordinate(),
+                                            m_waypoints[i].coordinate(),
+                                            airspaces,
+                                            categories,
+                                            altitudeLimit);
+        if (detour)
+        {
+            for(const auto& coordinate : std::as_const(*detour))
+            {
+                newWaypoints.append(GeoMaps::Waypoint(coordinate));
+            }
+        }
+        else
+        {
+            numFailedLegs++;
+        }
+        newWaypoints.append(m_waypoints[i]);
+    }
+
+    if (newWaypoints.size() != m_waypoints.size())
+    {
+        m_waypoints = newWaypoints;
+        updateLegs();
+        emit waypointsChanged();
+    }
+
+    if (numFailedLegs > 0)
+    {
+        return tr("Unable to find a route around the airspaces for %n leg(s).", nullptr, int(numFailedLegs));
+    }
+    return {};
+}
+
 auto Navigation::FlightRoute::canAppend(const GeoMaps::Waypoint &other) const -> bool
 {
     if (m_waypoints.isEmpty())
@@ -282,6 +278,12 @@ void Navigation::FlightRoute::insert(const GeoMaps::Waypoint& waypoint)
     emit waypointsChanged();
 }
 
+void Navigation::FlightRoute::invalidatePerformanceCache()
+{
+    m_version++;
+    emit summaryChanged();
+}
+
 auto Navigation::FlightRoute::lastIndexOf(const GeoMaps::Waypoint& waypoint) const -> qsizetype
 {
 
@@ -301,6 +303,22 @@ auto Navigation::FlightRoute::lastIndexOf(const GeoMaps::Waypoint& waypoint) con
 
 }
 
+auto Navigation::FlightRoute::legDescription(qsizetype index) const -> QString
+{
+    const auto& performance = legPerformance();
+    if ((index < 0) || (index >= performance.size()))
+    {
+        return {};
+    }
+    return m_legs[index].description(performance[index], GlobalObject::navigator()->aircraft());
+}
+
+auto Navigation::FlightRoute::legPerformance() const -> const QList<Navigation::Leg::Performance>&
+{
+    updatePerformanceCache();
+    return m_performanceCache.legs;
+}
+
 auto Navigation::FlightRoute::load(const QString& fileName) -> QString
 {
     QString myFileName = fileName;
@@ -324,26 +342,28 @@ auto Navigation::FlightRoute::load(const QString& fileName) -> QString
         return tr("The file '%1' contains too many waypoints. Flight routes with more than 100 waypoints are not supported.").arg(myFileName);
     }
 
-    m_waypoints.clear();
-    foreach(auto waypoint, result)
+    // Snap imported waypoints to nearby waypoints from the map or library,
+    // resolving all of them in one pass
+    result.removeIf([](const GeoMaps::Waypoint& waypoint) { return !waypoint.isValid(); });
+    QList<QGeoCoordinate> positions;
+    positions.reserve(result.size());
+    for(const auto& waypoint : std::as_const(result))
     {
-        if (!waypoint.isValid())
-        {
-            continue;
-        }
+        positions << waypoint.coordinate();
+    }
+    auto nearest = GlobalObject::geoMapProvider()->closestWaypoints(positions, Units::Distance::fromM(1000.0));
 
-        auto pos = waypoint.coordinate();
-        auto distPos = pos.atDistanceAndAzimuth(1000.0, 0.0, 0.0);
-        auto nearest = GlobalObject::geoMapProvider()->closestWaypoint(pos, distPos);
-        if (nearest.type() == u"WP")
+    m_waypoints.clear();
+    for(qsizetype i=0; i<result.size(); i++)
+    {
+        if (nearest[i].type() == u"WP")
         {
-            m_waypoints << waypoint;
+            m_waypoints << result[i];
         }
         else
         {
-            m_waypoints << nearest;
+            m_waypoints << nearest[i];
         }
-
     }
 
     updateLegs();
@@ -536,10 +556,92 @@ auto Navigation::FlightRoute::toGeoJSON() const -> QByteArray
     return doc.toJson();
 }
 
+void Navigation::FlightRoute::updatePerformanceCache() const
+{
+    if (m_performanceCache.version == m_version)
+    {
+        return;
+    }
+    m_performanceCache.version = m_version;
+    m_performanceCache.legs.clear();
+    m_performanceCache.summary.clear();
+
+    if (m_legs.empty())
+    {
+        return;
+    }
+
+    const auto aircraft = GlobalObject::navigator()->aircraft();
+    const auto wind = GlobalObject::navigator()->wind();
+    m_performanceCache.legs.reserve(m_legs.size());
+    for(const auto& _leg : m_legs)
+    {
+        m_performanceCache.legs << _leg.performance(wind, aircraft);
+    }
+
+    auto dist = Units::Distance::fromM(0.0);
+    auto time = Units::Timespan::fromS(0.0);
+    auto fuel = Units::Volume::fromL(0.0);
+    for(qsizetype i=0; i<m_legs.size(); i++)
+    {
+        dist += m_legs[i].distance();
+        if (dist.toM() > 100)
+        {
+            time += m_performanceCache.legs[i].ETE;
+            fuel += m_performanceCache.legs[i].fuel;
+        }
+    }
+    if (!dist.isFinite()) {
+        return;
+    }
+
+    QString result;
+    result += tr("Total: %1").arg( aircraft.horizontalDistanceToString(dist) );
+
+    if (time.isFinite())
+    {
+        result += QStringLiteral(" • ETE %1 h").arg(time.toHoursAndMinutes());
+    }
+    if (fuel.isFinite())
+    {
+        result += QStringLiteral(" • %1").arg(aircraft.volumeToString(fuel));
+    }
+
+
+    QStringList complaints;
+    if ( !aircraft.cruiseSpeed().isFinite() )
+    {
+        complaints += tr("Cruise speed not specified.");
+    }
+    if (!aircraft.fuelConsumption().isFinite())
+    {
+        complaints += tr("Fuel consumption not specified.");
+    }
+    if (!wind.speed().isFinite())
+    {
+        complaints += tr("Wind speed not specified.");
+    }
+    if (!wind.directionFrom().isFinite())
+    {
+        complaints += tr("Wind direction not specified.");
+    }
+
+    if (!complaints.isEmpty())
+    {
+        result += tr("<p><font color='red'>Computation incomplete. %1</font></p>").arg(complaints.join(QStringLiteral(" ")));
+    }
+
+    m_performanceCache.summary = result;
+}
+
 void Navigation::FlightRoute::updateLegs()
 {
+    m_version++;
     m_legs.clear();
+    m_legs.reserve(m_waypoints.size());
 
+    // The constructor of Leg precomputes the geometry of the leg, which is
+    // then used for all later distance computations
     for(int i=0; i<m_waypoints.size()-1; i++)
     {
         m_legs.append(Leg(m_waypoints.at(i), m_waypoints.at(i+1)));
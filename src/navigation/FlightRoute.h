@@ -27,6 +27,7 @@
 #include <QPointer>
 #include <QQmlEngine>
 #include <QXmlStreamReader>
+#include <limits>
 
 #include "geomaps/Waypoint.h"
 #include "navigation/Leg.h"
@@ -195,6 +196,25 @@ namespace Navigation
          */
         Q_INVOKABLE void append(const QGeoCoordinate& position);
 
+        /*! \brief Reroutes the flight route around airspaces
+         *
+         *  This method inserts additional waypoints into every leg of the
+         *  route, so that the route avoids airspaces of the given categories.
+         *  The waypoints of the route are kept. Legs that cannot be rerouted
+         *  remain unchanged. If a waypoint lies inside one of the airspaces,
+         *  the route is not changed at all. See RouteOptimizer for details.
+         *
+         *  @param categories Categories of airspaces that are to be avoided,
+         *  such as "CTR" or "R"
+         *
+         *  @param altitudeLimit Airspaces whose lower bound is at or above
+         *  this altitude are disregarded
+         *
+         *  @returns Empty string on success, a human-readable error message
+         *  otherwise.
+         */
+        [[nodiscard]] Q_INVOKABLE QString avoidAirspaces(const QStringList& categories, Units::Distance altitudeLimit);
+
         /*! \brief Checks if waypoint can be added as the new end of this
          *  route
          *
@@ -246,6 +266,29 @@ namespace Navigation
          */
         [[nodiscard]] Q_INVOKABLE qsizetype lastIndexOf(const GeoMaps::Waypoint& waypoint) const;
 
+        /*! \brief Brief description of a leg of the route
+         *
+         *  This method returns the same text as Leg::description(), but uses
+         *  the cached figures of legPerformance().
+         *
+         *  @param index Index of the leg
+         *
+         *  @returns Description of the leg, or an empty string if index is out
+         *  of range
+         */
+        [[nodiscard]] Q_INVOKABLE QString legDescription(qsizetype index) const;
+
+        /*! \brief Performance figures for the legs of the route
+         *
+         *  The figures are computed for the aircraft and wind that are
+         *  presently set in the global Navigator class. They are cached and
+         *  recomputed only after the route, the aircraft or the wind have
+         *  changed.
+         *
+         *  @returns List of performance figures, one for every leg
+         */
+        [[nodiscard]] auto legPerformance() const -> const QList<Navigation::Leg::Performance>&;
+
         /*! \brief Loads the route from a GeoJSON or GPX document
          *
          * This method loads the flight route from a GeoJSON or GPX file. The
@@ -348,6 +391,9 @@ namespace Navigation
         void summaryChanged();
 
     private slots:
+        // Invalidates the cached performance figures and emits summaryChanged
+        void invalidatePerformanceCache();
+
         void updateLegs();
 
     private:
@@ -360,6 +406,20 @@ namespace Navigation
 
         QVector<Leg> m_legs;
 
+        // Recomputes the cached performance figures, if outdated
+        void updatePerformanceCache() const;
+
+        // Incremented whenever the route, the aircraft or the wind change
+        quint64 m_version {0};
+
+        // Cached performance figures and summary, valid if version equals
+        // m_version
+        mutable struct {
+            quint64 version {std::numeric_limits<quint64>::max()};
+            QList<Leg::Performance> legs;
+            QString summary;
+        } m_performanceCache;
+
         QLocale myLocale;
     };
 
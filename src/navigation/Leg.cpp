@@ -23,9 +23,61 @@
 #include "GlobalObject.h"
 #include "GlobalSettings.h"
 #include "navigation/Navigator.h"
+#include <QtMath>
 #include <utility>
 
 
+namespace {
+
+using Vector = std::array<double, 3>;
+
+// Earth radius in meters, as used by QGeoCoordinate::distanceTo
+constexpr double earthRadiusInM = 6371007.2;
+
+Vector toVector(const QGeoCoordinate& coordinate)
+{
+    auto lat = qDegreesToRadians(coordinate.latitude());
+    auto lon = qDegreesToRadians(coordinate.longitude());
+    return {qCos(lat)*qCos(lon), qCos(lat)*qSin(lon), qSin(lat)};
+}
+
+double dot(const Vector& a, const Vector& b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+Vector cross(const Vector& a, const Vector& b)
+{
+    return {a[1]*b[2]-a[2]*b[1], a[2]*b[0]-a[0]*b[2], a[0]*b[1]-a[1]*b[0]};
+}
+
+double norm(const Vector& a)
+{
+    return qSqrt(dot(a, a));
+}
+
+// Angle between two unit vectors, in radians. Numerically stable also for
+// small angles.
+double angle(const Vector& a, const Vector& b)
+{
+    return qAtan2(norm(cross(a, b)), dot(a, b));
+}
+
+// Initial course of the great circle from a to b, in degrees. Computed from
+// the components of b in the east and north directions at a. Both directions
+// are scaled by the cosine of the latitude of a, which does not change the
+// result.
+double azimuth(const Vector& a, const Vector& b)
+{
+    const Vector east {-a[1], a[0], 0.0};
+    const Vector north {-a[2]*a[0], -a[2]*a[1], a[0]*a[0]+a[1]*a[1]};
+    auto result = qRadiansToDegrees(qAtan2(dot(b, east), dot(b, north)));
+    return (result < 0.0) ? result+360.0 : result;
+}
+
+} // namespace
+
+
 //
 // Constructors and destructors
 //
@@ -33,9 +85,26 @@
 Navigation::Leg::Leg(GeoMaps::Waypoint  start, GeoMaps::Waypoint  end) :
     m_start(std::move(start)), m_end(std::move(end))
 {
-    m_geoPath.addCoordinate(m_start.coordinate());
-    m_geoPath.addCoordinate(m_end.coordinate());
-    m_geoPath.setWidth( 2.0*nearThreshold.toM() );
+    if (!isValid())
+    {
+        return;
+    }
+
+    m_startVector = toVector(m_start.coordinate());
+    m_endVector = toVector(m_end.coordinate());
+    m_lengthInM = earthRadiusInM*angle(m_startVector, m_endVector);
+
+    auto normal = cross(m_startVector, m_endVector);
+    auto normalLength = norm(normal);
+    if (normalLength > 0.0)
+    {
+        m_normalVector = {normal[0]/normalLength, normal[1]/normalLength, normal[2]/normalLength};
+    }
+
+    if (m_lengthInM >= minLegLength.toM())
+    {
+        m_TCInDEG = azimuth(m_startVector, m_endVector);
+    }
 }
 
 
@@ -50,7 +119,7 @@ auto Navigation::Leg::distance() const -> Units::Distance
         return {};
     }
 
-    return Units::Distance::fromM( m_start.coordinate().distanceTo( m_end.coordinate() ));
+    return Units::Distance::fromM(m_lengthInM);
 }
 
 
@@ -72,11 +141,11 @@ auto Navigation::Leg::TC() const -> Units::Angle
     if (!isValid()) {
         return {};
     }
-    if( Units::Distance::fromM(m_start.coordinate().distanceTo(m_end.coordinate())) < minLegLength ) {
+    if (!qIsFinite(m_TCInDEG)) {
         return {};
     }
 
-    return Units::Angle::fromDEG( m_start.coordinate().azimuthTo(m_end.coordinate()) );
+    return Units::Angle::fromDEG(m_TCInDEG);
 }
 
 
@@ -84,6 +153,51 @@ auto Navigation::Leg::TC() const -> Units::Angle
 // Methods
 //
 
+auto Navigation::Leg::alongTrackDistance(const QGeoCoordinate& position) const -> Units::Distance
+{
+    if (!isValid() || !position.isValid() || (m_normalVector == Vector {})) {
+        return Units::Distance::nan();
+    }
+
+    // Write the position as cos(xtd)*(cos(atd)*start + sin(atd)*tangent) + sin(xtd)*normal,
+    // where tangent = normal x start
+    auto positionVector = toVector(position);
+    auto atd = qAtan2(dot(cross(m_startVector, positionVector), m_normalVector), dot(m_startVector, positionVector));
+    return Units::Distance::fromM(earthRadiusInM*atd);
+}
+
+
+auto Navigation::Leg::crossTrackDistance(const QGeoCoordinate& position) const -> Units::Distance
+{
+    if (!isValid() || !position.isValid() || (m_normalVector == Vector {})) {
+        return Units::Distance::nan();
+    }
+
+    // The normal vector points to the left of the direction of travel
+    auto sinXTD = qBound(-1.0, dot(m_normalVector, toVector(position)), 1.0);
+    return Units::Distance::fromM(-earthRadiusInM*qAsin(sinXTD));
+}
+
+
+auto Navigation::Leg::pointAtDistance(Units::Distance dist) const -> QGeoCoordinate
+{
+    if (!isValid()) {
+        return {};
+    }
+    if (m_normalVector == Vector {}) {
+        return m_start.coordinate();
+    }
+
+    auto theta = dist.toM()/earthRadiusInM;
+    auto tangent = cross(m_normalVector, m_startVector);
+    Vector point;
+    for(int i=0; i<3; i++) {
+        point[i] = qCos(theta)*m_startVector[i] + qSin(theta)*tangent[i];
+    }
+    return {qRadiansToDegrees(qAsin(qBound(-1.0, point[2], 1.0))), qRadiansToDegrees(qAtan2(point[1], point[0]))};
+}
+
+
 auto Navigation::Leg::Fuel(Weather::Wind wind, const Navigation::Aircraft& aircraft) const -> Units::Volume
 {
     // This also checks for _aircraft and _wind to be non-nullptr
@@ -124,13 +238,14 @@ auto Navigation::Leg::isFollowing(const Positioning::PositionInfo& positionInfo)
         return false;
     }
 
-    auto delta = TT -  Units::Angle::fromDEG(positionInfo.coordinate().azimuthTo(m_end.coordinate()));
+    auto positionVector = toVector(positionInfo.coordinate());
+    auto delta = TT -  Units::Angle::fromDEG(azimuth(positionVector, m_endVector));
     auto deltaDeg = delta.toDEG();
     if ((deltaDeg < 300.0) && (deltaDeg > 60.0)) {
         return false;
     }
 
-    delta = TT -  Units::Angle::fromDEG(positionInfo.coordinate().azimuthTo(m_start.coordinate()));
+    delta = TT -  Units::Angle::fromDEG(azimuth(positionVector, m_startVector));
     deltaDeg = delta.toDEG();
     return (deltaDeg >= 120.0) && (deltaDeg <= 240.0);
 }
@@ -142,13 +257,48 @@ auto Navigation::Leg::isNear(const Positioning::PositionInfo& positionInfo) cons
         return false;
     }
 
-    if (m_start.coordinate().distanceTo(positionInfo.coordinate()) < nearThreshold.toM()) {
+    auto positionVector = toVector(positionInfo.coordinate());
+    if (earthRadiusInM*angle(m_startVector, positionVector) < nearThreshold.toM()) {
         return true;
     }
-    if (m_end.coordinate().distanceTo(positionInfo.coordinate()) < nearThreshold.toM()) {
+    if (earthRadiusInM*angle(m_endVector, positionVector) < nearThreshold.toM()) {
         return true;
     }
-    return m_geoPath.contains(positionInfo.coordinate());
+
+    // Check if the position lies in the corridor of width 2*nearThreshold
+    // around the leg
+    if (m_normalVector == Vector {}) {
+        return false;
+    }
+    auto xtd = earthRadiusInM*qAsin(qBound(-1.0, dot(m_normalVector, positionVector), 1.0));
+    if (qAbs(xtd) >= nearThreshold.toM()) {
+        return false;
+    }
+    auto atd = earthRadiusInM*qAtan2(dot(cross(m_startVector, positionVector), m_normalVector), dot(m_startVector, positionVector));
+    return (atd >= 0.0) && (atd <= m_lengthInM);
+}
+
+
+auto Navigation::Leg::performance(Weather::Wind wind, const Navigation::Aircraft& aircraft) const -> Performance
+{
+    if (!hasDataForWindTriangle(wind, aircraft)) {
+        return {};
+    }
+
+    auto TASInKN = aircraft.cruiseSpeed().toKN();
+    auto WSInKN  = wind.speed().toKN();
+    auto WD      = wind.directionFrom();
+
+    Performance result;
+
+    // Law of sine and law of cosine for wind triangle
+    result.WCA = Units::Angle::asin(-(TC()-WD).sin() *(WSInKN/TASInKN));
+    result.TH = TC()+result.WCA;
+    auto GSInKT = qSqrt( TASInKN*TASInKN + WSInKN*WSInKN - 2.0*TASInKN*WSInKN*(WD-result.TH).cos() );
+    result.GS = Units::Speed::fromKN(GSInKT);
+    result.ETE = distance()/result.GS;
+    result.fuel = aircraft.fuelConsumption()*result.ETE;
+    return result;
 }
 
 
@@ -169,6 +319,15 @@ auto Navigation::Leg::WCA(Weather::Wind wind, const Navigation::Aircraft& aircra
 
 
 auto Navigation::Leg::description(Weather::Wind wind, const Navigation::Aircraft& aircraft) const -> QString
+{
+    if (!isValid()) {
+        return {};
+    }
+    return description(performance(wind, aircraft), aircraft);
+}
+
+
+auto Navigation::Leg::description(const Performance& _performance, const Navigation::Aircraft& aircraft) const -> QString
 {
     if (!isValid()) {
         return {};
@@ -176,7 +335,7 @@ auto Navigation::Leg::description(Weather::Wind wind, const Navigation::Aircraft
 
     QString result;
     result += QStringLiteral("%1").arg( aircraft.horizontalDistanceToString(distance()) );
-    auto _time = ETE(wind, aircraft);
+    auto _time = _performance.ETE;
     if (_time.isFinite()) {
         result += QStringLiteral(" • ETE %1 h").arg(_time.toHoursAndMinutes());
     }
@@ -184,7 +343,7 @@ auto Navigation::Leg::description(Weather::Wind wind, const Navigation::Aircraft
     if (qIsFinite(TCInDEG)) {
         result += QStringLiteral(" • TC %1°").arg(qRound(TCInDEG));
     }
-    double const THInDEG = TH(wind, aircraft).toDEG();
+    double const THInDEG = _performance.TH.toDEG();
     if (qIsFinite(THInDEG)) {
         result += QStringLiteral(" • TH %1°").arg(qRound(THInDEG));
     }
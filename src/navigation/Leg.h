@@ -20,8 +20,9 @@
 
 #pragma once
 
-#include <QGeoPath>
+#include <QGeoCoordinate>
 #include <QQmlEngine>
+#include <array>
 
 #include "geomaps/Waypoint.h"
 #include "navigation/Aircraft.h"
@@ -32,7 +33,15 @@
 
 namespace Navigation {
 
-/*! \brief Leg in a flight route */
+/*! \brief Leg in a flight route
+ *
+ *  When a leg is constructed, the unit vectors of start and end point, the
+ *  normal vector of the great circle through both points, the length and
+ *  the initial course are computed once. Distances to the leg and the checks
+ *  isNear() and isFollowing() can therefore be answered in constant time,
+ *  without computing geodesics. All computations use a spherical earth with
+ *  the radius used by QGeoCoordinate.
+ */
 
 class Leg {
     Q_GADGET
@@ -124,6 +133,39 @@ public:
     // Methods
     //
 
+    /*! \brief Along-track distance
+     *
+     *  @param position Position
+     *
+     *  @returns Distance from the start point to the projection of position
+     *  onto the great circle through start and end point, measured in
+     *  direction of the end point. The value is negative if the projection
+     *  lies behind the start point. NaN if the leg or the position is invalid,
+     *  or if start and end point agree.
+     */
+    [[nodiscard]] Units::Distance alongTrackDistance(const QGeoCoordinate& position) const;
+
+    /*! \brief Cross-track distance
+     *
+     *  @param position Position
+     *
+     *  @returns Distance of the position from the great circle through start
+     *  and end point. The value is positive if the position lies to the right
+     *  of the leg. NaN if the leg or the position is invalid, or if start and
+     *  end point agree.
+     */
+    [[nodiscard]] Units::Distance crossTrackDistance(const QGeoCoordinate& position) const;
+
+    /*! \brief Point on the leg
+     *
+     *  @param dist Distance from the start point
+     *
+     *  @returns Point on the great circle through start and end point, at the
+     *  given distance from the start point in direction of the end point.
+     *  Invalid coordinate if the leg is invalid.
+     */
+    [[nodiscard]] QGeoCoordinate pointAtDistance(Units::Distance dist) const;
+
     /*! \brief Brief description of Dist ETE, TC and THGetter function for property of the same name
      *
      *  @param wind Estimated wind
@@ -190,6 +232,57 @@ public:
      */
     [[nodiscard]] Q_INVOKABLE bool isNear(const Positioning::PositionInfo& positionInfo) const;
 
+    /*! \brief Performance figures for a leg
+     *
+     *  This struct holds the results of one evaluation of the wind triangle.
+     *  Members are invalid if wind or aircraft data is insufficient.
+     */
+    struct Performance
+    {
+        /*! \brief Estimated WCA on leg */
+        Units::Angle WCA;
+
+        /*! \brief Estimated true heading on leg */
+        Units::Angle TH;
+
+        /*! \brief Estimated ground speed on leg */
+        Units::Speed GS;
+
+        /*! \brief ETE for leg */
+        Units::Timespan ETE;
+
+        /*! \brief Estimated fuel consumption on leg */
+        Units::Volume fuel;
+    };
+
+    /*! \brief Performance figures for leg
+     *
+     *  This method solves the wind triangle only once and is therefore
+     *  cheaper than calling WCA(), TH(), GS(), ETE() and Fuel() in turn.
+     *
+     *  @param wind Estimated wind
+     *
+     *  @param aircraft Aircraft in use
+     *
+     *  @returns Performance figures for leg
+     */
+    [[nodiscard]] Performance performance(Weather::Wind wind, const Navigation::Aircraft& aircraft) const;
+
+    /*! \brief Brief description of Dist, ETE, TC and TH
+     *
+     *  This method differs from description(Weather::Wind, const
+     *  Navigation::Aircraft&) only in that it uses performance figures that
+     *  have already been computed, for instance by
+     *  FlightRoute::legPerformance().
+     *
+     *  @param performance Performance figures for this leg
+     *
+     *  @param aircraft Aircraft in use, used to format the distance
+     *
+     *  @returns Description of the leg
+     */
+    [[nodiscard]] QString description(const Performance& performance, const Navigation::Aircraft& aircraft) const;
+
     /*! \brief Estimated true heading on leg
      *
      *  @param wind Estimated wind
@@ -230,7 +323,16 @@ private:
 
     GeoMaps::Waypoint m_start;
     GeoMaps::Waypoint m_end;
-    QGeoPath m_geoPath;
+
+    // Precomputed geometry: unit vectors of start and end point, unit normal
+    // vector of the great circle from start to end (zero if start and end
+    // agree), length in meters and true course in degrees (NaN if the leg
+    // is shorter than minLegLength)
+    std::array<double, 3> m_startVector {};
+    std::array<double, 3> m_endVector {};
+    std::array<double, 3> m_normalVector {};
+    double m_lengthInM {qQNaN()};
+    double m_TCInDEG {qQNaN()};
 };
 
 } // namespace Navigation
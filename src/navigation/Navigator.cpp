@@ -61,9 +61,9 @@ void Navigation::Navigator::deferredInitialization()
     connect(GlobalObject::positionProvider(), &Positioning::PositionProvider::positionInfoChanged, this, &Navigation::Navigator::updateAltitudeLimit);
     connect(GlobalObject::positionProvider(), &Positioning::PositionProvider::positionInfoChanged, this, &Navigation::Navigator::updateFlightStatus);
     connect(GlobalObject::positionProvider(), &Positioning::PositionProvider::positionInfoChanged, this, &Navigation::Navigator::updateRemainingRouteInfo);
-    connect(this, &Navigation::Navigator::aircraftChanged, this, [this](){ updateRemainingRouteInfo(); });
-    connect(this, &Navigation::Navigator::windChanged, this, [this](){ updateRemainingRouteInfo(); });
-    connect(flightRoute(), &Navigation::FlightRoute::waypointsChanged, this, [this](){ updateRemainingRouteInfo(); });
+    // The flight route emits summaryChanged() after changes of waypoints,
+    // aircraft or wind, once its performance figures have been invalidated
+    connect(flightRoute(), &Navigation::FlightRoute::summaryChanged, this, [this](){ invalidateLegTracker(); updateRemainingRouteInfo(); });
 }
 
 
@@ -199,13 +199,86 @@ void Navigation::Navigator::setRemainingRouteInfo(const Navigation::RemainingRou
 }
 
 
+void Navigation::Navigator::invalidateLegTracker()
+{
+    m_legTracker.isValid = false;
+}
+
+
+void Navigation::Navigator::updateLegTracker()
+{
+    if (m_legTracker.isValid)
+    {
+        return;
+    }
+
+    auto waypoints = flightRoute()->waypoints();
+    m_legTracker.legs = flightRoute()->legs();
+    m_legTracker.finalCoordinate = waypoints.isEmpty() ? QGeoCoordinate() : waypoints.constLast().coordinate();
+    m_legTracker.currentLeg = -1;
+
+    const auto& legPerformance = flightRoute()->legPerformance();
+    auto numLegs = m_legTracker.legs.size();
+    m_legTracker.remainingDistance.resize(numLegs);
+    m_legTracker.remainingETE.resize(numLegs);
+    auto dist = Units::Distance::fromM(0.0);
+    auto ETE = Units::Timespan::fromS(0.0);
+    for(auto i=numLegs-1; i>=0; i--)
+    {
+        m_legTracker.remainingDistance[i] = dist;
+        m_legTracker.remainingETE[i] = ETE;
+        dist += m_legTracker.legs[i].distance();
+        ETE += legPerformance[i].ETE;
+    }
+    m_legTracker.isValid = true;
+}
+
+
+qsizetype Navigation::Navigator::findCurrentLeg(const QList<Leg>& legs, const Positioning::PositionInfo& info)
+{
+    // As long as the aircraft follows the active leg or the next one, there
+    // is no need to look at other legs
+    auto activeLeg = m_legTracker.currentLeg;
+    if ((activeLeg >= 0) && (activeLeg < legs.size()))
+    {
+        if ((activeLeg+1 < legs.size()) && legs[activeLeg+1].isFollowing(info))
+        {
+            return activeLeg+1;
+        }
+        if (legs[activeLeg].isFollowing(info))
+        {
+            return activeLeg;
+        }
+    }
+
+    // Check legs that we are following, and take the last one
+    for(auto i=legs.size()-1; i>=0; i--)
+    {
+        if (legs[i].isFollowing(info))
+        {
+            return i;
+        }
+    }
+
+    // If no current leg found, check legs that we are near to, and take the last one.
+    for(auto i=legs.size()-1; i>=0; i--)
+    {
+        if (legs[i].isNear(info))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
 void Navigation::Navigator::updateRemainingRouteInfo()
 {
     auto info = GlobalObject::positionProvider()->positionInfo();
+    updateLegTracker();
 
     // If there are no waypoints, then there is no remaining route info
-    auto geoPath = flightRoute()->geoPath();
-    if (geoPath.isEmpty())
+    if (!m_legTracker.finalCoordinate.isValid())
     {
         RemainingRouteInfo rrInfo;
         rrInfo.status = RemainingRouteInfo::NoRoute;
@@ -223,8 +296,7 @@ void Navigation::Navigator::updateRemainingRouteInfo()
     }
 
     // If we are closer than 3 nm from endpoint, then we do not give a remaining route info
-    auto finalCoordinate = geoPath[geoPath.size()-1];
-    if (Units::Distance::fromM(finalCoordinate.distanceTo(info.coordinate())) < Leg::nearThreshold)
+    if (Units::Distance::fromM(m_legTracker.finalCoordinate.distanceTo(info.coordinate())) < Leg::nearThreshold)
     {
         RemainingRouteInfo rrInfo;
         rrInfo.status = RemainingRouteInfo::NearDestination;
@@ -235,39 +307,20 @@ void Navigation::Navigator::updateRemainingRouteInfo()
     //
     // Figure out what the current leg is
     //
-    auto legs = flightRoute()->legs();
-
-    // If the flight route contains one waypoint only, then create an artificial leg from the current position
-    // to the one waypoint of the route.
-    if (flightRoute()->size() == 1)
+    qsizetype currentLeg = -1;
+    if (m_legTracker.legs.isEmpty())
     {
+        // If the flight route contains one waypoint only, then create an artificial leg from the current position
+        // to the one waypoint of the route.
         auto start = Positioning::PositionProvider::lastValidCoordinate();
         auto end = flightRoute()->waypoints()[0];
-        legs += Leg(start, end);
-    }
-
-    // Check legs that we are following, and take the last one
-    qsizetype currentLeg = -1;
-    for(auto i=legs.size()-1; i>=0; i--)
-    {
-        if (legs[i].isFollowing(info))
-        {
-            currentLeg = i;
-            break;
-        }
+        const QList<Leg> legs {Leg(start, end)};
+        currentLeg = findCurrentLeg(legs, info);
     }
-
-    // If no current leg found, check legs that we are near to, and take the last one.
-    if (currentLeg < 0)
+    else
     {
-        for(auto i=legs.size()-1; i>=0; i--)
-        {
-            if (legs[i].isNear(info))
-            {
-                currentLeg = i;
-                break;
-            }
-        }
+        currentLeg = findCurrentLeg(m_legTracker.legs, info);
+        m_legTracker.currentLeg = currentLeg;
     }
 
     // If still no current leg found, then abort
@@ -284,7 +337,8 @@ void Navigation::Navigator::updateRemainingRouteInfo()
     //
     RemainingRouteInfo rri;
     rri.status = RemainingRouteInfo::OnRoute;
-    Leg const legToNextWP(info.coordinate(), legs[currentLeg].endPoint());
+    auto nextWP = m_legTracker.legs.isEmpty() ? flightRoute()->waypoints()[0] : m_legTracker.legs[currentLeg].endPoint();
+    Leg const legToNextWP(info.coordinate(), nextWP);
     auto dist = legToNextWP.distance();
     auto ETE = legToNextWP.ETE(m_wind, m_aircraft);
 
@@ -313,15 +367,12 @@ void Navigation::Navigator::updateRemainingRouteInfo()
     }
     rri.nextWP_TC = legToNextWP.TC();
 
-    if (currentLeg < legs.size()-1)
+    if (currentLeg < m_legTracker.legs.size()-1)
     {
-        for(auto i=currentLeg+1; i<legs.size(); i++)
-        {
-            dist += legs[i].distance();
-            ETE += legs[i].ETE(m_wind, m_aircraft);
-        }
+        dist += m_legTracker.remainingDistance[currentLeg];
+        ETE += m_legTracker.remainingETE[currentLeg];
 
-        rri.finalWP = legs.last().endPoint();
+        rri.finalWP = m_legTracker.legs.constLast().endPoint();
         rri.finalWP_DIST = dist;
         rri.finalWP_ETE  = ETE;
         if (ETE.isFinite())
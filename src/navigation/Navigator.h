@@ -200,6 +200,10 @@ private slots:
     // Re-computes the Remaining Route Info. The argument must be the current position info of the own aircraft.
     void updateRemainingRouteInfo();
 
+    // Invalidates the leg tracker. Connected to changes of flight route, wind
+    // and aircraft.
+    void invalidateLegTracker();
+
 private:
     Q_DISABLE_COPY_MOVE(Navigator)
 
@@ -222,6 +226,33 @@ private:
 
     // RemainingRouteInfo only use the setter method to write to m_remainingRouteInfo
     RemainingRouteInfo m_remainingRouteInfo;
+
+    // Rebuilds the leg tracker if it has been invalidated
+    void updateLegTracker();
+
+    // Index of the leg that the aircraft is currently on, or -1 if the
+    // aircraft is off route. Only the active leg and the next leg are tested,
+    // unless the aircraft has left both of them.
+    qsizetype findCurrentLeg(const QList<Leg>& legs, const Positioning::PositionInfo& info);
+
+    // State of updateRemainingRouteInfo(), kept between position updates
+    struct LegTracker
+    {
+        // True if the data below describes the current route, wind and aircraft
+        bool isValid {false};
+
+        // Legs of the flight route, and the coordinate of the final waypoint
+        QList<Leg> legs;
+        QGeoCoordinate finalCoordinate;
+
+        // Index of the leg that the aircraft was on at the last position update
+        qsizetype currentLeg {-1};
+
+        // Distance and ETE of the legs following leg i
+        QList<Units::Distance> remainingDistance;
+        QList<Units::Timespan> remainingETE;
+    };
+    LegTracker m_legTracker;
 };
 
 } // namespace Navigation
@@ -0,0 +1,523 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtMath>
+#include <algorithm>
+#include <queue>
+
+#include "navigation/RouteOptimizer.h"
+
+
+namespace {
+
+// Earth radius in meters, as used by QGeoCoordinate::distanceTo
+constexpr double earthRadiusInM = 6371007.2;
+
+// Tolerance in meters for geometric predicates. Segments that touch an obstacle
+// along its boundary do not count as intersecting.
+constexpr double tolerance = 1.0;
+
+struct Point
+{
+    double x;
+    double y;
+};
+
+// Cross product of the vectors a-o and b-o
+double cross(const Point& o, const Point& a, const Point& b)
+{
+    return (a.x-o.x)*(b.y-o.y) - (a.y-o.y)*(b.x-o.x);
+}
+
+double distance(const Point& a, const Point& b)
+{
+    return qHypot(a.x-b.x, a.y-b.y);
+}
+
+// Distance of p from the segment from a to b
+double distanceToSegment(const Point& p, const Point& a, const Point& b)
+{
+    auto lengthSquared = (b.x-a.x)*(b.x-a.x) + (b.y-a.y)*(b.y-a.y);
+    if (lengthSquared == 0.0)
+    {
+        return distance(p, a);
+    }
+    auto t = qBound(0.0, ((p.x-a.x)*(b.x-a.x) + (p.y-a.y)*(b.y-a.y))/lengthSquared, 1.0);
+    return distance(p, {a.x+t*(b.x-a.x), a.y+t*(b.y-a.y)});
+}
+
+// True if the segments from a to b and from c to d cross each other at a
+// point that is not within tolerance of an endpoint
+bool crosses(const Point& a, const Point& b, const Point& c, const Point& d)
+{
+    auto lengthAB = distance(a, b);
+    auto lengthCD = distance(c, d);
+    if ((lengthAB == 0.0) || (lengthCD == 0.0))
+    {
+        return false;
+    }
+    auto c1 = cross(a, b, c)/lengthAB;
+    auto d1 = cross(a, b, d)/lengthAB;
+    auto a1 = cross(c, d, a)/lengthCD;
+    auto b1 = cross(c, d, b)/lengthCD;
+    return (((c1 > tolerance) && (d1 < -tolerance)) || ((c1 < -tolerance) && (d1 > tolerance)))
+           && (((a1 > tolerance) && (b1 < -tolerance)) || ((a1 < -tolerance) && (b1 > tolerance)));
+}
+
+// Polygon that the route must not enter, and its bounding box. Obstacles are
+// usually convex, with vertices in counter-clockwise order. Airspaces whose
+// convex hull would contain the start or end point are represented by their
+// actual polygon instead, which need not be convex.
+struct Obstacle
+{
+    QList<Point> vertices;
+    bool isConvex {true};
+    double xMin {0.0};
+    double xMax {0.0};
+    double yMin {0.0};
+    double yMax {0.0};
+
+    // Computes the bounding box
+    void updateBoundingBox()
+    {
+        xMin = xMax = vertices[0].x;
+        yMin = yMax = vertices[0].y;
+        for(const auto& p : std::as_const(vertices))
+        {
+            xMin = qMin(xMin, p.x);
+            xMax = qMax(xMax, p.x);
+            yMin = qMin(yMin, p.y);
+            yMax = qMax(yMax, p.y);
+        }
+    }
+
+    // True if p lies in the interior of the obstacle, at least tolerance away
+    // from the boundary
+    [[nodiscard]] bool contains(const Point& p) const
+    {
+        if ((p.x <= xMin) || (p.x >= xMax) || (p.y <= yMin) || (p.y >= yMax))
+        {
+            return false;
+        }
+        auto numVertices = vertices.size();
+        if (!isConvex)
+        {
+            // Ray casting
+            bool inside = false;
+            for(qsizetype i=0, j=numVertices-1; i<numVertices; j=i++)
+            {
+                const auto& a = vertices[i];
+                const auto& b = vertices[j];
+                if (distanceToSegment(p, a, b) <= tolerance)
+                {
+                    return false;
+                }
+                if (((a.y > p.y) != (b.y > p.y)) && (p.x < a.x + (p.y-a.y)*(b.x-a.x)/(b.y-a.y)))
+                {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        }
+        for(qsizetype i=0; i<numVertices; i++)
+        {
+            const auto& a = vertices[i];
+            const auto& b = vertices[(i+1) % numVertices];
+            if (cross(a, b, p) <= tolerance*distance(a, b))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True if the segment from a to b passes through the interior of the
+    // obstacle. For convex obstacles, Cyrus-Beck clipping of the segment
+    // against the half planes of the edges, shrunk by the tolerance.
+    [[nodiscard]] bool blocks(const Point& a, const Point& b) const
+    {
+        if ((qMax(a.x, b.x) <= xMin) || (qMin(a.x, b.x) >= xMax) || (qMax(a.y, b.y) <= yMin) || (qMin(a.y, b.y) >= yMax))
+        {
+            return false;
+        }
+
+        if (!isConvex)
+        {
+            // A segment that crosses no edge lies either inside or outside
+            // the polygon, apart from points where it touches the boundary
+            auto numVertices = vertices.size();
+            for(qsizetype i=0; i<numVertices; i++)
+            {
+                if (crosses(a, b, vertices[i], vertices[(i+1) % numVertices]))
+                {
+                    return true;
+                }
+            }
+            return contains({0.5*(a.x+b.x), 0.5*(a.y+b.y)});
+        }
+
+        double t0 = 0.0;
+        double t1 = 1.0;
+        Point const d {b.x-a.x, b.y-a.y};
+        auto numVertices = vertices.size();
+        for(qsizetype i=0; i<numVertices; i++)
+        {
+            const auto& v = vertices[i];
+            const auto& w = vertices[(i+1) % numVertices];
+            auto edgeLength = distance(v, w);
+            if (edgeLength == 0.0)
+            {
+                continue;
+            }
+
+            // Inward unit normal of the edge; the interior lies to the left
+            Point const n {-(w.y-v.y)/edgeLength, (w.x-v.x)/edgeLength};
+            auto num = n.x*(a.x-v.x) + n.y*(a.y-v.y) - tolerance;
+            auto den = n.x*d.x + n.y*d.y;
+            if (den == 0.0)
+            {
+                if (num <= 0.0)
+                {
+                    return false;
+                }
+                continue;
+            }
+            auto t = -num/den;
+            if (den > 0.0)
+            {
+                t0 = qMax(t0, t);
+            }
+            else
+            {
+                t1 = qMin(t1, t);
+            }
+            if (t0 >= t1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Convex hull of a point set, using Andrew's monotone chain algorithm
+Obstacle convexHull(QList<Point> points)
+{
+    Obstacle result;
+    if (points.size() < 3)
+    {
+        return result;
+    }
+    std::sort(points.begin(), points.end(), [](const Point& p, const Point& q) { return (p.x < q.x) || ((p.x == q.x) && (p.y < q.y)); });
+
+    QList<Point> hull(2*points.size());
+    qsizetype k = 0;
+    for(const auto& p : std::as_const(points))
+    {
+        while ((k >= 2) && (cross(hull[k-2], hull[k-1], p) <= 0.0))
+        {
+            k--;
+        }
+        hull[k++] = p;
+    }
+    for(auto i=points.size()-2, lower=k+1; i>=0; i--)
+    {
+        const auto& p = points[i];
+        while ((k >= lower) && (cross(hull[k-2], hull[k-1], p) <= 0.0))
+        {
+            k--;
+        }
+        hull[k++] = p;
+    }
+    hull.resize(k-1);
+
+    result.vertices = hull;
+    result.updateBoundingBox();
+    return result;
+}
+
+// Equirectangular projection around a reference point
+class Projection
+{
+public:
+    Projection(double lat0, double lon0) : m_lat0(lat0), m_lon0(lon0), m_cosLat0(qCos(qDegreesToRadians(lat0))) {}
+
+    [[nodiscard]] Point toPlane(double lat, double lon) const
+    {
+        auto dLon = std::remainder(lon-m_lon0, 360.0);
+        return {qDegreesToRadians(dLon)*m_cosLat0*earthRadiusInM, qDegreesToRadians(lat-m_lat0)*earthRadiusInM};
+    }
+
+    [[nodiscard]] QGeoCoordinate toCoordinate(const Point& p) const
+    {
+        auto lat = m_lat0 + qRadiansToDegrees(p.y/earthRadiusInM);
+        auto lon = std::remainder(m_lon0 + qRadiansToDegrees(p.x/(m_cosLat0*earthRadiusInM)), 360.0);
+        return {lat, lon};
+    }
+
+private:
+    double m_lat0;
+    double m_lon0;
+    double m_cosLat0;
+};
+
+// True if the route needs to avoid the airspace
+bool isAvoided(const GeoMaps::Airspace& airspace, const QStringList& categories, Units::Distance altitudeLimit)
+{
+    if (!categories.contains(airspace.CAT()))
+    {
+        return false;
+    }
+    return !(airspace.estimatedLowerBoundMSL() >= altitudeLimit);
+}
+
+} // namespace
+
+
+auto Navigation::RouteOptimizer::containingAirspaces(const QGeoCoordinate& coordinate,
+                                                     const QList<GeoMaps::Airspace>& airspaces,
+                                                     const QStringList& categories,
+                                                     Units::Distance altitudeLimit) -> QStringList
+{
+    QStringList result;
+    for(const auto& airspace : airspaces)
+    {
+        if (isAvoided(airspace, categories, altitudeLimit) && airspace.contains(coordinate))
+        {
+            result.append(airspace.name());
+        }
+    }
+    return result;
+}
+
+
+auto Navigation::RouteOptimizer::route(const QGeoCoordinate& start,
+                                       const QGeoCoordinate& end,
+                                       const QList<GeoMaps::Airspace>& airspaces,
+                                       const QStringList& categories,
+                                       Units::Distance altitudeLimit,
+                                       Units::Distance margin) -> std::optional<QList<QGeoCoordinate>>
+{
+    if (!start.isValid() || !end.isValid())
+    {
+        return {};
+    }
+
+    // Region of interest: the bounding box of start and end, enlarged so
+    // that detours remain possible
+    auto routeLength = start.distanceTo(end);
+    auto extraInM = qMax(Units::Distance::fromNM(20).toM(), 0.5*routeLength) + margin.toM();
+    auto extraLatInDEG = qRadiansToDegrees(extraInM/earthRadiusInM);
+    auto latMin = qMax(-89.0, qMin(start.latitude(), end.latitude()) - extraLatInDEG);
+    auto latMax = qMin(89.0, qMax(start.latitude(), end.latitude()) + extraLatInDEG);
+    auto extraLonInDEG = extraLatInDEG/qMax(0.1, qMin(qCos(qDegreesToRadians(latMin)), qCos(qDegreesToRadians(latMax))));
+    auto lonMin = qMin(start.longitude(), end.longitude()) - extraLonInDEG;
+    auto lonMax = qMax(start.longitude(), end.longitude()) + extraLonInDEG;
+
+    Projection const projection(0.5*(start.latitude()+end.latitude()), start.longitude());
+    auto startPoint = projection.toPlane(start.latitude(), start.longitude());
+    auto endPoint = projection.toPlane(end.latitude(), end.longitude());
+
+    // Build obstacles, usually enlarged hulls. Every vertex is replaced by a
+    // regular octagon that contains the circle of radius margin around the
+    // vertex.
+    constexpr int numCirclePoints = 8;
+    auto radius = margin.toM()/qCos(M_PI/numCirclePoints);
+    QList<Obstacle> obstacles;
+    for(const auto& airspace : airspaces)
+    {
+        if (!isAvoided(airspace, categories, altitudeLimit))
+        {
+            continue;
+        }
+        if (!airspace.intersectsBox(latMin, latMax, lonMin, lonMax))
+        {
+            continue;
+        }
+
+        // Airspaces that contain start or end cannot be avoided
+        if (airspace.contains(start) || airspace.contains(end))
+        {
+            return {};
+        }
+
+        const auto& latitudes = airspace.latitudes();
+        const auto& longitudes = airspace.longitudes();
+        QList<Point> points;
+        points.reserve(latitudes.size()*numCirclePoints);
+        for(qsizetype i=0; i<latitudes.size(); i++)
+        {
+            auto p = projection.toPlane(latitudes[i], longitudes[i]);
+            for(int j=0; j<numCirclePoints; j++)
+            {
+                auto angle = 2.0*M_PI*j/numCirclePoints;
+                points.append({p.x+radius*qCos(angle), p.y+radius*qSin(angle)});
+            }
+        }
+        auto hull = convexHull(points);
+        if (hull.vertices.size() < 3)
+        {
+            continue;
+        }
+
+        // If start or end lie within the margin, or in a concave part of the
+        // airspace, the hull cannot be used. Use the actual polygon then,
+        // without margin.
+        if (hull.contains(startPoint) || hull.contains(endPoint))
+        {
+            Obstacle polygon;
+            polygon.isConvex = false;
+            for(qsizetype i=0; i<latitudes.size(); i++)
+            {
+                polygon.vertices.append(projection.toPlane(latitudes[i], longitudes[i]));
+            }
+            if ((polygon.vertices.size() > 1)
+                && (polygon.vertices.constFirst().x == polygon.vertices.constLast().x)
+                && (polygon.vertices.constFirst().y == polygon.vertices.constLast().y))
+            {
+                polygon.vertices.removeLast();
+            }
+            if (polygon.vertices.size() < 3)
+            {
+                continue;
+            }
+            polygon.updateBoundingBox();
+            obstacles.append(polygon);
+            continue;
+        }
+        obstacles.append(hull);
+    }
+
+    auto isVisible = [&obstacles](const Point& a, const Point& b)
+    {
+        return std::none_of(obstacles.cbegin(), obstacles.cend(), [&](const Obstacle& obstacle) { return obstacle.blocks(a, b); });
+    };
+
+    if (isVisible(startPoint, endPoint))
+    {
+        return QList<QGeoCoordinate>();
+    }
+
+    // Nodes of the visibility graph: start, end and all obstacle vertices
+    // that do not lie inside another obstacle. For obstacle vertices,
+    // remember the neighbouring vertices, for the tangent test.
+    struct Node
+    {
+        Point point;
+        Point previous;
+        Point next;
+        bool isObstacleVertex;
+    };
+    QList<Node> nodes;
+    nodes.append({startPoint, startPoint, startPoint, false});
+    nodes.append({endPoint, endPoint, endPoint, false});
+    for(qsizetype h=0; h<obstacles.size(); h++)
+    {
+        const auto& vertices = obstacles[h].vertices;
+        auto numVertices = vertices.size();
+        for(qsizetype i=0; i<numVertices; i++)
+        {
+            const auto& p = vertices[i];
+            bool isInside = false;
+            for(qsizetype other=0; other<obstacles.size(); other++)
+            {
+                if ((other != h) && obstacles[other].contains(p))
+                {
+                    isInside = true;
+                    break;
+                }
+            }
+            if (!isInside)
+            {
+                nodes.append({p, vertices[(i+numVertices-1) % numVertices], vertices[(i+1) % numVertices], true});
+            }
+        }
+    }
+
+    // A* search. Neighbours are generated when a node is expanded. A
+    // shortest path touches an obstacle vertex only if the path is tangent to
+    // the obstacle there, so vertices where both neighbours do not lie on the
+    // same side of the line of sight are skipped.
+    auto numNodes = nodes.size();
+    QList<double> costs(numNodes, qInf());
+    QList<qsizetype> parents(numNodes, -1);
+    QList<bool> closed(numNodes, false);
+    using QueueEntry = std::pair<double, qsizetype>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+    costs[0] = 0.0;
+    queue.emplace(distance(startPoint, endPoint), 0);
+    while (!queue.empty())
+    {
+        auto current = queue.top().second;
+        queue.pop();
+        if (closed[current])
+        {
+            continue;
+        }
+        closed[current] = true;
+        if (current == 1)
+        {
+            break;
+        }
+
+        const auto& from = nodes[current].point;
+        for(qsizetype candidate=1; candidate<numNodes; candidate++)
+        {
+            if (closed[candidate])
+            {
+                continue;
+            }
+            const auto& node = nodes[candidate];
+            if (node.isObstacleVertex)
+            {
+                auto side1 = cross(from, node.point, node.previous);
+                auto side2 = cross(from, node.point, node.next);
+                if (side1*side2 < 0.0)
+                {
+                    continue;
+                }
+            }
+            auto newCost = costs[current] + distance(from, node.point);
+            if (newCost >= costs[candidate])
+            {
+                continue;
+            }
+            if (!isVisible(from, node.point))
+            {
+                continue;
+            }
+            costs[candidate] = newCost;
+            parents[candidate] = current;
+            queue.emplace(newCost+distance(node.point, endPoint), candidate);
+        }
+    }
+
+    if (parents[1] < 0)
+    {
+        return {};
+    }
+
+    QList<QGeoCoordinate> result;
+    for(auto node=parents[1]; node > 0; node=parents[node])
+    {
+        result.prepend(projection.toCoordinate(nodes[node].point));
+    }
+    return result;
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QGeoCoordinate>
+#include <QStringList>
+#include <optional>
+
+#include "geomaps/Airspace.h"
+#include "units/Distance.h"
+
+
+namespace Navigation {
+
+/*! \brief Airspace-aware route planning
+ *
+ *  This class computes the shortest route between two points that avoids a
+ *  given set of airspaces. Every airspace is replaced by the convex hull of
+ *  its polygon, enlarged by a safety margin. The shortest route around
+ *  convex obstacles runs along tangents between hull vertices, so the route
+ *  is found by an A* search on the visibility graph of the hull vertices.
+ *  The graph is never built in full: neighbours of a vertex are computed
+ *  when the vertex is expanded, and only vertices that are tangent points
+ *  as seen from the expanded vertex are considered.
+ *
+ *  Computations use an equirectangular projection centred on the route,
+ *  which is accurate enough for routes of a few hundred nautical miles.
+ *
+ *  Because convex hulls are larger than the airspaces, the route may keep
+ *  more distance to concave airspaces than necessary. If the start or end
+ *  point lies within the margin of an airspace, or in a concave part of its
+ *  hull, the airspace is represented by its actual polygon, without margin.
+ *  Airspaces that contain the start or end point cannot be avoided. In that
+ *  case, no route is computed; use containingAirspaces() to find out which
+ *  airspaces are concerned.
+ */
+
+class RouteOptimizer
+{
+public:
+    /*! \brief Compute route
+     *
+     *  @param start Start point
+     *
+     *  @param end End point
+     *
+     *  @param airspaces List of airspaces. The method considers only those
+     *  airspaces whose category is contained in categories and whose lower
+     *  bound lies below altitudeLimit.
+     *
+     *  @param categories Categories of airspaces that are to be avoided, such
+     *  as "CTR" or "R"
+     *
+     *  @param altitudeLimit Airspaces whose estimated lower bound is at or
+     *  above this altitude are disregarded
+     *
+     *  @param margin Lateral distance that the route keeps from airspaces
+     *
+     *  @returns List of intermediate points of the route, not including start
+     *  and end. The list is empty if the direct route is free. If no route is
+     *  found, if start or end are invalid, or if start or end lie inside one
+     *  of the airspaces, std::nullopt is returned.
+     */
+    [[nodiscard]] static auto route(const QGeoCoordinate& start,
+                                    const QGeoCoordinate& end,
+                                    const QList<GeoMaps::Airspace>& airspaces,
+                                    const QStringList& categories,
+                                    Units::Distance altitudeLimit,
+                                    Units::Distance margin = Units::Distance::fromNM(0.5)) -> std::optional<QList<QGeoCoordinate>>;
+
+    /*! \brief Airspaces that contain a given point
+     *
+     *  @param coordinate Point
+     *
+     *  @param airspaces List of airspaces
+     *
+     *  @param categories Categories of airspaces, as in route()
+     *
+     *  @param altitudeLimit Altitude limit, as in route()
+     *
+     *  @returns Names of all airspaces that route() would avoid and that
+     *  contain the point
+     */
+    [[nodiscard]] static auto containingAirspaces(const QGeoCoordinate& coordinate,
+                                                  const QList<GeoMaps::Airspace>& airspaces,
+                                                  const QStringList& categories,
+                                                  Units::Distance altitudeLimit) -> QStringList;
+};
+
+} // namespace Navigation
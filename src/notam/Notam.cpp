@@ -18,7 +18,9 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <QCache>
 #include <QJsonObject>
+#include <QTimeZone>
 
 #include "GlobalObject.h"
 #include "GlobalSettings.h"
@@ -34,70 +36,228 @@ namespace {
 Q_GLOBAL_STATIC(QRegularExpression, cancelNotamStart, u"^[A-Z]\\d{4}/\\d{2} NOTAMC [A-Z]\\d{4}/\\d{2}"_qs)
 
 // Necessary because Q_GLOBAL_STATIC does not like templates
-using ContractionList = QList<std::pair<QRegularExpression, QString>>;
-Q_GLOBAL_STATIC(ContractionList,
+using ContractionHash = QHash<QString, QString>;
+Q_GLOBAL_STATIC(ContractionHash,
                 contractions,
                 {
-                    {QRegularExpression(u"\\bU/S\\b"_qs), u"UNSERVICEABLE"_qs}, // MUST COME BEFORE SOUTH
-
-                    {QRegularExpression(u"\\bACFT\\b"_qs), u"AIRCRAFT"_qs},
-                    {QRegularExpression(u"\\bAD\\b"_qs), u"AERODROME"_qs},
-                    {QRegularExpression(u"\\bAFIS\\b"_qs), u"AERODROME FLIGHT INFORMATION SERVICE"_qs},
-                    {QRegularExpression(u"\\bAFT\\b"_qs), u"AFTER"_qs},
-                    {QRegularExpression(u"\\bAMDT\\b"_qs), u"AMENDMENT"_qs},
-                    {QRegularExpression(u"\\bAPCH\\b"_qs), u"APPROACH"_qs},
-                    {QRegularExpression(u"\\bAPRX\\b"_qs), u"APPROXIMATELY"_qs},
-                    {QRegularExpression(u"\\bARP\\b"_qs), u"AERODROME REFERENCE POINT"_qs},
-                    {QRegularExpression(u"\\bARR\\b"_qs), u"ARRIVAL"_qs},
-                    {QRegularExpression(u"\\bASPH\\b"_qs), u"ASPHALT"_qs},
-                    {QRegularExpression(u"\\bAVBL\\b"_qs), u"AVAILABLE"_qs},
-                    {QRegularExpression(u"\\bBCST\\b"_qs), u"BROADCAST"_qs},
-                    {QRegularExpression(u"\\bBLW\\b"_qs), u"BELOW"_qs},
-                    {QRegularExpression(u"\\bBTN\\b"_qs), u"BETWEEN"_qs},
-                    {QRegularExpression(u"\\bCLBR\\b"_qs), u"CALLIBRATION"_qs},
-                    {QRegularExpression(u"\\bCLSD\\b"_qs), u"CLOSED"_qs},
-                    {QRegularExpression(u"\\bCNL\\b"_qs), u"CANCEL"_qs},
-                    {QRegularExpression(u"\\bCTN\\b"_qs), u"CAUTION"_qs},
-                    {QRegularExpression(u"\\bDEP\\b"_qs), u"DEPARTURE"_qs},
-                    {QRegularExpression(u"\\bDRG\\b"_qs), u"DURING"_qs},
-                    {QRegularExpression(u"\\bELEV\\b"_qs), u"ELEVATION"_qs},
-                    {QRegularExpression(u"\\bEQPT\\b"_qs), u"EQUIPMENT"_qs},
-                    {QRegularExpression(u"\\bEXC\\b"_qs), u"EXCEPTED"_qs},
-                    {QRegularExpression(u"\\bEXP\\b"_qs), u"EXPECT"_qs},
-                    {QRegularExpression(u"\\bFATO\\b"_qs), u"FINAL APPROACH AND TAKEOFF AREA"_qs},
-                    {QRegularExpression(u"\\bFST\\b"_qs), u"FIRST"_qs},
-                    {QRegularExpression(u"\\bFLT\\b"_qs), u"FLIGHT"_qs},
-                    {QRegularExpression(u"\\bFLW\\b"_qs), u"FOLLOW"_qs},
-                    {QRegularExpression(u"\\bGLD\\b"_qs), u"GLIDER"_qs},
-                    {QRegularExpression(u"\\bHEL\\b"_qs), u"HELICOPTER"_qs},
-                    {QRegularExpression(u"\\bLGT\\b"_qs), u"LIGHT"_qs},
-                    {QRegularExpression(u"\\bLGTD\\b"_qs), u"LIGHTED"_qs},
-                    {QRegularExpression(u"\\bLTD\\b"_qs), u"LIMITED"_qs},
-                    {QRegularExpression(u"\\bMAINT\\b"_qs), u"MAINTENANCE"_qs},
-                    {QRegularExpression(u"\\bN\\b"_qs), u"NORTH"_qs},
-                    {QRegularExpression(u"\\bNE\\b"_qs), u"NORTHEAST"_qs},
-                    {QRegularExpression(u"\\bNW\\b"_qs), u"NORTHWEST"_qs},
-                    {QRegularExpression(u"\\bO/R\\b"_qs), u"AVAILABLE ON REQUEST"_qs},
-                    {QRegularExpression(u"\\bOBST\\b"_qs), u"OBSTACLE"_qs},
-                    {QRegularExpression(u"\\bPOSS\\b"_qs), u"POSSIBLE"_qs},
-                    {QRegularExpression(u"\\bPSN\\b"_qs), u"POSITION"_qs},
-                    {QRegularExpression(u"\\bPRKG\\b"_qs), u"PARKING"_qs},
-                    {QRegularExpression(u"\\bRTE\\b"_qs), u"ROUTE"_qs},
-                    {QRegularExpression(u"\\bRVR\\b"_qs), u"RUNWAY VISUAL RANGE"_qs},
-                    {QRegularExpression(u"\\bRWY\\b"_qs), u"RUNWAY"_qs},
-                    {QRegularExpression(u"\\bS\\b"_qs), u"SOUTH"_qs},
-                    {QRegularExpression(u"\\bSE\\b"_qs), u"SOUTHEAST"_qs},
-                    {QRegularExpression(u"\\bSKED\\b"_qs), u"SCHEDULED"_qs},
-                    {QRegularExpression(u"\\bSW\\b"_qs), u"SOUTHWEST"_qs},
-                    {QRegularExpression(u"\\bTFC\\b"_qs), u"TRAFFIC"_qs},
-                    {QRegularExpression(u"\\bTHR\\b"_qs), u"THRESHOLD"_qs},
-                    {QRegularExpression(u"\\bTWR\\b"_qs), u"TOWER"_qs},
-                    {QRegularExpression(u"\\bTWY\\b"_qs), u"TAXIWAY"_qs},
-                    {QRegularExpression(u"\\bW\\b"_qs), u"WEST"_qs},
-                    {QRegularExpression(u"\\bWDI\\b"_qs), u"WIND DIRECTION INDICATOR"_qs},
-                    {QRegularExpression(u"\\bWI\\b"_qs), u"WITHIN"_qs},
-                    {QRegularExpression(u"\\bWIP\\b"_qs), u"WORK IN PROGRESS"_qs},
+                    {u"U/S"_qs, u"UNSERVICEABLE"_qs},
+                    {u"ACFT"_qs, u"AIRCRAFT"_qs},
+                    {u"AD"_qs, u"AERODROME"_qs},
+                    {u"AFIS"_qs, u"AERODROME FLIGHT INFORMATION SERVICE"_qs},
+                    {u"AFT"_qs, u"AFTER"_qs},
+                    {u"AMDT"_qs, u"AMENDMENT"_qs},
+                    {u"APCH"_qs, u"APPROACH"_qs},
+                    {u"APRX"_qs, u"APPROXIMATELY"_qs},
+                    {u"ARP"_qs, u"AERODROME REFERENCE POINT"_qs},
+                    {u"ARR"_qs, u"ARRIVAL"_qs},
+                    {u"ASPH"_qs, u"ASPHALT"_qs},
+                    {u"AVBL"_qs, u"AVAILABLE"_qs},
+                    {u"BCST"_qs, u"BROADCAST"_qs},
+                    {u"BLW"_qs, u"BELOW"_qs},
+                    {u"BTN"_qs, u"BETWEEN"_qs},
+                    {u"CLBR"_qs, u"CALLIBRATION"_qs},
+                    {u"CLSD"_qs, u"CLOSED"_qs},
+                    {u"CNL"_qs, u"CANCEL"_qs},
+                    {u"CTN"_qs, u"CAUTION"_qs},
+                    {u"DEP"_qs, u"DEPARTURE"_qs},
+                    {u"DRG"_qs, u"DURING"_qs},
+                    {u"ELEV"_qs, u"ELEVATION"_qs},
+                    {u"EQPT"_qs, u"EQUIPMENT"_qs},
+                    {u"EXC"_qs, u"EXCEPTED"_qs},
+                    {u"EXP"_qs, u"EXPECT"_qs},
+                    {u"FATO"_qs, u"FINAL APPROACH AND TAKEOFF AREA"_qs},
+                    {u"FST"_qs, u"FIRST"_qs},
+                    {u"FLT"_qs, u"FLIGHT"_qs},
+                    {u"FLW"_qs, u"FOLLOW"_qs},
+                    {u"GLD"_qs, u"GLIDER"_qs},
+                    {u"HEL"_qs, u"HELICOPTER"_qs},
+                    {u"LGT"_qs, u"LIGHT"_qs},
+                    {u"LGTD"_qs, u"LIGHTED"_qs},
+                    {u"LTD"_qs, u"LIMITED"_qs},
+                    {u"MAINT"_qs, u"MAINTENANCE"_qs},
+                    {u"N"_qs, u"NORTH"_qs},
+                    {u"NE"_qs, u"NORTHEAST"_qs},
+                    {u"NW"_qs, u"NORTHWEST"_qs},
+                    {u"O/R"_qs, u"AVAILABLE ON REQUEST"_qs},
+                    {u"OBST"_qs, u"OBSTACLE"_qs},
+                    {u"POSS"_qs, u"POSSIBLE"_qs},
+                    {u"PSN"_qs, u"POSITION"_qs},
+                    {u"PRKG"_qs, u"PARKING"_qs},
+                    {u"RTE"_qs, u"ROUTE"_qs},
+                    {u"RVR"_qs, u"RUNWAY VISUAL RANGE"_qs},
+                    {u"RWY"_qs, u"RUNWAY"_qs},
+                    {u"S"_qs, u"SOUTH"_qs},
+                    {u"SE"_qs, u"SOUTHEAST"_qs},
+                    {u"SKED"_qs, u"SCHEDULED"_qs},
+                    {u"SW"_qs, u"SOUTHWEST"_qs},
+                    {u"TFC"_qs, u"TRAFFIC"_qs},
+                    {u"THR"_qs, u"THRESHOLD"_qs},
+                    {u"TWR"_qs, u"TOWER"_qs},
+                    {u"TWY"_qs, u"TAXIWAY"_qs},
+                    {u"W"_qs, u"WEST"_qs},
+                    {u"WDI"_qs, u"WIND DIRECTION INDICATOR"_qs},
+                    {u"WI"_qs, u"WITHIN"_qs},
+                    {u"WIP"_qs, u"WORK IN PROGRESS"_qs},
                 })
+
+// Length of the longest key in contractions. Longer words are never looked up.
+constexpr qsizetype maxContractionLength = 5;
+
+// Cache for expanded NOTAM texts, keyed by NOTAM number. The original text is
+// stored alongside, so that NOTAMs that happen to share a number are not mixed
+// up.
+struct ExpandedText
+{
+    QString text;
+    QString expandedText;
+};
+using ExpandedTextCache = QCache<QString, ExpandedText>;
+Q_GLOBAL_STATIC(ExpandedTextCache, expandedTextCache, 500)
+
+// Word characters, in the sense of the regular expression "\b"
+bool isWordCharacter(QChar character)
+{
+    return character.isLetterOrNumber() || (character == u'_');
+}
+
+// Returns the expansion of the word text[start, end), or a null string if the
+// word is not a known contraction
+QString expansion(const QString& text, qsizetype start, qsizetype end)
+{
+    if (end-start > maxContractionLength)
+    {
+        return {};
+    }
+    return contractions->value(text.mid(start, end-start));
+}
+
+// Expands all contractions in a single pass over the text. Words are separated
+// by non-word characters. Contractions of the form "U/S" consist of two words
+// separated by a slash; these take precedence over the single-word
+// contractions.
+QString expandContractions(const QString& text)
+{
+    QString result;
+    result.reserve(2*text.size());
+
+    const auto size = text.size();
+    qsizetype index = 0;
+    while (index < size)
+    {
+        if (!isWordCharacter(text[index]))
+        {
+            result += text[index];
+            index++;
+            continue;
+        }
+
+        auto end = index;
+        while ((end < size) && isWordCharacter(text[end]))
+        {
+            end++;
+        }
+
+        if ((end+1 < size) && (text[end] == u'/') && isWordCharacter(text[end+1]))
+        {
+            auto slashEnd = end+1;
+            while ((slashEnd < size) && isWordCharacter(text[slashEnd]))
+            {
+                slashEnd++;
+            }
+            auto slashExpansion = expansion(text, index, slashEnd);
+            if (!slashExpansion.isNull())
+            {
+                result += slashExpansion;
+                index = slashEnd;
+                continue;
+            }
+        }
+
+        auto wordExpansion = expansion(text, index, end);
+        if (wordExpansion.isNull())
+        {
+            result += QStringView(text).sliced(index, end-index);
+        }
+        else
+        {
+            result += wordExpansion;
+        }
+        index = end;
+    }
+
+    return result;
+}
+
+// Parses dates of the form "2024-03-21T12:00:00.000Z", as used by the FAA,
+// without the overhead of QDateTime::fromString. Strings in other formats are
+// handed over to QDateTime::fromString.
+QDateTime parseISODate(const QString& string)
+{
+    auto size = string.size();
+    auto readDigits = [&](qsizetype position, qsizetype count, int& value)
+    {
+        value = 0;
+        for(auto index = position; index < position+count; index++)
+        {
+            auto character = string[index].unicode();
+            if ((character < u'0') || (character > u'9'))
+            {
+                return false;
+            }
+            value = 10*value + (character - u'0');
+        }
+        return true;
+    };
+
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    if ((size >= 20)
+        && readDigits(0, 4, year) && (string[4] == u'-')
+        && readDigits(5, 2, month) && (string[7] == u'-')
+        && readDigits(8, 2, day) && (string[10] == u'T')
+        && readDigits(11, 2, hour) && (string[13] == u':')
+        && readDigits(14, 2, minute) && (string[16] == u':')
+        && readDigits(17, 2, second))
+    {
+        // Optional fraction of a second. Digits beyond milliseconds are ignored.
+        qsizetype position = 19;
+        int msec = 0;
+        if (string[position] == u'.')
+        {
+            position++;
+            int digitCount = 0;
+            while ((position < size) && string[position].isDigit())
+            {
+                if (digitCount < 3)
+                {
+                    msec = 10*msec + string[position].digitValue();
+                    digitCount++;
+                }
+                position++;
+            }
+            for(; digitCount < 3; digitCount++)
+            {
+                msec *= 10;
+            }
+        }
+
+        if ((position == size-1) && (string[position] == u'Z'))
+        {
+            QDateTime result(QDate(year, month, day), QTime(hour, minute, second, msec), QTimeZone::UTC);
+            if (result.isValid())
+            {
+                return result;
+            }
+        }
+    }
+
+    return QDateTime::fromString(string, Qt::ISODate);
+}
+
 } // namespace
 
 
@@ -119,14 +279,35 @@ NOTAM::Notam::Notam(const QJsonObject& jsonObject)
     m_traffic = notamObject[u"traffic"_qs].toString();
     m_radius = Units::Distance::fromNM( notamObject[u"radius"_qs].toDouble() );
 
-    m_effectiveEnd = QDateTime::fromString(m_effectiveEndString, Qt::ISODate);
-    m_effectiveStart = QDateTime::fromString(m_effectiveStartString, Qt::ISODate);
-    m_region = QGeoCircle(m_coordinates, qMax( Units::Distance::fromNM(1).toM(), m_radius.toM() ));
-
     if (notamObject.contains(u"schedule"_qs))
     {
         m_schedule = notamObject[u"schedule"_qs].toString();
     }
+
+    computeDerivativeData();
+}
+
+
+NOTAM::Notam::Notam(const QString& coordinates,
+                    const QString& effectiveEnd,
+                    const QString& effectiveStart,
+                    const QString& icaoLocation,
+                    const QString& number,
+                    double radius,
+                    const QString& schedule,
+                    const QString& text,
+                    const QString& traffic)
+    : m_coordinates(interpretNOTAMCoordinates(coordinates)),
+      m_effectiveEndString(effectiveEnd),
+      m_effectiveStartString(effectiveStart),
+      m_icaoLocation(icaoLocation),
+      m_number(number),
+      m_radius(Units::Distance::fromNM(radius)),
+      m_schedule(schedule),
+      m_text(text),
+      m_traffic(traffic)
+{
+    computeDerivativeData();
 }
 
 
@@ -207,13 +388,13 @@ QString NOTAM::Notam::richText() const
 
     if (GlobalObject::globalSettings()->expandNotamAbbreviations())
     {
-        QString tmp = m_text;
-        foreach(auto contraction, *contractions)
+        auto* cached = expandedTextCache->object(m_number);
+        if ((cached == nullptr) || (cached->text != m_text))
         {
-            tmp.replace(contraction.first, contraction.second);
+            cached = new ExpandedText {m_text, expandContractions(m_text)};
+            expandedTextCache->insert(m_number, cached);
         }
-
-        result += tmp;
+        result += cached->expandedText;
     }
     else
     {
@@ -224,6 +405,19 @@ QString NOTAM::Notam::richText() const
 
 
 
+//
+// Private Methods
+//
+
+void NOTAM::Notam::computeDerivativeData()
+{
+    m_effectiveEnd = parseISODate(m_effectiveEndString);
+    m_effectiveStart = parseISODate(m_effectiveStartString);
+    m_region = QGeoCircle(m_coordinates, qMax( Units::Distance::fromNM(1).toM(), m_radius.toM() ));
+}
+
+
+
 //
 // Non-Member Methods
 //
@@ -47,6 +47,41 @@ public:
      */
     explicit Notam(const QJsonObject& jsonObject);
 
+    /*! \brief Constructs a Notam from the field values provided by the FAA
+     *
+     *  This constructor is used when reading FAA data with a streaming parser
+     *  that extracts the fields of the notam object directly. The parameters
+     *  correspond to the fields of the same name in the FAA data.
+     *
+     *  @param coordinates Coordinates, in the format described in
+     *  interpretNOTAMCoordinates()
+     *
+     *  @param effectiveEnd End of validity, typically as ISO date
+     *
+     *  @param effectiveStart Start of validity, typically as ISO date
+     *
+     *  @param icaoLocation ICAO code of the location
+     *
+     *  @param number Number of the Notam
+     *
+     *  @param radius Radius in nautical miles
+     *
+     *  @param schedule Schedule, or an empty string
+     *
+     *  @param text Text of the Notam
+     *
+     *  @param traffic Traffic entry of the Notam
+     */
+    Notam(const QString& coordinates,
+          const QString& effectiveEnd,
+          const QString& effectiveStart,
+          const QString& icaoLocation,
+          const QString& number,
+          double radius,
+          const QString& schedule,
+          const QString& text,
+          const QString& traffic);
+
     //
     // Properties
     //
@@ -177,6 +212,9 @@ public:
 
 
 private:
+    // Computes the derivative data from the FAA notam members
+    void computeDerivativeData();
+
     /* Notam members, as described by the FAA */
     QGeoCoordinate  m_coordinates;
     QString         m_effectiveEndString;
@@ -26,14 +26,424 @@
 #include "notam/NotamProvider.h"
 
 
+namespace {
+
+// Minimal pull parser for JSON data, used to read FAA responses without
+// building a QJsonDocument. The parser works directly on the UTF-8 data and
+// only creates QStrings for values that are actually requested. Once an
+// error occurs, isOk() returns false and all further reads return
+// immediately.
+class JSONScanner
+{
+public:
+    explicit JSONScanner(QByteArrayView data)
+        : m_current(data.begin()), m_end(data.end())
+    {
+    }
+
+    // True if no error has occurred so far
+    [[nodiscard]] bool isOk() const { return m_ok; }
+
+    // Reads an object. For every member, readMember is called with the raw
+    // key. The function readMember must consume the value.
+    template<typename F> void readObject(F readMember)
+    {
+        if (!expect('{'))
+        {
+            return;
+        }
+        skipWhitespace();
+        if (peek() == '}')
+        {
+            m_current++;
+            return;
+        }
+        while (m_ok)
+        {
+            auto key = readRawString();
+            if (!expect(':'))
+            {
+                return;
+            }
+            readMember(key);
+            skipWhitespace();
+            if (peek() == ',')
+            {
+                m_current++;
+                continue;
+            }
+            expect('}');
+            return;
+        }
+    }
+
+    // Reads an array. For every element, readElement is called. The function
+    // readElement must consume the element.
+    template<typename F> void readArray(F readElement)
+    {
+        if (!expect('['))
+        {
+            return;
+        }
+        skipWhitespace();
+        if (peek() == ']')
+        {
+            m_current++;
+            return;
+        }
+        while (m_ok)
+        {
+            readElement();
+            skipWhitespace();
+            if (peek() == ',')
+            {
+                m_current++;
+                continue;
+            }
+            expect(']');
+            return;
+        }
+    }
+
+    // Reads a string. Values of other types are skipped, and an empty string
+    // is returned.
+    QString readString()
+    {
+        skipWhitespace();
+        if (peek() != '"')
+        {
+            skipValue();
+            return {};
+        }
+        return unescape(readRawString());
+    }
+
+    // Reads a number. Values of other types are skipped, and 0 is returned.
+    double readNumber()
+    {
+        skipWhitespace();
+        const auto* start = m_current;
+        while ((m_current < m_end) && isNumberCharacter(*m_current))
+        {
+            m_current++;
+        }
+        if (m_current == start)
+        {
+            skipValue();
+            return 0.0;
+        }
+        bool ok = false;
+        auto result = QByteArrayView(start, m_current).toDouble(&ok);
+        if (!ok)
+        {
+            m_ok = false;
+            return 0.0;
+        }
+        return result;
+    }
+
+    // Skips over a value of any type
+    void skipValue()
+    {
+        skipWhitespace();
+        switch(peek())
+        {
+        case '"':
+            readRawString();
+            return;
+        case '{':
+            readObject([this](QByteArrayView /*key*/) { skipValue(); });
+            return;
+        case '[':
+            readArray([this]() { skipValue(); });
+            return;
+        default:
+            // Numbers and the literals true, false, null
+            const auto* start = m_current;
+            while ((m_current < m_end) && (isNumberCharacter(*m_current) || ((*m_current >= 'a') && (*m_current <= 'z'))))
+            {
+                m_current++;
+            }
+            if (m_current == start)
+            {
+                m_ok = false;
+            }
+        }
+    }
+
+private:
+    static bool isNumberCharacter(char character)
+    {
+        return ((character >= '0') && (character <= '9'))
+               || (character == '-') || (character == '+') || (character == '.')
+               || (character == 'e') || (character == 'E');
+    }
+
+    [[nodiscard]] char peek() const
+    {
+        return (m_ok && (m_current < m_end)) ? *m_current : '\0';
+    }
+
+    void skipWhitespace()
+    {
+        while ((m_current < m_end) && ((*m_current == ' ') || (*m_current == '\n') || (*m_current == '\r') || (*m_current == '\t')))
+        {
+            m_current++;
+        }
+    }
+
+    bool expect(char character)
+    {
+        skipWhitespace();
+        if (peek() != character)
+        {
+            m_ok = false;
+            return false;
+        }
+        m_current++;
+        return true;
+    }
+
+    // Reads a string and returns its content, with escape sequences intact
+    QByteArrayView readRawString()
+    {
+        if (!expect('"'))
+        {
+            return {};
+        }
+        const auto* start = m_current;
+        while (m_current < m_end)
+        {
+            if (*m_current == '\\')
+            {
+                m_current++;
+                if (m_current < m_end)
+                {
+                    m_current++;
+                }
+                continue;
+            }
+            if (*m_current == '"')
+            {
+                QByteArrayView const result(start, m_current);
+                m_current++;
+                return result;
+            }
+            m_current++;
+        }
+        m_ok = false;
+        return {};
+    }
+
+    // Resolves the escape sequences in the content of a string
+    static QString unescape(QByteArrayView raw)
+    {
+        if (!raw.contains('\\'))
+        {
+            return QString::fromUtf8(raw);
+        }
+
+        QString result;
+        result.reserve(raw.size());
+        qsizetype runStart = 0;
+        for(qsizetype index = 0; index < raw.size(); index++)
+        {
+            if (raw[index] != '\\')
+            {
+                continue;
+            }
+            result += QString::fromUtf8(raw.sliced(runStart, index-runStart));
+            index++;
+            if (index >= raw.size())
+            {
+                runStart = index;
+                break;
+            }
+            switch(raw[index])
+            {
+            case 'b':
+                result += u'\b';
+                break;
+            case 'f':
+                result += u'\f';
+                break;
+            case 'n':
+                result += u'\n';
+                break;
+            case 'r':
+                result += u'\r';
+                break;
+            case 't':
+                result += u'\t';
+                break;
+            case 'u':
+                if (index+4 < raw.size())
+                {
+                    bool ok = false;
+                    auto codeUnit = raw.sliced(index+1, 4).toUShort(&ok, 16);
+                    if (ok)
+                    {
+                        result += QChar(codeUnit);
+                    }
+                    index += 4;
+                }
+                break;
+            default:
+                result += QLatin1Char(raw[index]);
+            }
+            runStart = index+1;
+        }
+        if (runStart < raw.size())
+        {
+            result += QString::fromUtf8(raw.sliced(runStart));
+        }
+        return result;
+    }
+
+    const char* m_current;
+    const char* m_end;
+    bool m_ok {true};
+};
+
+
+// Reads the notam object of an FAA item, extracting only the fields that
+// NOTAM::Notam stores
+NOTAM::Notam readNotam(JSONScanner& scanner)
+{
+    QString coordinates;
+    QString effectiveEnd;
+    QString effectiveStart;
+    QString icaoLocation;
+    QString number;
+    double radius = 0.0;
+    QString schedule;
+    QString text;
+    QString traffic;
+
+    scanner.readObject([&](QByteArrayView key)
+    {
+        if (key == "coordinates")
+        {
+            coordinates = scanner.readString();
+        }
+        else if (key == "effectiveEnd")
+        {
+            effectiveEnd = scanner.readString();
+        }
+        else if (key == "effectiveStart")
+        {
+            effectiveStart = scanner.readString();
+        }
+        else if (key == "icaoLocation")
+        {
+            icaoLocation = scanner.readString();
+        }
+        else if (key == "number")
+        {
+            number = scanner.readString();
+        }
+        else if (key == "radius")
+        {
+            radius = scanner.readNumber();
+        }
+        else if (key == "schedule")
+        {
+            schedule = scanner.readString();
+        }
+        else if (key == "text")
+        {
+            text = scanner.readString();
+        }
+        else if (key == "traffic")
+        {
+            traffic = scanner.readString();
+        }
+        else
+        {
+            scanner.skipValue();
+        }
+    });
+
+    return {coordinates, effectiveEnd, effectiveStart, icaoLocation, number, radius, schedule, text, traffic};
+}
+
+
+// Reads an item of the FAA data, of the form
+// {"properties": {"coreNOTAMData": {"notam": {...}}}}. Returns an invalid
+// Notam if the item does not contain a notam object.
+NOTAM::Notam readItem(JSONScanner& scanner)
+{
+    NOTAM::Notam result;
+    scanner.readObject([&](QByteArrayView key)
+    {
+        if (key != "properties")
+        {
+            scanner.skipValue();
+            return;
+        }
+        scanner.readObject([&](QByteArrayView propertiesKey)
+        {
+            if (propertiesKey != "coreNOTAMData")
+            {
+                scanner.skipValue();
+                return;
+            }
+            scanner.readObject([&](QByteArrayView coreKey)
+            {
+                if (coreKey != "notam")
+                {
+                    scanner.skipValue();
+                    return;
+                }
+                result = readNotam(scanner);
+            });
+        });
+    });
+    return result;
+}
+
+
+// Reads all items of FAA GeoJSON data into the list notams. Returns false if
+// the data could not be parsed.
+bool readItems(const QByteArray& jsonData, QList<NOTAM::Notam>& notams)
+{
+    JSONScanner scanner(jsonData);
+    scanner.readObject([&](QByteArrayView key)
+    {
+        if (key != "items")
+        {
+            scanner.skipValue();
+            return;
+        }
+        scanner.readArray([&]()
+        {
+            notams.append(readItem(scanner));
+        });
+    });
+    return scanner.isOk();
+}
+
+} // namespace
+
+
 NOTAM::NotamList::NotamList(const QByteArray& jsonData, const QGeoCircle& region, QSet<QString>* cancelledNotamNumbers)
 {
-    auto doc = QJsonDocument::fromJson(jsonData);
-    auto items = doc[u"items"_qs].toArray();
+    // Read the data with the streaming parser. If that fails, fall back to
+    // QJsonDocument, which is slower but more forgiving.
+    QList<Notam> notams;
+    if (!readItems(jsonData, notams))
+    {
+        notams.clear();
+        auto doc = QJsonDocument::fromJson(jsonData);
+        foreach(auto item, doc[u"items"_qs].toArray())
+        {
+            notams.append(Notam(item.toObject()));
+        }
+    }
+    QSet<QString> numbersSeen;
 
-    foreach(auto item, items)
+    foreach(auto notam, notams)
     {
-        Notam const notam(item.toObject());
 
         // Ignore invalid notams
         if (!notam.isValid())
@@ -62,11 +472,12 @@ NOTAM::NotamList::NotamList(const QByteArray& jsonData, const QGeoCircle& region
         }
 
         // Ignore duplicated entries
-        if (m_notams.contains(notam))
+        if (numbersSeen.contains(notam.number()))
         {
             continue;
         }
 
+        numbersSeen += notam.number();
         m_notams.append(notam);
     }
 
@@ -123,6 +534,7 @@ NOTAM::NotamList NOTAM::NotamList::cleaned(const QSet<QString>& cancelledNotamNu
     NotamList result;
     result.m_region = m_region;
     result.m_retrieved = m_retrieved;
+    QSet<QString> numbersSeen;
 
     foreach(auto notam, m_notams)
     {
@@ -138,10 +550,11 @@ NOTAM::NotamList NOTAM::NotamList::cleaned(const QSet<QString>& cancelledNotamNu
         {
             continue;
         }
-        if (result.m_notams.contains(notam))
+        if (numbersSeen.contains(notam.number()))
         {
             continue;
         }
+        numbersSeen += notam.number();
         result.m_notams.append(notam);
     }
 
@@ -156,6 +569,7 @@ NOTAM::NotamList NOTAM::NotamList::restricted(const GeoMaps::Waypoint& waypoint)
     auto radius = qMax(0.0, m_region.radius() - m_region.center().distanceTo(waypoint.coordinate()));
 
     result.m_region = QGeoCircle(waypoint.coordinate(), radius);
+    QSet<QString> numbersSeen;
 
     foreach(auto notam, m_notams)
     {
@@ -167,7 +581,7 @@ NOTAM::NotamList NOTAM::NotamList::restricted(const GeoMaps::Waypoint& waypoint)
         {
             continue;
         }
-        if (result.m_notams.contains(notam))
+        if (numbersSeen.contains(notam.number()))
         {
             continue;
         }
@@ -175,31 +589,65 @@ NOTAM::NotamList NOTAM::NotamList::restricted(const GeoMaps::Waypoint& waypoint)
         {
             continue;
         }
+        numbersSeen += notam.number();
         result.m_notams.append(notam);
     }
 
-    std::sort(result.m_notams.begin(), result.m_notams.end(),
-              [](const Notam& first, const Notam& second)
+    result.sortByRelevance();
+    return result;
+}
+
+
+
+//
+// Private Methods
+//
+
+void NOTAM::NotamList::sortByRelevance()
+{
+    struct SortKey
+    {
+        bool read;
+        QDateTime effectiveStart;
+        QDateTime effectiveEnd;
+        qsizetype index;
+    };
+
+    auto* notamProvider = GlobalObject::notamProvider();
+    auto cur = QDateTime::currentDateTime();
+
+    QList<SortKey> keys;
+    keys.reserve(m_notams.size());
+    for(qsizetype index = 0; index < m_notams.size(); index++)
+    {
+        const auto& notam = m_notams[index];
+        keys.append({notamProvider->isRead(notam.number()),
+                     qMax(notam.effectiveStart(), cur),
+                     notam.effectiveEnd(),
+                     index});
+    }
+
+    std::sort(keys.begin(), keys.end(),
+              [](const SortKey& first, const SortKey& second)
     {
-        auto aRead = GlobalObject::notamProvider()->isRead(first.number());
-        auto bRead = GlobalObject::notamProvider()->isRead(second.number());
-        if (aRead != bRead)
+        if (first.read != second.read)
         {
-            return !aRead;
+            return !first.read;
         }
-
-        auto cur = QDateTime::currentDateTime();
-        auto a_effectiveStart = qMax(first.effectiveStart(), cur);
-        auto b_effectiveStart = qMax(second.effectiveStart(), cur);
-
-        if (a_effectiveStart != b_effectiveStart)
+        if (first.effectiveStart != second.effectiveStart)
         {
-            return a_effectiveStart < b_effectiveStart;
+            return first.effectiveStart < second.effectiveStart;
         }
-        return first.effectiveEnd() < second.effectiveEnd();
+        return first.effectiveEnd < second.effectiveEnd;
     });
 
-    return result;
+    QList<Notam> sortedNotams;
+    sortedNotams.reserve(m_notams.size());
+    foreach(auto key, keys)
+    {
+        sortedNotams.append(m_notams[key.index]);
+    }
+    m_notams = sortedNotams;
 }
 
 
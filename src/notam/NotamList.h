@@ -42,6 +42,7 @@ class NotamList {
 
     friend QDataStream& operator<<(QDataStream& stream, const NOTAM::NotamList& notamList);
     friend QDataStream& operator>>(QDataStream& stream, NOTAM::NotamList& notamList);
+    friend class NotamStore;
 
 public:
     /*! \brief Constructs an empty NotamList
@@ -180,6 +181,10 @@ public:
 
 
 private:
+    // Sorts m_notams so that unread Notams come first, then by effective start
+    // and effective end. The sort keys are computed once per Notam.
+    void sortByRelevance();
+
     /* List of Notams */
     QList<NOTAM::Notam> m_notams;
 
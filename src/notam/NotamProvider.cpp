@@ -18,9 +18,10 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-#include <QFile>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
 #include <chrono>
 
 #include "GlobalSettings.h"
@@ -41,6 +42,7 @@ NOTAM::NotamProvider::NotamProvider(QObject* parent) :
 {
     // Set stdFileName for saving and loading NOTAM data
     m_stdFileName = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+u"/notam.dat"_qs;
+    m_journalFileName = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+u"/notam.journal"_qs;
 }
 
 
@@ -61,28 +63,20 @@ void NOTAM::NotamProvider::deferredInitialization()
     timer->start(61min);
     connect(timer, &QTimer::timeout, this, &NOTAM::NotamProvider::clean);
 
-    // Save the NOTAM data every time that the database changes
-    connect(this, &NOTAM::NotamProvider::dataChanged, this, &NOTAM::NotamProvider::save, Qt::QueuedConnection);
-
-    // Load NOTAM data from file in stdFileName, then clean the data (which potentially triggers save()).
-    auto inputFile = QFile(m_stdFileName);
-    if (inputFile.open(QIODevice::ReadOnly))
+    // Load NOTAM data from snapshot and journal, then clean the data. If the
+    // journal has grown large, write a fresh snapshot in the background.
+    load();
+    clean();
+    if (journalNeedsCompaction())
     {
-        QDataStream inputStream(&inputFile);
-        QString magicString;
-        inputStream >> magicString;
-        if (magicString == QStringLiteral(GIT_COMMIT))
-        {
-            inputStream >> m_readNotamNumbers;
-            inputStream >> m_notamLists;
-        }
+        compact();
     }
-    clean();
 }
 
 
 NOTAM::NotamProvider::~NotamProvider()
 {
+    m_requestQueue.clear();
     foreach(auto networkReply, m_networkReplies)
     {
         if (networkReply.isNull())
@@ -92,71 +86,10 @@ NOTAM::NotamProvider::~NotamProvider()
         networkReply->abort();
     }
 
-    m_notamLists.clear();
+    m_notamStore.clear();
     m_networkReplies.clear();
-}
-
 
-
-//
-// Getter Methods
-//
-
-QList<GeoMaps::Waypoint> NOTAM::NotamProvider::waypoints() const
-{
-    QList<GeoMaps::Waypoint> result;
-    QSet<QGeoCoordinate> coordinatesSeen;
-    QSet<QGeoCircle> regionsCovered;
-
-    foreach(auto notamList, m_notamLists)
-    {
-        foreach(auto notam, notamList.notams())
-        {
-            if (!notam.isValid() || notam.isOutdated())
-            {
-                continue;
-            }
-            auto coordinate = notam.coordinate();
-            if (!coordinate.isValid())
-            {
-                continue;
-            }
-            if (!notamList.region().contains(coordinate))
-            {
-                continue;
-            }
-
-
-            // If we already have a waypoint for that coordinate, then don't add another one.
-            if (coordinatesSeen.contains(coordinate))
-            {
-                continue;
-            }
-
-            // If the coordinate has already been handled by an earlier (=newer) notamList,
-            // then don't add it here.
-            bool hasBeenCovered = false;
-            foreach(auto region, regionsCovered)
-            {
-                if (region.contains(coordinate))
-                {
-                    hasBeenCovered = true;
-                    break;
-                }
-            }
-            if (hasBeenCovered)
-            {
-                continue;
-            }
-
-            coordinatesSeen += coordinate;
-            result.append(coordinate);
-        }
-
-        regionsCovered += notamList.region();
-    }
-
-    return result;
+    m_compactionWriter.waitForFinished();
 }
 
 
@@ -174,42 +107,23 @@ NOTAM::NotamList NOTAM::NotamProvider::notams(const GeoMaps::Waypoint& waypoint)
     }
 
     // Check if notams for the location are present in our database.
-    // Go through the database, oldest to newest.
-    foreach (auto notamList, m_notamLists)
+    auto listIndex = m_notamStore.listIndex(waypoint.coordinate());
+    if (listIndex >= 0)
     {
-        // Disregard outdated notamLists
-        if (notamList.isOutdated())
+        // If motamList needs an update, then ask for an update
+        if (m_notamStore.notamLists().at(listIndex).needsUpdate())
         {
-            continue;
+            startRequest(waypoint.coordinate());
         }
 
-        if (notamList.region().contains(waypoint.coordinate()))
-        {
-            // If motamList needs an update, then ask for an update
-            if (notamList.needsUpdate())
-            {
-                startRequest(waypoint.coordinate());
-            }
-
-            return notamList.restricted(waypoint);
-        }
+        return m_notamStore.notams(waypoint, listIndex);
     }
 
     // Check if internet requests notams for the location are pending.
     // In that case, return an empty list.
-    foreach(auto networkReply, m_networkReplies)
+    foreach(auto region, m_pendingRegions)
     {
-        // Paranoid safety checks
-        if (networkReply.isNull())
-        {
-            continue;
-        }
-        auto area = networkReply->property("area").value<QGeoCircle>();
-        if (!area.isValid())
-        {
-            continue;
-        }
-        if (area.contains(waypoint.coordinate()))
+        if (region.contains(waypoint.coordinate()))
         {
             return {};
         }
@@ -236,7 +150,11 @@ void NOTAM::NotamProvider::setRead(const QString& number, bool read)
     {
         m_readNotamNumbers.removeAll(number);
     }
-    save();
+
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream << number << read;
+    appendToJournal(JournalRecord::ReadStateChanged, payload);
 }
 
 
@@ -253,7 +171,7 @@ void NOTAM::NotamProvider::clean()
     bool haveChange = false;
 
     // Iterate over notamLists, newest lists first
-    foreach(auto notamList, m_notamLists)
+    foreach(auto notamList, m_notamStore.notamLists())
     {
         // If this notamList is outdated, then so all all further ones. We can thus end here.
         if (notamList.isOutdated())
@@ -283,8 +201,12 @@ void NOTAM::NotamProvider::clean()
 
     if (haveChange)
     {
-        m_notamLists = newNotamLists;
+        m_notamStore.setNotamLists(newNotamLists);
         emit dataChanged();
+
+        // Cleaning is not journaled, because it is redone when the journal is
+        // replayed. The dropped data disappears from disk with the next
+        // compaction.
     }
 
 }
@@ -292,6 +214,7 @@ void NOTAM::NotamProvider::clean()
 
 void NOTAM::NotamProvider::clearAllAndUpdate()
 {
+    m_requestQueue.clear();
     foreach(auto networkReply, m_networkReplies)
     {
         if (networkReply.isNull())
@@ -301,8 +224,11 @@ void NOTAM::NotamProvider::clearAllAndUpdate()
         networkReply->abort();
     }
 
-    m_notamLists.clear();
+    m_notamStore.clear();
     m_networkReplies.clear();
+    m_pendingRegions.clear();
+    m_generation++;
+    appendToJournal(JournalRecord::Cleared);
 
     updateData();
 }
@@ -310,8 +236,6 @@ void NOTAM::NotamProvider::clearAllAndUpdate()
 
 void NOTAM::NotamProvider::downloadFinished()
 {
-
-    bool newDataAdded = false;
     m_networkReplies.removeAll(nullptr);
     foreach(auto networkReply, m_networkReplies)
     {
@@ -328,53 +252,114 @@ void NOTAM::NotamProvider::downloadFinished()
         {
             continue;
         }
+        m_networkReplies.removeAll(networkReply);
+        networkReply->deleteLater();
+
+        auto region = networkReply->property("area").value<QGeoCircle>();
         if (networkReply->error() != QNetworkReply::NoError)
         {
-            networkReply->deleteLater();
+            m_pendingRegions.removeOne(region);
             continue;
         }
 
-        auto region = networkReply->property("area").value<QGeoCircle>();
+        // Parse data in a background thread and add the result to the
+        // database in the GUI thread. Results are discarded if the database
+        // has been cleared in the meantime, for instance because the FAA key
+        // changed.
         auto data = networkReply->readAll();
-        networkReply->deleteLater();
-        NotamList const notamList(data, region, &m_cancelledNotamNumbers);
-        m_notamLists.prepend(notamList);
-        newDataAdded = true;
+        auto generation = m_generation;
+        QtConcurrent::run([data, region]()
+        {
+            QSet<QString> cancelledNotamNumbers;
+            NotamList const notamList(data, region, &cancelledNotamNumbers);
+            return std::pair(notamList, cancelledNotamNumbers);
+        }).then(this, [this, region, generation](const std::pair<NotamList, QSet<QString>>& result)
+        {
+            if (generation != m_generation)
+            {
+                return;
+            }
+            m_pendingRegions.removeOne(region);
+            addNotamList(result.first, result.second);
+        });
     }
 
-    if (newDataAdded)
-    {
-        clean();
-        m_lastUpdate = QDateTime::currentDateTimeUtc();
-        emit dataChanged();
-    }
+    sendRequests();
 }
 
 
-void NOTAM::NotamProvider::save() const
+void NOTAM::NotamProvider::compact()
 {
-    auto outputFile = QFile(m_stdFileName);
-    if (outputFile.open(QIODevice::WriteOnly))
+    if (m_compactionRunning)
     {
+        m_compactionPending = true;
+        return;
+    }
+    m_compactionRunning = true;
+    m_compactionPending = false;
+
+    auto fileName = m_stdFileName;
+    auto sequenceNumber = m_sequenceNumber;
+    auto readNotamNumbers = m_readNotamNumbers;
+    auto notamLists = m_notamStore.notamLists();
+    m_compactionWriter = QtConcurrent::run([fileName, sequenceNumber, readNotamNumbers, notamLists]()
+    {
+        auto outputFile = QSaveFile(fileName);
+        if (!outputFile.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
         QDataStream outputStream(&outputFile);
         outputStream << QStringLiteral(GIT_COMMIT);
-        outputStream << m_readNotamNumbers;
-        outputStream << m_notamLists;
-    }
+        outputStream << sequenceNumber;
+        outputStream << readNotamNumbers;
+        outputStream << notamLists;
+        return outputFile.commit();
+    });
+    m_compactionWriter.then(this, [this, sequenceNumber](bool success)
+    {
+        m_compactionRunning = false;
+
+        // If no records have been appended while the snapshot was written,
+        // then the journal is no longer needed. Otherwise, the journal is
+        // kept. Records contained in the snapshot will be skipped on replay,
+        // and the journal will be truncated by the next compaction.
+        if (success && (sequenceNumber == m_sequenceNumber))
+        {
+            resetJournal();
+        }
+        if (m_compactionPending)
+        {
+            compact();
+        }
+    });
 }
 
 
 void NOTAM::NotamProvider::updateData()
 {
+    // Regions that are covered by existing or requested data. Every region
+    // requested below is added, so that later points see it.
+    auto regions = coverage();
+    auto request = [&](const QGeoCoordinate& coordinate)
+    {
+        if (!startRequest(coordinate))
+        {
+            return false;
+        }
+        regions.append(m_pendingRegions.constLast());
+        return true;
+    };
+
     // Check if Notam data is available for a circle of marginRadius around
     // the current position.
     auto position = Positioning::PositionProvider::lastValidCoordinate();
     if (position.isValid())
     {
-        auto _range = range(position);
+        auto _range = range(position, regions);
         if (_range < marginRadius)
         {
-            startRequest(position);
+            request(position);
         }
     }
 
@@ -383,28 +368,34 @@ void NOTAM::NotamProvider::updateData()
     {
         foreach(auto leg, route->legs())
         {
-            QGeoCoordinate startPoint = leg.startPoint().coordinate();
-            QGeoCoordinate const endPoint = leg.endPoint().coordinate();
-            if (!startPoint.isValid() || !endPoint.isValid())
+            if (!leg.isValid())
             {
                 continue;
             }
 
+            // Distance of the startPoint from the start of the leg
+            auto covered = Units::Distance::fromM(0.0);
             while(true)
             {
                 // Check if the range at the startPoint at least marginRadius+1NM
                 // If not, request data for startPoint and start over
-                auto rangeAtStartPoint = range(startPoint);
+                auto startPoint = leg.pointAtDistance(covered);
+                auto rangeAtStartPoint = range(startPoint, regions);
                 if (rangeAtStartPoint < marginRadius+Units::Distance::fromNM(1))
                 {
-                    startRequest(startPoint);
-                    continue;
+                    if (request(startPoint))
+                    {
+                        continue;
+                    }
+                    // No request could be issued, for instance because no
+                    // FAA key is set. There is nothing more to do here.
+                    return;
                 }
 
                 // Check if every point between startPoint and endPoint has a range
                 // of at least marginRadius. If so, there is nothing to do for this
                 // and we continue with the next leg.
-                auto distanceToEndPoint = Units::Distance::fromM(startPoint.distanceTo(endPoint));
+                auto distanceToEndPoint = leg.distance()-covered;
                 if (rangeAtStartPoint > distanceToEndPoint+marginRadius)
                 {
                     break;
@@ -413,8 +404,7 @@ void NOTAM::NotamProvider::updateData()
                 // Move the startPoint closer to the endPoint, so all points between
                 // the new and the old startPoint have a range of at least
                 // marginRadius. Then start over.
-                auto azimuth = startPoint.azimuthTo(endPoint);
-                startPoint = startPoint.atDistanceAndAzimuth((rangeAtStartPoint-marginRadius).toM(), azimuth);
+                covered += rangeAtStartPoint-marginRadius;
             }
         }
     }
@@ -427,92 +417,286 @@ void NOTAM::NotamProvider::updateData()
 // Private Methods
 //
 
-Units::Distance NOTAM::NotamProvider::range(const QGeoCoordinate& position)
+void NOTAM::NotamProvider::addNotamList(const NOTAM::NotamList& notamList, const QSet<QString>& cancelledNotamNumbers)
 {
-    auto result = Units::Distance::fromM(-1.0);
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream << QList<NotamList>({notamList}) << cancelledNotamNumbers;
+    appendToJournal(JournalRecord::NotamListsAdded, payload);
+
+    m_cancelledNotamNumbers += cancelledNotamNumbers;
+    m_notamStore.setNotamLists(QList<NotamList>({notamList}) + m_notamStore.notamLists());
+    clean();
+    m_lastUpdate = QDateTime::currentDateTimeUtc();
+    emit dataChanged();
+}
 
-    if (!position.isValid())
-    {
-        return result;
-    }
 
-    // If we have a NOTAM list that contains the position
-    // within half its radius, then stop.
-    foreach (auto notamList, m_notamLists)
+QList<QGeoCircle> NOTAM::NotamProvider::coverage() const
+{
+    auto result = m_pendingRegions;
+    foreach (auto notamList, m_notamStore.notamLists())
     {
         if (notamList.isOutdated())
         {
             continue;
         }
-
         auto region = notamList.region();
         if (!region.isValid())
         {
             continue;
         }
+        result.append(region);
+    }
+    return result;
+}
+
+
+Units::Distance NOTAM::NotamProvider::range(const QGeoCoordinate& position, const QList<QGeoCircle>& regions)
+{
+    auto result = Units::Distance::fromM(-1.0);
+
+    if (!position.isValid())
+    {
+        return result;
+    }
+
+    // There are only a few regions, so a plain loop is cheapest
+    foreach (auto region, regions)
+    {
         auto rangeInM = region.radius() - region.center().distanceTo(position);
         result = qMax(result, Units::Distance::fromM(rangeInM));
     }
 
-    foreach(auto networkReply, m_networkReplies)
+    return result;
+}
+
+
+void NOTAM::NotamProvider::appendToJournal(JournalRecord type, const QByteArray& payload)
+{
+    if (!m_journal.isOpen())
     {
-        // Paranoid safety checks
-        if (networkReply.isNull())
+        return;
+    }
+
+    m_sequenceNumber++;
+    QDataStream journalStream(&m_journal);
+    journalStream << m_sequenceNumber;
+    journalStream << static_cast<quint8>(type);
+    m_journal.write(payload);
+    m_journal.flush();
+    m_journalRecords++;
+
+    if (journalNeedsCompaction())
+    {
+        compact();
+    }
+}
+
+
+bool NOTAM::NotamProvider::journalNeedsCompaction() const
+{
+    return (m_journalRecords > maxJournalRecords) || (m_journal.size() > maxJournalSize);
+}
+
+
+void NOTAM::NotamProvider::load()
+{
+    QList<NotamList> notamLists;
+
+    // Load snapshot
+    auto inputFile = QFile(m_stdFileName);
+    if (inputFile.open(QIODevice::ReadOnly))
+    {
+        QDataStream inputStream(&inputFile);
+        QString magicString;
+        inputStream >> magicString;
+        if (magicString == QStringLiteral(GIT_COMMIT))
         {
-            continue;
+            inputStream >> m_sequenceNumber;
+            inputStream >> m_readNotamNumbers;
+            inputStream >> notamLists;
         }
-        auto region = networkReply->property("area").value<QGeoCircle>();
-        if (!region.isValid())
+        if (inputStream.status() != QDataStream::Ok)
+        {
+            m_sequenceNumber = 0;
+            m_readNotamNumbers.clear();
+            notamLists.clear();
+        }
+    }
+
+    // Replay journal. Records that are already contained in the snapshot are
+    // skipped. Reading stops at the first incomplete record.
+    m_journal.setFileName(m_journalFileName);
+    if (!m_journal.open(QIODevice::ReadWrite))
+    {
+        m_notamStore.setNotamLists(notamLists);
+        return;
+    }
+    QDataStream journalStream(&m_journal);
+    QString magicString;
+    journalStream >> magicString;
+    if (magicString != QStringLiteral(GIT_COMMIT))
+    {
+        m_journal.close();
+        m_notamStore.setNotamLists(notamLists);
+        resetJournal();
+        return;
+    }
+
+    auto snapshotSequenceNumber = m_sequenceNumber;
+    auto validSize = m_journal.pos();
+    m_journalRecords = 0;
+    while (!journalStream.atEnd())
+    {
+        quint64 sequenceNumber = 0;
+        quint8 type = 0;
+        journalStream >> sequenceNumber;
+        journalStream >> type;
+
+        QList<NotamList> newNotamLists;
+        QSet<QString> cancelledNotamNumbers;
+        QString number;
+        bool read = false;
+        switch (static_cast<JournalRecord>(type))
+        {
+        case JournalRecord::NotamListsAdded:
+            journalStream >> newNotamLists;
+            journalStream >> cancelledNotamNumbers;
+            break;
+        case JournalRecord::ReadStateChanged:
+            journalStream >> number;
+            journalStream >> read;
+            break;
+        case JournalRecord::Cleared:
+            break;
+        default:
+            journalStream.setStatus(QDataStream::ReadCorruptData);
+        }
+        if (journalStream.status() != QDataStream::Ok)
+        {
+            break;
+        }
+        validSize = m_journal.pos();
+        m_journalRecords++;
+        if (sequenceNumber <= snapshotSequenceNumber)
         {
             continue;
         }
-        auto rangeInM = region.radius() - region.center().distanceTo(position);
-        result = qMax(result, Units::Distance::fromM(rangeInM));
+        m_sequenceNumber = sequenceNumber;
+
+        switch (static_cast<JournalRecord>(type))
+        {
+        case JournalRecord::NotamListsAdded:
+            notamLists = newNotamLists + notamLists;
+            m_cancelledNotamNumbers += cancelledNotamNumbers;
+            break;
+        case JournalRecord::ReadStateChanged:
+            m_readNotamNumbers.removeAll(number);
+            if (read)
+            {
+                m_readNotamNumbers.prepend(number);
+                if (m_readNotamNumbers.size() > 50)
+                {
+                    m_readNotamNumbers.remove(50);
+                }
+            }
+            break;
+        case JournalRecord::Cleared:
+            notamLists.clear();
+            break;
+        }
     }
+    m_notamStore.setNotamLists(notamLists);
 
-    return result;
+    // Remove incomplete records and position the journal for appending
+    m_journal.resize(validSize);
+    m_journal.seek(validSize);
 }
 
 
-void NOTAM::NotamProvider::startRequest(const QGeoCoordinate& coordinate)
+void NOTAM::NotamProvider::resetJournal()
 {
-    if (!coordinate.isValid())
+    m_journalRecords = 0;
+    m_journal.close();
+    m_journal.setFileName(m_journalFileName);
+    if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Truncate))
     {
         return;
     }
+    QDataStream journalStream(&m_journal);
+    journalStream << QStringLiteral(GIT_COMMIT);
+    m_journal.flush();
+}
+
+
+void NOTAM::NotamProvider::sendRequests()
+{
+    auto FAA_ID = globalSettings()->FAA_ID();
+    auto FAA_KEY = globalSettings()->FAA_KEY();
+
+    m_networkReplies.removeAll(nullptr);
+    while (!m_requestQueue.isEmpty() && (m_networkReplies.size() < maxRequestsInFlight))
+    {
+        auto region = m_requestQueue.takeFirst();
+        auto coordinate = region.center();
+
+        auto urlString = u"https://cplx.vm.uni-freiburg.de/storage/enrouteProxy/notam.php?"
+                         "locationLongitude=%1&"
+                         "locationLatitude=%2&"
+                         "locationRadius=%3&"
+                         "pageSize=1000"_qs
+                             .arg(coordinate.longitude())
+                             .arg(coordinate.latitude())
+                             .arg(1.2*requestRadius.toNM());
+        /*
+        auto urlString = u"https://external-api.faa.gov/notamapi/v1/notams?"
+                         "locationLongitude=%1&"
+                         "locationLatitude=%2&"
+                         "locationRadius=%3&"
+                         "pageSize=1000"_qs
+                .arg(coordinate.longitude())
+                .arg(coordinate.latitude())
+                .arg(1.2*requestRadius.toNM());
+        */
+        QNetworkRequest request( urlString );
+        request.setRawHeader("client_id", FAA_ID.toLatin1());
+        request.setRawHeader("client_secret", FAA_KEY.toLatin1());
+
+        auto* reply = GlobalObject::networkAccessManager()->get(request);
+        reply->setProperty("area", QVariant::fromValue(region) );
+
+        m_networkReplies.append(reply);
+        connect(reply, &QNetworkReply::finished, this, &NOTAM::NotamProvider::downloadFinished);
+        connect(reply, &QNetworkReply::errorOccurred, this, &NOTAM::NotamProvider::downloadFinished);
+    }
+}
+
+
+bool NOTAM::NotamProvider::startRequest(const QGeoCoordinate& coordinate)
+{
+    if (!coordinate.isValid())
+    {
+        return false;
+    }
     auto FAA_ID = globalSettings()->FAA_ID();
     auto FAA_KEY = globalSettings()->FAA_KEY();
     if (FAA_ID.isEmpty() || FAA_KEY.isEmpty())
     {
-        return;
+        return false;
+    }
+
+    // Coalesce with pending requests. The threshold agrees with the one used
+    // in updateData(), so that updateData() never asks for a point that is
+    // then silently dropped here.
+    if (range(coordinate, m_pendingRegions) >= marginRadius+Units::Distance::fromNM(1))
+    {
+        return false;
     }
 
-    auto urlString = u"https://cplx.vm.uni-freiburg.de/storage/enrouteProxy/notam.php?"
-                     "locationLongitude=%1&"
-                     "locationLatitude=%2&"
-                     "locationRadius=%3&"
-                     "pageSize=1000"_qs
-                         .arg(coordinate.longitude())
-                         .arg(coordinate.latitude())
-                         .arg(1.2*requestRadius.toNM());
-    /*
-    auto urlString = u"https://external-api.faa.gov/notamapi/v1/notams?"
-                     "locationLongitude=%1&"
-                     "locationLatitude=%2&"
-                     "locationRadius=%3&"
-                     "pageSize=1000"_qs
-            .arg(coordinate.longitude())
-            .arg(coordinate.latitude())
-            .arg(1.2*requestRadius.toNM());
-    */
-    QNetworkRequest request( urlString );
-    request.setRawHeader("client_id", FAA_ID.toLatin1());
-    request.setRawHeader("client_secret", FAA_KEY.toLatin1());
-
-    auto* reply = GlobalObject::networkAccessManager()->get(request);
-    reply->setProperty("area", QVariant::fromValue(QGeoCircle(coordinate, requestRadius.toM())) );
-
-    m_networkReplies.append(reply);
-    connect(reply, &QNetworkReply::finished, this, &NOTAM::NotamProvider::downloadFinished);
-    connect(reply, &QNetworkReply::errorOccurred, this, &NOTAM::NotamProvider::downloadFinished);
+    QGeoCircle const region(coordinate, requestRadius.toM());
+    m_pendingRegions.append(region);
+    m_requestQueue.append(region);
+    sendRequests();
+    return true;
 }
@@ -20,11 +20,14 @@
 
 #pragma once
 
+#include <QFile>
+#include <QFuture>
 #include <QNetworkReply>
 #include <QQmlEngine>
 
 #include "GlobalObject.h"
 #include "notam/NotamList.h"
+#include "notam/NotamStore.h"
 
 namespace NOTAM {
 
@@ -81,7 +84,7 @@ public:
      *
      *  @returns Property waypoints
      */
-    Q_REQUIRED_RESULT QList<GeoMaps::Waypoint> waypoints() const;
+    Q_REQUIRED_RESULT QList<GeoMaps::Waypoint> waypoints() const { return m_notamStore.waypoints(); }
 
 
 
@@ -138,30 +141,74 @@ private slots:
 
     // This slot is connected to signals QNetworkReply::finished and
     // QNetworkReply::errorOccurred of the QNetworkReply contained in the list
-    // in m_networkReply. This method reads the incoming data and adds it to the
-    // database
+    // in m_networkReply. This method reads the incoming data, parses it in a
+    // background thread and adds it to the database
     void downloadFinished();
 
-    // Save NOTAM data to file whose name is found in m_stdFileName. There are
-    // no error checks of any kind.
-    void save() const;
+    // Writes a snapshot of the NOTAM data to the file whose name is found in
+    // m_stdFileName. The file is written in a background thread. Once the
+    // snapshot is committed, the journal is truncated, unless records have
+    // been appended in the meantime. There are no error checks of any kind.
+    // This method is called only when journalNeedsCompaction() is true.
+    void compact();
 
     // Checks if NOTAM data is available for an area of marginRadius around the
     // current position and around the current flight route. If not, requests
-    // the data.
+    // the data. The coverage is computed once and then extended by the
+    // requested regions, so the whole route is planned in one pass.
     void updateData();
 
 private:
     Q_DISABLE_COPY_MOVE(NotamProvider)
 
-    // Compute the radius of the circle around the waypoint that is covered by
-    // existing or requested notam data. Returns Units::Distance::fromM(-1) if
-    // the waypoint is not covered by data.
-    Units::Distance range(const QGeoCoordinate& position);
+    // Adds a NotamList that has been downloaded and parsed to the database.
+    void addNotamList(const NOTAM::NotamList& notamList, const QSet<QString>& cancelledNotamNumbers);
+
+    // Regions covered by existing or requested notam data: regions of all
+    // NotamLists that are not outdated, and all regions in m_pendingRegions.
+    QList<QGeoCircle> coverage() const;
+
+    // Compute the radius of the circle around the position that is covered by
+    // the given regions. Returns Units::Distance::fromM(-1) if the position is
+    // not covered.
+    static Units::Distance range(const QGeoCoordinate& position, const QList<QGeoCircle>& regions);
+
+    // Sends queued requests, as long as fewer than maxRequestsInFlight
+    // requests are running.
+    void sendRequests();
 
     // Request Notam data from the FAA, for a circle of radius requestRadius
-    // around the coordinate.
-    void startRequest(const QGeoCoordinate& coordinate);
+    // around the coordinate. The request is queued and sent by
+    // sendRequests(), and its region is appended to m_pendingRegions.
+    // Nothing happens if the coordinate is invalid, if no FAA key is set or
+    // if the coordinate is already well within a pending region. Returns
+    // true if a request was issued.
+    bool startRequest(const QGeoCoordinate& coordinate);
+
+    // Types of records in the journal
+    enum class JournalRecord : quint8
+    {
+        NotamListsAdded,  // Payload: QList<NotamList>, QSet<QString> with cancelled Notam numbers
+        ReadStateChanged, // Payload: QString with Notam number, bool
+        Cleared           // No payload
+    };
+
+    // Appends a record to the journal and flushes the journal. The payload
+    // must have been serialized with a QDataStream of default version. If
+    // journalNeedsCompaction() is true afterwards, compact() is called.
+    void appendToJournal(JournalRecord type, const QByteArray& payload = {});
+
+    // True if the journal holds more than maxJournalRecords records or is
+    // larger than maxJournalSize
+    [[nodiscard]] bool journalNeedsCompaction() const;
+
+    // Loads the snapshot from m_stdFileName and replays the journal from
+    // m_journalFileName. Incomplete records at the end of the journal are
+    // removed. Afterwards, the journal is open for appending.
+    void load();
+
+    // Truncates the journal and opens it for appending
+    void resetJournal();
 
     // List with numbers of notams that have been marked as read
     QList<QString> m_readNotamNumbers;
@@ -169,11 +216,23 @@ private:
     // Set with numbers of notams that have been cancelled
     QSet<QString> m_cancelledNotamNumbers;
 
-    // List of pending network requests
+    // List of running network requests
     QList<QPointer<QNetworkReply>> m_networkReplies;
 
-    // List of NotamLists, sorted so that newest lists come first
-    QList<NotamList> m_notamLists;
+    // Regions for which Notam data has been requested, but not yet been added
+    // to the database. This includes queued requests, running requests and
+    // responses that are being parsed.
+    QList<QGeoCircle> m_pendingRegions;
+
+    // Incremented whenever the database is cleared. Responses to requests
+    // made before are discarded.
+    quint64 m_generation {0};
+
+    // Regions for which requests are queued, but have not been sent yet
+    QList<QGeoCircle> m_requestQueue;
+
+    // NotamLists, sorted so that newest lists come first, with spatial index
+    NotamStore m_notamStore;
 
     // Time of last update to data
     QDateTime m_lastUpdate;
@@ -181,12 +240,44 @@ private:
     // Filename for loading/saving NOTAM data
     QString m_stdFileName;
 
+    // Journal of changes since the last snapshot. Changes are appended as
+    // they happen, so that each change costs only its own bytes. The journal
+    // is replayed on startup and truncated whenever a snapshot is written.
+    QFile m_journal;
+    QString m_journalFileName;
+
+    // Sequence number of the last record written to the journal. The
+    // snapshot stores the sequence number of the last record that it
+    // contains, so that records are never applied twice.
+    quint64 m_sequenceNumber {0};
+
+    // Number of records in the journal
+    qsizetype m_journalRecords {0};
+
+    // Future of the background thread that writes the snapshot. The
+    // destructor waits for this future. It must not wait for the
+    // continuation that runs in the GUI thread, as that would deadlock.
+    QFuture<bool> m_compactionWriter;
+
+    // Flags indicating that a compaction is running, including its
+    // continuation, and that another compaction was requested meanwhile
+    bool m_compactionRunning {false};
+    bool m_compactionPending {false};
+
+    // Size and number of records of the journal beyond which compact() is
+    // called
+    static constexpr qint64 maxJournalSize = 4LL*1024*1024;
+    static constexpr qsizetype maxJournalRecords = 200;
+
     // The method updateDate() ensures that data is requested for marginRadius around
     // own position and current flight route.
     static constexpr Units::Distance marginRadius = Units::Distance::fromNM(5.0);
 
     // Requests for Notam data are requestRadius around given position
     static constexpr Units::Distance requestRadius = Units::Distance::fromNM(20.0);
+
+    // Maximal number of network requests running at the same time
+    static constexpr qsizetype maxRequestsInFlight = 4;
 };
 
 } // namespace NOTAM
@@ -0,0 +1,301 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QGeoRectangle>
+#include <QtMath>
+
+#include "notam/NotamStore.h"
+
+
+namespace {
+
+// Size of the cells of the spatial index, in degrees
+constexpr double cellSize = 1.0;
+
+// Circles that span more cells than this in latitude or longitude are not
+// entered into the grid
+constexpr int maxCellsPerDimension = 16;
+
+qint64 cellKey(int latIndex, int lonIndex)
+{
+    return (qint64(latIndex) << 32) | quint32(lonIndex);
+}
+
+} // namespace
+
+
+
+//
+// Setter Methods
+//
+
+void NOTAM::NotamStore::setNotamLists(const QList<NOTAM::NotamList>& notamLists)
+{
+    m_notamLists = notamLists;
+    rebuildIndex();
+}
+
+
+
+//
+// Methods
+//
+
+void NOTAM::NotamStore::clear()
+{
+    m_notamLists.clear();
+    rebuildIndex();
+}
+
+
+qsizetype NOTAM::NotamStore::listIndex(const QGeoCoordinate& coordinate, bool skipOutdated) const
+{
+    if (!coordinate.isValid())
+    {
+        return -1;
+    }
+
+    qsizetype result = -1;
+    auto check = [&](qsizetype index)
+    {
+        if ((result >= 0) && (index >= result))
+        {
+            return;
+        }
+        const auto& notamList = m_notamLists[index];
+        if (skipOutdated && notamList.isOutdated())
+        {
+            return;
+        }
+        if (!notamList.region().contains(coordinate))
+        {
+            return;
+        }
+        result = index;
+    };
+
+    foreach(auto index, m_listGrid.value(cell(coordinate)))
+    {
+        check(index);
+    }
+    foreach(auto index, m_largeLists)
+    {
+        check(index);
+    }
+    return result;
+}
+
+
+NOTAM::NotamList NOTAM::NotamStore::notams(const GeoMaps::Waypoint& waypoint, qsizetype listIndex) const
+{
+    if ((listIndex < 0) || (listIndex >= m_notamLists.size()))
+    {
+        return {};
+    }
+    const auto& notamList = m_notamLists[listIndex];
+    auto coordinate = waypoint.coordinate();
+
+    NotamList result;
+    result.m_retrieved = notamList.m_retrieved;
+    auto radius = qMax(0.0, notamList.m_region.radius() - notamList.m_region.center().distanceTo(coordinate));
+    result.m_region = QGeoCircle(coordinate, radius);
+
+    // Every Notam number appears at most once among the candidates, so no
+    // further deduplication is necessary
+    auto addCandidate = [&](const QString& number)
+    {
+        auto entry = m_notams.constFind(number);
+        if (entry == m_notams.constEnd())
+        {
+            return;
+        }
+        if (!entry->lists.contains(listIndex))
+        {
+            return;
+        }
+        const auto& notam = entry->notam;
+        if (!notam.isValid() || notam.isOutdated())
+        {
+            return;
+        }
+        if (!notam.region().contains(coordinate))
+        {
+            return;
+        }
+        result.m_notams.append(notam);
+    };
+
+    foreach(auto number, m_notamGrid.value(cell(coordinate)))
+    {
+        addCandidate(number);
+    }
+    foreach(auto number, m_largeNotams)
+    {
+        addCandidate(number);
+    }
+
+    result.sortByRelevance();
+    return result;
+}
+
+
+QList<GeoMaps::Waypoint> NOTAM::NotamStore::waypoints() const
+{
+    QList<GeoMaps::Waypoint> result;
+    QSet<QGeoCoordinate> coordinatesSeen;
+
+    foreach(auto number, m_numbers)
+    {
+        const auto& entry = m_notams[number];
+        const auto& notam = entry.notam;
+        if (!notam.isValid() || notam.isOutdated())
+        {
+            continue;
+        }
+        auto coordinate = notam.coordinate();
+        if (!coordinate.isValid())
+        {
+            continue;
+        }
+
+        // If we already have a waypoint for that coordinate, then don't add another one.
+        if (coordinatesSeen.contains(coordinate))
+        {
+            continue;
+        }
+
+        // Only consider the Notam if it is contained in the newest notamList
+        // that covers the coordinate.
+        auto index = listIndex(coordinate, false);
+        if ((index < 0) || !entry.lists.contains(index))
+        {
+            continue;
+        }
+
+        coordinatesSeen += coordinate;
+        result.append(coordinate);
+    }
+
+    return result;
+}
+
+
+
+//
+// Private Methods
+//
+
+void NOTAM::NotamStore::rebuildIndex()
+{
+    m_notams.clear();
+    m_numbers.clear();
+    m_notamGrid.clear();
+    m_largeNotams.clear();
+    m_listGrid.clear();
+    m_largeLists.clear();
+
+    for(qsizetype index = 0; index < m_notamLists.size(); index++)
+    {
+        const auto& notamList = m_notamLists[index];
+
+        auto listCells = cells(notamList.region());
+        if (listCells.isEmpty() && notamList.region().isValid())
+        {
+            m_largeLists.append(index);
+        }
+        foreach(auto listCell, listCells)
+        {
+            m_listGrid[listCell].append(index);
+        }
+
+        foreach(auto notam, notamList.m_notams)
+        {
+            auto number = notam.number();
+            auto entry = m_notams.find(number);
+            if (entry != m_notams.end())
+            {
+                if (entry->lists.constLast() != index)
+                {
+                    entry->lists.append(index);
+                }
+                continue;
+            }
+
+            m_notams.insert(number, {notam, {index}});
+            m_numbers.append(number);
+
+            if (!notam.region().isValid())
+            {
+                continue;
+            }
+            auto notamCells = cells(notam.region());
+            if (notamCells.isEmpty())
+            {
+                m_largeNotams.append(number);
+            }
+            foreach(auto notamCell, notamCells)
+            {
+                m_notamGrid[notamCell].append(number);
+            }
+        }
+    }
+}
+
+
+QList<qint64> NOTAM::NotamStore::cells(const QGeoCircle& circle)
+{
+    if (!circle.isValid())
+    {
+        return {};
+    }
+    auto rect = circle.boundingGeoRectangle();
+    auto left = rect.topLeft().longitude();
+    auto right = rect.bottomRight().longitude();
+    if (left > right)
+    {
+        return {};
+    }
+
+    auto latMin = qFloor(rect.bottomRight().latitude()/cellSize);
+    auto latMax = qFloor(rect.topLeft().latitude()/cellSize);
+    auto lonMin = qFloor(left/cellSize);
+    auto lonMax = qFloor(right/cellSize);
+    if ((latMax-latMin >= maxCellsPerDimension) || (lonMax-lonMin >= maxCellsPerDimension))
+    {
+        return {};
+    }
+
+    QList<qint64> result;
+    result.reserve((latMax-latMin+1)*(lonMax-lonMin+1));
+    for(auto lat = latMin; lat <= latMax; lat++)
+    {
+        for(auto lon = lonMin; lon <= lonMax; lon++)
+        {
+            result.append(cellKey(lat, lon));
+        }
+    }
+    return result;
+}
+
+
+qint64 NOTAM::NotamStore::cell(const QGeoCoordinate& coordinate)
+{
+    return cellKey(qFloor(coordinate.latitude()/cellSize), qFloor(coordinate.longitude()/cellSize));
+}
@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QHash>
+
+#include "geomaps/Waypoint.h"
+#include "notam/NotamList.h"
+
+namespace NOTAM {
+
+/*! \brief Indexed storage for NotamLists
+ *
+ *  This class holds a list of NotamLists, sorted so that newest lists come
+ *  first. In addition to the lists, the class maintains a table of all Notams,
+ *  keyed by Notam number, and a spatial index over the regions of the Notams
+ *  and of the NotamLists. The index is rebuilt whenever the lists change, so
+ *  that lookups by coordinate do not need to scan all Notams.
+ */
+
+class NotamStore {
+
+public:
+    /*! \brief Constructs an empty store */
+    NotamStore() = default;
+
+
+    //
+    // Getter Methods
+    //
+
+    /*! \brief List of NotamLists, sorted so that newest lists come first
+     *
+     *  @returns List of NotamLists
+     */
+    Q_REQUIRED_RESULT QList<NOTAM::NotamList> notamLists() const { return m_notamLists; }
+
+
+    //
+    // Setter Methods
+    //
+
+    /*! \brief Set NotamLists and rebuild the index
+     *
+     *  @param notamLists List of NotamLists, sorted so that newest lists come
+     *  first
+     */
+    void setNotamLists(const QList<NOTAM::NotamList>& notamLists);
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Remove all data */
+    void clear();
+
+    /*! \brief Find the newest NotamList whose region contains a coordinate
+     *
+     *  @param coordinate Coordinate
+     *
+     *  @param skipOutdated If true, then outdated NotamLists are disregarded
+     *
+     *  @returns Index of the newest NotamList in notamLists() whose region
+     *  contains the coordinate, or -1 if there is no such list
+     */
+    Q_REQUIRED_RESULT qsizetype listIndex(const QGeoCoordinate& coordinate, bool skipOutdated=true) const;
+
+    /*! \brief Notams relevant to a given waypoint
+     *
+     *  This method is equivalent to notamLists()[listIndex].restricted(waypoint),
+     *  but uses the spatial index.
+     *
+     *  @param waypoint Waypoint
+     *
+     *  @param listIndex Index of a NotamList in notamLists() whose region
+     *  contains the waypoint
+     *
+     *  @returns NotamList with all notams relevant for the given waypoint,
+     *  without expired and duplicated.
+     */
+    Q_REQUIRED_RESULT NOTAM::NotamList notams(const GeoMaps::Waypoint& waypoint, qsizetype listIndex) const;
+
+    /*! \brief Waypoints with Notam items, for presentation in a map
+     *
+     *  A waypoint is generated for the coordinate of every valid and current
+     *  Notam that is contained in the newest NotamList covering that
+     *  coordinate. Every coordinate appears at most once.
+     *
+     *  @returns List of waypoints
+     */
+    Q_REQUIRED_RESULT QList<GeoMaps::Waypoint> waypoints() const;
+
+private:
+    // Rebuilds m_notams and the spatial index from m_notamLists
+    void rebuildIndex();
+
+    // Cells of the spatial index that intersect the circle. Returns an empty
+    // list if the circle is too large or crosses the date line, in which case
+    // the circle is not entered into the grid.
+    static QList<qint64> cells(const QGeoCircle& circle);
+
+    // Cell of the spatial index that contains the coordinate
+    static qint64 cell(const QGeoCoordinate& coordinate);
+
+    // Entry of the Notam table
+    struct Entry
+    {
+        // Notam, taken from the newest list that contains it
+        Notam notam;
+
+        // Indices of the NotamLists that contain a Notam with that number
+        QList<qsizetype> lists;
+    };
+
+    // List of NotamLists, sorted so that newest lists come first
+    QList<NotamList> m_notamLists;
+
+    // Table of Notams, keyed by number
+    QHash<QString, Entry> m_notams;
+
+    // Notam numbers, in the order in which they appear in m_notamLists
+    QList<QString> m_numbers;
+
+    // Spatial index: Notam numbers whose region intersects a given cell, and
+    // numbers of Notams whose region is too large for the grid
+    QHash<qint64, QList<QString>> m_notamGrid;
+    QList<QString> m_largeNotams;
+
+    // Spatial index: indices of NotamLists whose region intersects a given
+    // cell, and indices of lists whose region is too large for the grid
+    QHash<qint64, QList<qsizetype>> m_listGrid;
+    QList<qsizetype> m_largeLists;
+};
+
+} // namespace NOTAM
@@ -33,6 +33,7 @@
 #include "geomaps/OpenAir.h"
 #include "geomaps/VAC.h"
 #include "platform/FileExchange_Abstract.h"
+#include "positioning/Geoid.h"
 #include "traffic/TrafficDataProvider.h"
 #include "traffic/TrafficDataSource_File.h"
 
@@ -48,6 +49,17 @@ Platform::FileExchange_Abstract::FileExchange_Abstract(QObject *parent)
 // Methods
 //
 
+QString Platform::FileExchange_Abstract::shareFile(const QString& fileName, const QString& mimeType, const QString& fileNameTemplate)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return tr("Unable to open file <strong>%1</strong>.").arg(fileName);
+    }
+    return shareContent(file.readAll(), mimeType, fileNameTemplate);
+}
+
+
 void Platform::FileExchange_Abstract::processFileOpenRequest(const QByteArray& path)
 {
     processFileOpenRequest(QString::fromUtf8(path).simplified());
@@ -81,6 +93,14 @@ void Platform::FileExchange_Abstract::processFileOpenRequest(const QString& path
      * Check for various possible file formats/contents
      */
 
+    // Geoid model. This check reads the file header only, and comes first
+    // because geoid models are large PGM images.
+    if (Positioning::Geoid::isValidModel(myPath))
+    {
+        emit openFileRequest(path, {}, Geoid);
+        return;
+    }
+
     // Flight Route in GPX format
     if ((mimeType.inherits(QStringLiteral("application/xml"))) || (mimeType.name() == u"application/x-gpx+xml"))
     {
@@ -180,6 +200,15 @@ void Platform::FileExchange_Abstract::processFileOpenRequest(const QString& path
         FileFormats::ZipFile const zipFile(myPath);
         if (zipFile.isValid())
         {
+            // Zip archives with geoid models, as published by GeographicLib
+            foreach(const auto& fileName, zipFile.fileNames())
+            {
+                if (fileName.startsWith(u"geoids/"_qs) && fileName.endsWith(u".pgm"_qs))
+                {
+                    emit openFileRequest(path, {}, Geoid);
+                    return;
+                }
+            }
             emit openFileRequest(path, {}, ZipFile);
             return;
         }
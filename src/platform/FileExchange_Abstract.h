@@ -57,7 +57,8 @@ public:
         VAC, /*< Visual Approach Chart */
         Image, /*< Image without georeferencing information */
         TripKit, /*< Trip Kit */
-        ZipFile /*< Zip File */
+        ZipFile, /*< Zip File */
+        Geoid /*< Geoid model, or zip archive containing a geoid model */
       };
     Q_ENUM(FileFunction)
 
@@ -113,6 +114,25 @@ public:
      */
     Q_INVOKABLE virtual QString shareContent(const QByteArray& content, const QString& mimeType, const QString& fileNameTemplate) = 0;
 
+    /*! \brief Share file
+     *
+     * Like shareContent(), but takes the content from a local file. This
+     * method is meant for large files. Where the platform allows, the file
+     * is copied and never read into memory as a whole. The default
+     * implementation reads the file and calls shareContent().
+     *
+     * @param fileName Name of a local file. The file may be deleted as soon
+     * as the method returns.
+     *
+     * @param mimeType the mimeType of the content. If the mime database
+     * does not know a suffix for this type, the suffix of fileName is used.
+     *
+     * @param fileNameTemplate see shareContent()
+     *
+     * @returns see shareContent()
+     */
+    Q_INVOKABLE virtual QString shareFile(const QString& fileName, const QString& mimeType, const QString& fileNameTemplate);
+
     /*! \brief View content
      *
      * This method is supposed open the content in an appropriate app.  Example:
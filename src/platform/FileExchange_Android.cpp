@@ -21,6 +21,7 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QHash>
 #include <QJniEnvironment>
 #include <QJniObject>
@@ -116,6 +117,33 @@ auto Platform::FileExchange::shareContent(const QByteArray& content, const QStri
 }
 
 
+auto Platform::FileExchange::shareFile(const QString& fileName, const QString& mimeType, const QString& fileNameTemplate) -> QString
+{
+    QMimeDatabase const db;
+    QMimeType const mime = db.mimeTypeForName(mimeType);
+    auto suffix = mime.preferredSuffix();
+    if (suffix.isEmpty())
+    {
+        suffix = QFileInfo(fileName).suffix();
+    }
+
+    // Other apps can read files only from the exchange directory
+    QString const fname = fileNameTemplate+"-"+QDateTime::currentDateTimeUtc().toString(QStringLiteral("yyyy-MM-dd_hh.mm.ss"))+"."+suffix;
+    auto tmpPath = fileExchangeDirectoryName + fname;
+    QFile::remove(tmpPath);
+    if (!QFile::copy(fileName, tmpPath))
+    {
+        return tr("Unable to write to file <strong>%1</strong>.").arg(tmpPath);
+    }
+    bool const success = outgoingIntent(QStringLiteral("sendFile"), tmpPath, mimeType);
+    if (success)
+    {
+        return {};
+    }
+    return tr("No suitable file sharing app could be found.");
+}
+
+
 auto Platform::FileExchange::viewContent(const QByteArray& content, const QString& mimeType, const QString& fileNameTemplate) -> QString
 {
     Q_UNUSED(content)
@@ -62,6 +62,18 @@ public:
      */
     QString shareContent(const QByteArray& content, const QString& mimeType, const QString& fileNameTemplate) override;
 
+    /*! \brief Implements virtual method from FileExchange_Abstract
+     *
+     *  @param fileName see documentation for FileExchange_Abstract
+     *
+     *  @param mimeType see documentation for FileExchange_Abstract
+     *
+     *  @param fileNameTemplate see documentation for FileExchange_Abstract
+     *
+     *  @returns see documentation for FileExchange_Abstract
+     */
+    QString shareFile(const QString& fileName, const QString& mimeType, const QString& fileNameTemplate) override;
+
     /*! \brief Implements pure virtual method from FileExchange_Abstract
      *
      *  @param content see documentation for FileExchange_Abstract
@@ -21,6 +21,7 @@
 #include <QDesktopServices>
 #include <QDir>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMimeDatabase>
 #include <QTemporaryFile>
 
@@ -74,6 +75,30 @@ auto Platform::FileExchange::shareContent(const QByteArray& content, const QStri
 }
 
 
+auto Platform::FileExchange::shareFile(const QString& fileName, const QString& mimeType, const QString& fileNameTemplate) -> QString
+{
+    QMimeDatabase const mimeDataBase;
+    QMimeType const mime = mimeDataBase.mimeTypeForName(mimeType);
+    auto suffix = mime.preferredSuffix();
+    if (suffix.isEmpty())
+    {
+        suffix = QFileInfo(fileName).suffix();
+    }
+
+    auto fileNameX = QFileDialog::getSaveFileName(nullptr, tr("Export file"), QDir::homePath()+"/"+fileNameTemplate+"."+suffix, tr("%1 (*.%2);;All files (*)").arg(mime.comment(), suffix));
+    if (fileNameX.isEmpty())
+    {
+        return QStringLiteral("abort");
+    }
+    QFile::remove(fileNameX);
+    if (!QFile::copy(fileName, fileNameX))
+    {
+        return tr("Unable to write to file <strong>%1</strong>.").arg(fileNameX);
+    }
+    return {};
+}
+
+
 auto Platform::FileExchange::viewContent(const QByteArray& content, const QString& /*mimeType*/, const QString& fileNameTemplate) -> QString
 {
     QTemporaryFile tmpFile(fileNameTemplate.arg(QStringLiteral("XXXXXX")));
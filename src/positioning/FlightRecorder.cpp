@@ -0,0 +1,537 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTimeZone>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "GlobalSettings.h"
+#include "platform/FileExchange_Abstract.h"
+#include "positioning/FlightRecorder.h"
+#include "positioning/Geoid.h"
+#include "positioning/PositionProvider.h"
+
+
+namespace {
+
+// Appends a signed integer in zig-zag varint encoding
+void appendVarint(QByteArray& data, qint64 value)
+{
+    auto zigZag = (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+    while (zigZag >= 0x80)
+    {
+        data.append(static_cast<char>((zigZag & 0x7F) | 0x80));
+        zigZag >>= 7;
+    }
+    data.append(static_cast<char>(zigZag));
+}
+
+// Reads a signed integer in zig-zag varint encoding. Sets ok to false if the
+// data ends prematurely.
+qint64 readVarint(const QByteArray& data, qsizetype& position, bool& ok)
+{
+    quint64 zigZag = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        if (position >= data.size())
+        {
+            ok = false;
+            return 0;
+        }
+        auto byte = static_cast<quint8>(data[position++]);
+        zigZag |= static_cast<quint64>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return static_cast<qint64>(zigZag >> 1) ^ -static_cast<qint64>(zigZag & 1);
+        }
+    }
+    ok = false;
+    return 0;
+}
+
+} // namespace
+
+
+Positioning::FlightRecorder::FlightRecorder(QObject* parent)
+    : GlobalObject(parent)
+{
+    m_ring.resize(ringCapacity);
+    m_writerPool.setMaxThreadCount(1);
+
+    m_flushTimer.setInterval(flushInterval);
+    connect(&m_flushTimer, &QTimer::timeout, this, &Positioning::FlightRecorder::flush);
+    m_flushTimer.start();
+}
+
+
+void Positioning::FlightRecorder::deferredInitialization()
+{
+    QDir().mkpath(directory());
+    removeOldRecordings();
+    m_fileName = newFileName();
+
+    connect(GlobalObject::positionProvider(), &Positioning::PositionProvider::positionInfoChanged, this, &Positioning::FlightRecorder::onPositionInfoChanged);
+    connect(GlobalObject::globalSettings(), &GlobalSettings::recordFlightsChanged, this, &Positioning::FlightRecorder::onRecordFlightsChanged);
+    onRecordFlightsChanged();
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Positioning::FlightRecorder::flush);
+    emit recordingsChanged();
+}
+
+
+Positioning::FlightRecorder::~FlightRecorder()
+{
+    flush();
+    m_writerPool.waitForDone();
+}
+
+
+
+//
+// Methods
+//
+
+void Positioning::FlightRecorder::clear()
+{
+    m_ringStart = 0;
+    m_ringSize = 0;
+    m_writerPool.waitForDone();
+    QDir const dir(directory());
+    foreach(const auto& recording, dir.entryInfoList({u"*.track"_qs}, QDir::Files))
+    {
+        QFile::remove(recording.absoluteFilePath());
+    }
+    m_fileName = newFileName();
+    m_numberOfFixes = 0;
+    emit numberOfFixesChanged();
+    emit recordingsChanged();
+}
+
+
+QStringList Positioning::FlightRecorder::recordings() const
+{
+    // File names start with the time in UTC, so that sorting by name sorts
+    // by time
+    QStringList result;
+    QDir const dir(directory());
+    foreach(const auto& recording, dir.entryInfoList({u"*.track"_qs}, QDir::Files, QDir::Name|QDir::Reversed))
+    {
+        result += recording.completeBaseName();
+    }
+
+    // The current recording is written to disk in blocks. It might hold
+    // data before the file exists.
+    auto current = QFileInfo(m_fileName).completeBaseName();
+    if ((m_numberOfFixes > 0) && !result.contains(current))
+    {
+        result.prepend(current);
+    }
+    return result;
+}
+
+
+QString Positioning::FlightRecorder::description(const QString& recording)
+{
+    auto time = QDateTime::fromString(recording, u"yyyyMMdd-HHmmss"_qs);
+    if (!time.isValid())
+    {
+        return recording;
+    }
+    time.setTimeZone(QTimeZone::UTC);
+    return QLocale().toString(time.toLocalTime(), QLocale::ShortFormat);
+}
+
+
+QString Positioning::FlightRecorder::exportRecording(const QString& recording, Positioning::FlightRecorder::Format format, const QString& fileName)
+{
+    if (!recordings().contains(recording))
+    {
+        return tr("The flight recording '%1' does not exist.").arg(recording);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return tr("Unable to open the file '%1' for writing.").arg(fileName);
+    }
+    auto error = (format == IGC) ? writeIGC(recording, file) : writeGPX(recording, file);
+    if (!error.isEmpty())
+    {
+        file.cancelWriting();
+        return error;
+    }
+    if (!file.commit())
+    {
+        return tr("Unable to write to the file '%1'.").arg(fileName);
+    }
+    return {};
+}
+
+
+QString Positioning::FlightRecorder::share(const QString& recording, Positioning::FlightRecorder::Format format)
+{
+    // The recording is exported into a temporary file, which FileExchange
+    // copies. Neither of them holds the file content in memory.
+    QTemporaryDir const tmpDir;
+    if (!tmpDir.isValid())
+    {
+        return tr("Unable to create a temporary directory.");
+    }
+    auto tmpFileName = tmpDir.filePath((format == IGC) ? u"recording.igc"_qs : u"recording.gpx"_qs);
+    auto error = exportRecording(recording, format, tmpFileName);
+    if (!error.isEmpty())
+    {
+        return error;
+    }
+    auto mimeType = (format == IGC) ? u"application/vnd.fai.igc"_qs : u"application/gpx+xml"_qs;
+    return GlobalObject::fileExchange()->shareFile(tmpFileName, mimeType, tr("Flight Recording %1").arg(recording));
+}
+
+
+QString Positioning::FlightRecorder::writeGPX(const QString& recording, QIODevice& file)
+{
+    auto now = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    auto name = description(recording);
+    file.write("<?xml version='1.0' encoding='UTF-8'?>\n"
+               "<gpx version='1.1' creator='Enroute - https://akaflieg-freiburg.github.io/enroute'\n"
+               "     xmlns='http://www.topografix.com/GPX/1/1'\n"
+               "     xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'>\n"
+               "  <metadata>\n");
+    file.write(u"    <name>Enroute %1</name>\n    <time>%2</time>\n"_qs.arg(name, now).toUtf8());
+    file.write("  </metadata>\n"
+               "  <trk>\n");
+    file.write(u"    <name>Enroute %1</name>\n"_qs.arg(name).toUtf8());
+    file.write("    <trkseg>\n");
+
+    auto error = forEachBlock(recording, [&file](const QList<Fix>& fixes) {
+        foreach(const auto& fix, fixes)
+        {
+            QByteArray line = "      <trkpt lat='" + QByteArray::number(static_cast<double>(fix.latitudeInE7)/1e7, 'f', 7)
+                              + "' lon='" + QByteArray::number(static_cast<double>(fix.longitudeInE7)/1e7, 'f', 7) + "'>\n";
+            if (fix.altitudeInDM != noValue)
+            {
+                line += "        <ele>" + QByteArray::number(static_cast<double>(fix.altitudeInDM)/10.0, 'f', 1) + "</ele>\n";
+            }
+            line += "        <time>" + QDateTime::fromMSecsSinceEpoch(fix.timeInMS, Qt::UTC).toString(Qt::ISODateWithMs).toUtf8() + "</time>\n";
+            line += "      </trkpt>\n";
+            file.write(line);
+        }
+    });
+    if (!error.isEmpty())
+    {
+        return error;
+    }
+
+    file.write("    </trkseg>\n"
+               "  </trk>\n"
+               "</gpx>\n");
+    return {};
+}
+
+
+QString Positioning::FlightRecorder::writeIGC(const QString& recording, QIODevice& file)
+{
+    // IGC coordinates are degrees and thousandths of minutes
+    auto coordinateString = [](qint64 valueInE7, int degreeDigits, char positive, char negative)
+    {
+        auto thousandthsOfMinutes = qRound64(static_cast<double>(qAbs(valueInE7))*60000.0/1e7);
+        return u"%1%2%3"_qs.arg(thousandthsOfMinutes/60000, degreeDigits, 10, QChar(u'0'))
+            .arg(thousandthsOfMinutes%60000, 5, 10, QChar(u'0'))
+            .arg(QChar::fromLatin1(valueInE7 < 0 ? negative : positive));
+    };
+    auto altitudeString = [](qint64 altitudeInDM)
+    {
+        auto altitudeInM = (altitudeInDM == noValue) ? 0 : qRound(static_cast<double>(altitudeInDM)/10.0);
+        return u"%1"_qs.arg(qBound(-9999, altitudeInM, 99999), 5, 10, QChar(u'0'));
+    };
+
+    // The GNSS altitude in IGC files is the altitude above the WGS84
+    // ellipsoid, if the geoidal separation is known. Separations are computed
+    // for a whole block at once.
+    bool headerWritten = false;
+    bool ellipsoidal = false;
+    QList<QGeoCoordinate> coordinates;
+    auto error = forEachBlock(recording, [&](const QList<Fix>& fixes) {
+        coordinates.clear();
+        foreach(const auto& fix, fixes)
+        {
+            coordinates.append(QGeoCoordinate(static_cast<double>(fix.latitudeInE7)/1e7, static_cast<double>(fix.longitudeInE7)/1e7));
+        }
+        auto separations = Positioning::Geoid::separation(std::span(coordinates.constData(), coordinates.size()));
+
+        for(qsizetype i=0; i<fixes.size(); i++)
+        {
+            const auto& fix = fixes[i];
+            auto time = QDateTime::fromMSecsSinceEpoch(fix.timeInMS, Qt::UTC);
+            if (!headerWritten)
+            {
+                ellipsoidal = separations[i].isFinite();
+                file.write("AXXXENR Enroute Flight Navigation\r\n");
+                file.write(u"HFDTEDATE:%1\r\n"_qs.arg(time.toString(u"ddMMyy"_qs)).toLatin1());
+                file.write("HFFTYFRTYPE:Enroute Flight Navigation\r\n");
+                file.write("HFGPSRECEIVER:Device position source\r\n");
+                file.write(ellipsoidal ? "HFALGALTGPS:ELL\r\n" : "HFALGALTGPS:GEO\r\n");
+                file.write("HFALPALTPRESSURE:ISA\r\n");
+                headerWritten = true;
+            }
+            auto gnssAltitudeInDM = fix.altitudeInDM;
+            if (ellipsoidal && (gnssAltitudeInDM != noValue) && separations[i].isFinite())
+            {
+                gnssAltitudeInDM += qRound64(separations[i].toM()*10.0);
+            }
+            auto line = u"B%1%2%3%4%5%6\r\n"_qs
+                            .arg(time.toString(u"HHmmss"_qs),
+                                 coordinateString(fix.latitudeInE7, 2, 'N', 'S'),
+                                 coordinateString(fix.longitudeInE7, 3, 'E', 'W'),
+                                 (fix.altitudeInDM == noValue) ? u"V"_qs : u"A"_qs,
+                                 altitudeString(fix.pressureAltitudeInDM),
+                                 altitudeString(gnssAltitudeInDM));
+            file.write(line.toLatin1());
+        }
+    });
+    if (!error.isEmpty())
+    {
+        return error;
+    }
+    if (!headerWritten)
+    {
+        return tr("The flight recording '%1' holds no data.").arg(recording);
+    }
+    return {};
+}
+
+
+//
+// Private Methods
+//
+
+void Positioning::FlightRecorder::onPositionInfoChanged()
+{
+    if (!GlobalObject::globalSettings()->recordFlights())
+    {
+        return;
+    }
+
+    auto* positionProvider = GlobalObject::positionProvider();
+    auto info = positionProvider->positionInfo();
+    if (!info.isValid())
+    {
+        return;
+    }
+
+    auto toInteger = [](double value, double factor)
+    {
+        return qIsFinite(value) ? qRound64(value*factor) : noValue;
+    };
+    Fix fix {};
+    fix.timeInMS = info.timestamp().toMSecsSinceEpoch();
+    fix.latitudeInE7 = toInteger(info.coordinate().latitude(), 1e7);
+    fix.longitudeInE7 = toInteger(info.coordinate().longitude(), 1e7);
+    fix.altitudeInDM = toInteger(info.trueAltitudeAMSL().toM(), 10.0);
+    fix.pressureAltitudeInDM = toInteger(positionProvider->pressureAltitude().toM(), 10.0);
+    fix.GSInCMPS = toInteger(info.groundSpeed().toMPS(), 100.0);
+    fix.TTInCDEG = toInteger(info.trueTrack().toDEG(), 100.0);
+
+    // The ring buffer holds at most one block more than necessary, and
+    // should never overflow. If it does, the oldest fix is dropped.
+    if (m_ringSize == ringCapacity)
+    {
+        m_ringStart = (m_ringStart+1) % ringCapacity;
+        m_ringSize--;
+    }
+    m_ring[(m_ringStart+m_ringSize) % ringCapacity] = fix;
+    m_ringSize++;
+    m_numberOfFixes++;
+    emit numberOfFixesChanged();
+    if (m_numberOfFixes == 1)
+    {
+        emit recordingsChanged();
+    }
+
+    if (m_ringSize >= blockSize)
+    {
+        flush();
+    }
+}
+
+
+void Positioning::FlightRecorder::flush()
+{
+    if (m_ringSize == 0)
+    {
+        return;
+    }
+
+    QList<Fix> fixes;
+    fixes.reserve(m_ringSize);
+    for(qsizetype i=0; i<m_ringSize; i++)
+    {
+        fixes.append(m_ring[(m_ringStart+i) % ringCapacity]);
+    }
+    m_ringStart = 0;
+    m_ringSize = 0;
+
+    // Encoding, compression and file access happen in the writer thread
+    auto fileName = m_fileName;
+    auto future = QtConcurrent::run(&m_writerPool, [fileName, fixes]() {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly|QIODevice::Append))
+        {
+            qWarning() << "FlightRecorder: Unable to open" << fileName;
+            return;
+        }
+        QDataStream stream(&file);
+        stream << static_cast<quint32>(fixes.size()) << encodeBlock(fixes);
+    });
+    Q_UNUSED(future)
+}
+
+
+void Positioning::FlightRecorder::onRecordFlightsChanged()
+{
+    if (!GlobalObject::globalSettings()->recordFlights())
+    {
+        clear();
+    }
+}
+
+
+QByteArray Positioning::FlightRecorder::encodeBlock(const QList<Fix>& fixes)
+{
+    // Every member is stored as the difference to the member of the previous
+    // fix. Consecutive fixes differ little, so that most differences fit
+    // into one or two bytes.
+    QByteArray data;
+    data.reserve(fixes.size()*10);
+    Fix previous {};
+    foreach(const auto& fix, fixes)
+    {
+        appendVarint(data, fix.timeInMS-previous.timeInMS);
+        appendVarint(data, fix.latitudeInE7-previous.latitudeInE7);
+        appendVarint(data, fix.longitudeInE7-previous.longitudeInE7);
+        appendVarint(data, fix.altitudeInDM-previous.altitudeInDM);
+        appendVarint(data, fix.pressureAltitudeInDM-previous.pressureAltitudeInDM);
+        appendVarint(data, fix.GSInCMPS-previous.GSInCMPS);
+        appendVarint(data, fix.TTInCDEG-previous.TTInCDEG);
+        previous = fix;
+    }
+    return qCompress(data);
+}
+
+
+QList<Positioning::FlightRecorder::Fix> Positioning::FlightRecorder::decodeBlock(const QByteArray& block)
+{
+    auto data = qUncompress(block);
+
+    QList<Fix> result;
+    Fix previous {};
+    qsizetype position = 0;
+    bool ok = true;
+    while (position < data.size())
+    {
+        Fix fix {};
+        fix.timeInMS = previous.timeInMS + readVarint(data, position, ok);
+        fix.latitudeInE7 = previous.latitudeInE7 + readVarint(data, position, ok);
+        fix.longitudeInE7 = previous.longitudeInE7 + readVarint(data, position, ok);
+        fix.altitudeInDM = previous.altitudeInDM + readVarint(data, position, ok);
+        fix.pressureAltitudeInDM = previous.pressureAltitudeInDM + readVarint(data, position, ok);
+        fix.GSInCMPS = previous.GSInCMPS + readVarint(data, position, ok);
+        fix.TTInCDEG = previous.TTInCDEG + readVarint(data, position, ok);
+        if (!ok)
+        {
+            return {};
+        }
+        result.append(fix);
+        previous = fix;
+    }
+    return result;
+}
+
+
+QString Positioning::FlightRecorder::forEachBlock(const QString& recording, const std::function<void(const QList<Fix>&)>& function)
+{
+    flush();
+    m_writerPool.waitForDone();
+
+    QFile file(fileName(recording));
+    if (!file.exists())
+    {
+        return {};
+    }
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return tr("Unable to open the flight recording '%1'.").arg(recording);
+    }
+
+    // Blocks are read one at a time. An incomplete block at the end of the
+    // file, as left behind by a crash, is silently ignored.
+    QDataStream stream(&file);
+    while (!stream.atEnd())
+    {
+        quint32 numFixes = 0;
+        QByteArray block;
+        stream >> numFixes >> block;
+        if (stream.status() != QDataStream::Ok)
+        {
+            break;
+        }
+        auto fixes = decodeBlock(block);
+        if (fixes.size() != static_cast<qsizetype>(numFixes))
+        {
+            return tr("The flight recording '%1' is damaged.").arg(recording);
+        }
+        function(fixes);
+    }
+    return {};
+}
+
+
+void Positioning::FlightRecorder::removeOldRecordings() const
+{
+    QDir const dir(directory());
+    auto recordings = dir.entryInfoList({u"*.track"_qs}, QDir::Files, QDir::Time);
+    for(auto i=maxRecordings-1; i<recordings.size(); i++)
+    {
+        QFile::remove(recordings[i].absoluteFilePath());
+    }
+}
+
+
+QString Positioning::FlightRecorder::fileName(const QString& recording)
+{
+    return directory()+u"/"_qs+recording+u".track"_qs;
+}
+
+
+QString Positioning::FlightRecorder::newFileName()
+{
+    return directory()+u"/"_qs+QDateTime::currentDateTimeUtc().toString(u"yyyyMMdd-HHmmss"_qs)+u".track"_qs;
+}
+
+
+QString Positioning::FlightRecorder::directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+u"/flightRecorder"_qs;
+}
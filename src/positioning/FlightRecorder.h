@@ -0,0 +1,275 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QIODevice>
+#include <QQmlEngine>
+#include <QThreadPool>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <limits>
+
+#include "GlobalObject.h"
+
+using namespace std::chrono_literals;
+
+
+namespace Positioning {
+
+/*! \brief Flight recorder
+ *
+ *  If the user has enabled the setting GlobalSettings::recordFlights, this
+ *  class records every position fix reported by the PositionProvider, at
+ *  full rate, whenever position information is available. Nothing is
+ *  recorded otherwise, and all recordings are deleted when the user disables
+ *  the setting. Recordings are stored on the device only. For every fix,
+ *  the recorder stores time, coordinate, true altitude, pressure altitude,
+ *  ground speed and true track.
+ *
+ *  Fixes are collected in a pre-allocated ring buffer. Whenever the buffer
+ *  holds a block of fixes, or at regular intervals, the block is handed to a
+ *  background thread, which delta-encodes and compresses the block and
+ *  appends it to the recording file. Data is never rewritten, so every fix
+ *  is written to disk exactly once, and memory consumption does not grow
+ *  with the length of the flight. A new recording file is started whenever
+ *  the program starts. The recordings of the last program starts are kept
+ *  and listed in the property recordings; older recordings are removed.
+ *
+ *  Every recording can be exported to IGC or GPX files, or shared with other
+ *  apps. Export reads the recording block by block and writes the output
+ *  file as a stream. IGC
+ *  files contain GNSS altitudes above the WGS84 ellipsoid, which are computed
+ *  from the true altitude with Geoid::separation(), one block at a time.
+ */
+
+class FlightRecorder : public GlobalObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_SINGLETON
+
+public:
+    /*! \brief Standard constructor
+     *
+     * @param parent The standard QObject parent pointer
+     */
+    explicit FlightRecorder(QObject* parent = nullptr);
+
+    // deferred initialization
+    void deferredInitialization() override;
+
+    // No default constructor, important for QML singleton
+    explicit FlightRecorder() = delete;
+
+    /*! \brief Standard destructor
+     *
+     * The destructor writes all pending fixes to disk.
+     */
+    ~FlightRecorder() override;
+
+    // factory function for QML singleton
+    static Positioning::FlightRecorder* create(QQmlEngine* /*unused*/, QJSEngine* /*unused*/)
+    {
+        return GlobalObject::flightRecorder();
+    }
+
+
+    /*! \brief File formats for export */
+    enum Format
+    {
+        GPX, /*< GPX track */
+        IGC  /*< IGC file */
+    };
+    Q_ENUM(Format)
+
+
+    //
+    // Properties
+    //
+
+    /*! \brief Number of fixes in the current recording */
+    Q_PROPERTY(qsizetype numberOfFixes READ numberOfFixes NOTIFY numberOfFixesChanged)
+
+    /*! \brief Names of all recordings, newest first
+     *
+     *  The names identify recordings in the methods description(),
+     *  exportRecording() and share(). The list includes the current recording
+     *  once it holds data.
+     */
+    Q_PROPERTY(QStringList recordings READ recordings NOTIFY recordingsChanged)
+
+
+    //
+    // Getter Methods
+    //
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property numberOfFixes
+     */
+    [[nodiscard]] qsizetype numberOfFixes() const { return m_numberOfFixes; }
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property recordings
+     */
+    [[nodiscard]] QStringList recordings() const;
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Delete all recordings and start a new one */
+    Q_INVOKABLE void clear();
+
+    /*! \brief Human-readable description of a recording
+     *
+     *  @param recording Name of a recording, as listed in the property
+     *  recordings
+     *
+     *  @returns Local date and time when the recording was started
+     */
+    [[nodiscard]] Q_INVOKABLE static QString description(const QString& recording);
+
+    /*! \brief Export a recording
+     *
+     *  The output file is written as a stream, without holding the recording
+     *  in memory.
+     *
+     *  @param recording Name of a recording, as listed in the property
+     *  recordings
+     *
+     *  @param format File format
+     *
+     *  @param fileName Name of the output file
+     *
+     *  @returns An empty string on success, or a human-readable, translated
+     *  error message
+     */
+    [[nodiscard]] Q_INVOKABLE QString exportRecording(const QString& recording, Positioning::FlightRecorder::Format format, const QString& fileName);
+
+    /*! \brief Share a recording
+     *
+     *  This method exports the recording into a temporary file and hands the
+     *  file to FileExchange::shareFile. On desktop systems, this shows a file
+     *  dialog to save the file.
+     *
+     *  @param recording Name of a recording, as listed in the property
+     *  recordings
+     *
+     *  @param format File format
+     *
+     *  @returns Empty string on success, the string "abort" on abort, and a
+     *  human-readable, translated error message otherwise
+     */
+    [[nodiscard]] Q_INVOKABLE QString share(const QString& recording, Positioning::FlightRecorder::Format format);
+
+signals:
+    /*! \brief Notifier signal */
+    void numberOfFixesChanged();
+
+    /*! \brief Notifier signal */
+    void recordingsChanged();
+
+private slots:
+    // Appends the current position info of the PositionProvider to the ring
+    // buffer, and flushes a block if the ring buffer holds enough fixes
+    void onPositionInfoChanged();
+
+    // Hands all fixes in the ring buffer to the writer thread
+    void flush();
+
+    // Deletes all recordings if the user has disabled the flight recorder
+    void onRecordFlightsChanged();
+
+private:
+    Q_DISABLE_COPY_MOVE(FlightRecorder)
+
+    // Fix, in integer units. Members that are not known hold noValue.
+    struct Fix
+    {
+        qint64 timeInMS;            // Milliseconds since epoch, UTC
+        qint64 latitudeInE7;        // Degrees * 10^7
+        qint64 longitudeInE7;       // Degrees * 10^7
+        qint64 altitudeInDM;        // True altitude AMSL in decimeters
+        qint64 pressureAltitudeInDM;// Pressure altitude in decimeters
+        qint64 GSInCMPS;            // Ground speed in centimeters per second
+        qint64 TTInCDEG;            // True track in centidegrees
+    };
+
+    // Delta-encodes and compresses a block of fixes
+    [[nodiscard]] static QByteArray encodeBlock(const QList<Fix>& fixes);
+
+    // Decodes a block written by encodeBlock. Returns an empty list on error.
+    [[nodiscard]] static QList<Fix> decodeBlock(const QByteArray& block);
+
+    // Writes all pending fixes to disk, waits for the writer thread to finish
+    // and then calls function for every block of fixes of the recording.
+    // Returns an empty string on success, or a human-readable, translated
+    // error message.
+    [[nodiscard]] QString forEachBlock(const QString& recording, const std::function<void(const QList<Fix>&)>& function);
+
+    // Write the recording to file. Return an empty string on success, or a
+    // human-readable, translated error message.
+    [[nodiscard]] QString writeGPX(const QString& recording, QIODevice& file);
+    [[nodiscard]] QString writeIGC(const QString& recording, QIODevice& file);
+
+    // Name of the file that holds the recording
+    [[nodiscard]] static QString fileName(const QString& recording);
+
+    // Removes all recordings except the newest ones
+    void removeOldRecordings() const;
+
+    // Name for a new recording file
+    [[nodiscard]] static QString newFileName();
+
+    // Directory where recordings are stored
+    [[nodiscard]] static QString directory();
+
+    // Number of fixes that are handed to the writer thread at once
+    static constexpr qsizetype blockSize = 256;
+    // Capacity of the ring buffer
+    static constexpr qsizetype ringCapacity = 2*blockSize;
+    // Pending fixes are written at least this often
+    static constexpr auto flushInterval = 1min;
+    // Number of recordings that are kept
+    static constexpr qsizetype maxRecordings = 20;
+    // Value of Fix members that are not known
+    static constexpr qint64 noValue = std::numeric_limits<qint32>::min();
+
+    // Ring buffer of fixes that have not yet been handed to the writer
+    QList<Fix> m_ring;
+    qsizetype m_ringStart {0};
+    qsizetype m_ringSize {0};
+
+    // Number of fixes in the current recording, and its file name
+    qsizetype m_numberOfFixes {0};
+    QString m_fileName;
+
+    // Writer thread. The pool holds one thread only, so blocks are written
+    // in order.
+    QThreadPool m_writerPool;
+    QTimer m_flushTimer;
+};
+
+} // namespace Positioning
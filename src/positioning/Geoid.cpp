@@ -18,8 +18,14 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
 #include <QtEndian>
 #include <QtMath>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "positioning/Geoid.h"
 
@@ -27,6 +33,203 @@
 
 QVector<qint16> Positioning::Geoid::egm {};
 
+namespace {
+// Guards the one-time initialization of egm. Once the data is read, it is
+// never modified again, so that separation() can read it without locking.
+std::once_flag egmFlag;
+
+
+// Header of a GeographicLib geoid file in PGM format. See
+// https://geographiclib.sourceforge.io/C++/doc/geoid.html#geoidformat
+struct PGMHeader
+{
+    qint64 dataOffset {0};  // Offset of the first sample in the file
+    int width {0};          // Number of samples per row, from 0°E eastwards
+    int height {0};         // Number of rows, from 90°N southwards
+    double offset {0.0};    // Separation in meters is offset + scale*sample
+    double scale {0.0};
+};
+
+// Reads and checks the header. The samples are big endian 16 bit integers,
+// on a grid that covers the whole earth.
+bool readPGMHeader(QFile& file, PGMHeader& header)
+{
+    if (file.readLine(16).trimmed() != "P5")
+    {
+        return false;
+    }
+
+    bool haveOffset = false;
+    bool haveScale = false;
+    QByteArray line;
+    while (true)
+    {
+        line = file.readLine(256).simplified();
+        if (!line.startsWith('#'))
+        {
+            break;
+        }
+        auto words = line.mid(1).simplified().split(' ');
+        if (words.size() != 2)
+        {
+            continue;
+        }
+        if (words[0] == "Offset")
+        {
+            header.offset = words[1].toDouble(&haveOffset);
+        }
+        if (words[0] == "Scale")
+        {
+            header.scale = words[1].toDouble(&haveScale);
+        }
+    }
+
+    auto size = line.split(' ');
+    bool widthOK = false;
+    bool heightOK = false;
+    if (size.size() == 2)
+    {
+        header.width = size[0].toInt(&widthOK);
+        header.height = size[1].toInt(&heightOK);
+    }
+    if (file.readLine(16).trimmed() != "65535")
+    {
+        return false;
+    }
+    header.dataOffset = file.pos();
+
+    return haveOffset && haveScale && widthOK && heightOK
+           && (header.width >= 360) && (header.width % 360 == 0)
+           && (header.height == header.width/2 + 1)
+           && (file.size() == header.dataOffset + 2*static_cast<qint64>(header.width)*header.height);
+}
+
+} // namespace
+
+
+// High-resolution geoid model, read from a GeographicLib geoid file. The
+// file is memory-mapped in bands of rows. A band is mapped when it is first
+// needed, and never unmapped afterwards, so that samples can be read without
+// locking.
+class Positioning::Geoid::Model
+{
+public:
+    explicit Model(const QString& fileName)
+        : m_file(fileName)
+    {
+        if (!m_file.open(QIODevice::ReadOnly) || !readPGMHeader(m_file, m_header))
+        {
+            m_header = {};
+            return;
+        }
+        m_samplesPerDegree = m_header.width/360;
+        m_numBands = (m_header.height + m_samplesPerDegree - 1)/m_samplesPerDegree;
+        m_bands = std::make_unique<std::atomic<const uchar*>[]>(m_numBands);
+    }
+
+    [[nodiscard]] bool isValid() const { return m_numBands > 0; }
+
+    // Separation in meters, or NaN if the data cannot be mapped. Latitude in
+    // [-90, 90], longitude in [0, 360[.
+    [[nodiscard]] double separation(double latitude, double longitude)
+    {
+        auto rowReal = (90 - latitude) * m_samplesPerDegree;
+        auto colReal = longitude * m_samplesPerDegree;
+
+        int north = qBound(0, qFloor(rowReal), m_header.height - 1);
+        int south = (north + 1) < m_header.height ? (north + 1) : north;
+        int west = qFloor(colReal) % m_header.width;
+        int east = (west + 1) % m_header.width;
+
+        double row_dist = rowReal - north;
+        double col_dist = colReal - qFloor(colReal);
+        double interpolated = 0;
+        for (int irow : {north, south})
+        {
+            for (int icol : {west, east})
+            {
+                interpolated += sample(irow, icol) * (1 - row_dist) * (1 - col_dist);
+                col_dist = 1 - col_dist;
+            }
+            row_dist = 1 - row_dist;
+        }
+        return interpolated;
+    }
+
+    // Guards the one-time initialization of current
+    static std::once_flag initialized;
+
+    // Serializes reloadModel()
+    static std::mutex reloadMutex;
+
+    // Current model, or nullptr if none is installed
+    static std::atomic<Model*> current;
+
+    // All models that have ever been loaded. Models are never deleted,
+    // because other threads might still read from a model after it has been
+    // replaced. Models are replaced only when the user installs a new file.
+    static std::vector<std::unique_ptr<Model>> all;
+
+private:
+    Q_DISABLE_COPY_MOVE(Model)
+
+    // Sample in meters, or NaN if the band cannot be mapped
+    [[nodiscard]] double sample(int row, int col)
+    {
+        auto index = row / m_samplesPerDegree;
+        const auto* data = band(index);
+        if (data == nullptr)
+        {
+            return qQNaN();
+        }
+        auto offset = 2*(static_cast<qint64>(row - index*m_samplesPerDegree)*m_header.width + col);
+        return m_header.offset + m_header.scale*qFromBigEndian<quint16>(data + offset);
+    }
+
+    // Maps the band on first use. Returns nullptr if the band cannot be mapped.
+    [[nodiscard]] const uchar* band(int index)
+    {
+        const auto* data = m_bands[index].load(std::memory_order_acquire);
+        if (data != nullptr)
+        {
+            return data;
+        }
+
+        std::lock_guard const lock(m_mapMutex);
+        data = m_bands[index].load(std::memory_order_relaxed);
+        if (data == nullptr)
+        {
+            auto firstRow = index*m_samplesPerDegree;
+            auto numRows = qMin(m_samplesPerDegree, m_header.height - firstRow);
+            data = m_file.map(m_header.dataOffset + 2*static_cast<qint64>(firstRow)*m_header.width,
+                              2*static_cast<qint64>(numRows)*m_header.width);
+            if (data == nullptr)
+            {
+                qWarning() << "Geoid: Unable to map" << m_file.fileName();
+                return nullptr;
+            }
+            m_bands[index].store(data, std::memory_order_release);
+        }
+        return data;
+    }
+
+    QFile m_file;
+    PGMHeader m_header;
+
+    // One band covers one degree of latitude
+    int m_samplesPerDegree {0};
+    int m_numBands {0};
+    std::unique_ptr<std::atomic<const uchar*>[]> m_bands;
+
+    // Serializes calls to QFile::map
+    std::mutex m_mapMutex;
+};
+
+std::once_flag Positioning::Geoid::Model::initialized;
+std::mutex Positioning::Geoid::Model::reloadMutex;
+std::atomic<Positioning::Geoid::Model*> Positioning::Geoid::Model::current {nullptr};
+std::vector<std::unique_ptr<Positioning::Geoid::Model>> Positioning::Geoid::Model::all;
+
 
 // reading binary geoid data was carefully optimized for speed. We read the
 // binary content at once and do the byte order conversion afterwards.  This
@@ -67,32 +270,66 @@ void Positioning::Geoid::readEGM()
 
 }
 
+
+auto Positioning::Geoid::isValidModel(const QString& fileName) -> bool
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    PGMHeader header;
+    return readPGMHeader(file, header);
+}
+
+
+auto Positioning::Geoid::modelFileName() -> QString
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+u"/geoid/geoid.pgm"_qs;
+}
+
+
+void Positioning::Geoid::reloadModel()
+{
+    std::lock_guard const lock(Model::reloadMutex);
+
+    Model* newModel = nullptr;
+    if (QFileInfo::exists(modelFileName()))
+    {
+        Model::all.push_back(std::make_unique<Model>(modelFileName()));
+        if (Model::all.back()->isValid())
+        {
+            newModel = Model::all.back().get();
+        }
+        else
+        {
+            qWarning() << "Geoid: Unable to read" << modelFileName();
+            Model::all.pop_back();
+        }
+    }
+    Model::current.store(newModel, std::memory_order_release);
+}
+
+
+auto Positioning::Geoid::model() -> Model*
+{
+    std::call_once(Model::initialized, reloadModel);
+    return Model::current.load(std::memory_order_acquire);
+}
+
+
 // 90 >= latitude >= -90
 //
 // we do a simple bilinear interpolation between the four surrounding data
 // points according to Numerical Recipies in C++ 3.6 "Interpolation in Two or
 // More Dimensions".
 //
-auto Positioning::Geoid::separation(const QGeoCoordinate& coord) -> Units::Distance
+auto Positioning::Geoid::separationEGM96(double latitude, double longitude) -> double
 {
-    // Paranoid safety checks
-    if (!coord.isValid()) {
-        return Units::Distance::fromM( qQNaN() );
-    }
-
     // Read EGM vector if this has not been done already
+    std::call_once(egmFlag, readEGM);
     if (egm.empty()) {
-        readEGM();
-        if (egm.empty()) {
-            return Units::Distance::fromM( qQNaN() );
-        }
-    }
-
-    // Get lat/long
-    auto latitude = coord.latitude();
-    auto longitude = coord.longitude();
-    while (longitude < 0) {
-        longitude += 360.;
+        return qQNaN();
     }
 
     // coordinate transformation from lat/lon to the data file coordinate
@@ -104,7 +341,7 @@ auto Positioning::Geoid::separation(const QGeoCoordinate& coord) -> Units::Dista
 
     // integer row north and south of latitude
     //
-    int north = qFloor(row(latitude));
+    int north = qBound(0, qFloor(row(latitude)), egm96_rows - 1);
     int south = (north + 1) < egm96_rows? (north + 1) : north;
 
     // integer column west and east of latitude
@@ -112,10 +349,11 @@ auto Positioning::Geoid::separation(const QGeoCoordinate& coord) -> Units::Dista
     int west = qFloor(col(longitude)) % egm96_cols;
     int east = (west + 1) % egm96_cols;
 
+    // Indices are in range, so no bounds checks are necessary
+    const auto* egmData = egm.constData();
     auto geoid = [&] (int row, int col) -> qreal
     {
-        int idx = row * egm96_cols + col;
-        return idx >=0 && idx < egm96_size ? egm.at(idx) * 0.01 : 0.0;
+        return egmData[row * egm96_cols + col] * 0.01;
     };
 
     // here we do a bilinear interpolation between the 4 neighbouring data
@@ -134,5 +372,62 @@ auto Positioning::Geoid::separation(const QGeoCoordinate& coord) -> Units::Dista
         row_dist = 1 - row_dist;
     }
 
-    return Units::Distance::fromM( interpolated );
+    return interpolated;
+}
+
+
+auto Positioning::Geoid::separation(double latitude, double longitude, Model* highResolutionModel) -> double
+{
+    if (highResolutionModel != nullptr)
+    {
+        auto result = highResolutionModel->separation(latitude, longitude);
+        if (qIsFinite(result))
+        {
+            return result;
+        }
+    }
+    return separationEGM96(latitude, longitude);
+}
+
+
+auto Positioning::Geoid::separation(const QGeoCoordinate& coord) -> Units::Distance
+{
+    // Paranoid safety checks
+    if (!coord.isValid()) {
+        return Units::Distance::fromM( qQNaN() );
+    }
+
+    // Get lat/long
+    auto latitude = coord.latitude();
+    auto longitude = coord.longitude();
+    while (longitude < 0) {
+        longitude += 360.;
+    }
+
+    return Units::Distance::fromM( separation(latitude, longitude, model()) );
+}
+
+
+auto Positioning::Geoid::separation(std::span<const QGeoCoordinate> coords) -> QList<Units::Distance>
+{
+    auto* highResolutionModel = model();
+
+    QList<Units::Distance> result;
+    result.reserve(static_cast<qsizetype>(coords.size()));
+    for (const auto& coord : coords)
+    {
+        if (!coord.isValid())
+        {
+            result.append(Units::Distance::fromM( qQNaN() ));
+            continue;
+        }
+
+        auto latitude = coord.latitude();
+        auto longitude = coord.longitude();
+        while (longitude < 0) {
+            longitude += 360.;
+        }
+        result.append(Units::Distance::fromM( separation(latitude, longitude, highResolutionModel) ));
+    }
+    return result;
 }
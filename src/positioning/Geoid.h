@@ -19,6 +19,8 @@
 #pragma once
 
 #include <QGeoCoordinate>
+#include <QList>
+#include <span>
 
 #include "units/Distance.h"
 
@@ -44,6 +46,19 @@ namespace Positioning {
  * implementations yield the same numbers (within numerical precision).  The
  * comparison of the bilinear implementation here with the python's bicubic
  * interpolation showed a worldwide max deviation of about 1 m.
+ *
+ * If the user has installed a high-resolution model, geoidal separations are
+ * taken from that model instead. The class reads the EGM2008 geoid files
+ * that GeographicLib publishes at
+ * https://sourceforge.net/projects/geographiclib/files/geoids-distrib/
+ * (egm2008-1.pgm, egm2008-2_5.pgm or egm2008-5.pgm, with a grid spacing of
+ * 1', 2.5' or 5'). These files are 16 bit PGM images, with a header that
+ * specifies offset and scale of the stored values. The largest file has
+ * almost 500 MB. The file is therefore never read as a whole. Instead, bands
+ * of about one degree latitude are memory-mapped when they are first needed,
+ * so that only the data around the positions actually in use is ever read.
+ * EGM96 remains the fallback if no model is installed, or if a band cannot
+ * be mapped.
  */
 
 class Geoid
@@ -60,13 +75,68 @@ public:
      * @param coord location for which the geoidal separation should be calculated.
      *
      * @returns Geoidal separation. In case that the method fails, NAN is returned
+     *
+     * The method is thread-safe. It does not lock or allocate memory, except
+     * on the first call, which reads the model data.
      */
     static auto separation(const QGeoCoordinate& coord) -> Units::Distance;
 
+    /*! \brief Geoidal separation for a list of locations
+     *
+     * This method is meant for computations that need many separations at
+     * once, such as the export of flight recordings. It is equivalent to
+     * calling separation() for every location, but looks up the model only
+     * once. The method is thread-safe.
+     *
+     * @param coords Locations for which the geoidal separation should be
+     * calculated
+     *
+     * @returns List of geoidal separations, one per location. NAN for
+     * invalid locations, or if the method fails.
+     */
+    static auto separation(std::span<const QGeoCoordinate> coords) -> QList<Units::Distance>;
+
+    /*! \brief Check if a file contains a geoid model that this class can read
+     *
+     * @param fileName Name of a file, typically egm2008-1.pgm, egm2008-2_5.pgm
+     * or egm2008-5.pgm
+     *
+     * @returns True if the file is a GeographicLib geoid file in PGM format
+     */
+    static auto isValidModel(const QString& fileName) -> bool;
+
+    /*! \brief File name of the installed high-resolution model
+     *
+     * @returns Path where the high-resolution model is installed. The file
+     * need not exist.
+     */
+    static auto modelFileName() -> QString;
+
+    /*! \brief Reload the high-resolution model
+     *
+     * This method must be called after a new model has been installed at
+     * modelFileName(), or after the model has been removed. It is
+     * thread-safe.
+     */
+    static void reloadModel();
+
 private:
     // Reads data into the vector egm
     static void readEGM();
 
+    // High-resolution model, defined in Geoid.cpp
+    class Model;
+
+    // Current high-resolution model, or nullptr if none is installed
+    static auto model() -> Model*;
+
+    // Geoidal separation in meters, or NaN. Latitude in [-90, 90], longitude
+    // in [0, 360[. If highResolutionModel is nullptr, EGM96 is used.
+    static auto separation(double latitude, double longitude, Model* highResolutionModel) -> double;
+
+    // Geoidal separation in meters according to EGM96, or NaN
+    static auto separationEGM96(double latitude, double longitude) -> double;
+
     static QVector<qint16> egm; // holds the data read from the binaray data file WW15MGH.DAC
 
     // https://earth-info.nga.mil/GandG/wgs84/gravitymod/egm96/binary/readme.txt
@@ -19,7 +19,10 @@
  ***************************************************************************/
 
 #include <QCoreApplication>
+#include <QGuiApplication>
 #include <QSettings>
+#include <QtMath>
+#include <cmath>
 
 #include "GlobalObject.h"
 #include "GlobalSettings.h"
@@ -60,6 +63,23 @@ Positioning::PositionProvider::PositionProvider(QObject *parent) : PositionInfoS
     connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Positioning::PositionProvider::savePositionAndTrack);
     saveTimer->start();
 
+    // Display prediction
+    m_predictionTimer.setInterval(predictionInterval);
+    m_predictionTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_predictionTimer, &QTimer::timeout, this, &Positioning::PositionProvider::updatePrediction);
+
+    // Nobody looks at the prediction while the app is in the background. Stop
+    // the timer then; the next fix after the app has been reactivated starts it
+    // again.
+    connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, [this](Qt::ApplicationState state) {
+        if ((state != Qt::ApplicationActive) && m_predictionTimer.isActive())
+        {
+            m_predictionTimer.stop();
+            m_predictedPositionInfo = positionInfo();
+            emit predictedPositionInfoChanged();
+        }
+    });
+
     // Update properties
     updateStatusString();
 }
@@ -154,6 +174,7 @@ void Positioning::PositionProvider::onPositionUpdated()
 
     // Set new info
     setPositionInfo(newInfo);
+    updatePredictionModel(oldInfo, newInfo);
     setLastValidCoordinate(newInfo.coordinate());
     setLastValidTT(newInfo.trueTrack());
     setSourceName(source);
@@ -244,6 +265,129 @@ auto Positioning::PositionProvider::lastValidTT() -> Units::Angle
 }
 
 
+void Positioning::PositionProvider::updatePredictionModel(const Positioning::PositionInfo& oldInfo, const Positioning::PositionInfo& newInfo)
+{
+    // Remember where the previous prediction had put the aircraft
+    QGeoCoordinate oldPrediction;
+    if (m_predictionTimer.isActive())
+    {
+        oldPrediction = m_predictedPositionInfo.coordinate();
+    }
+
+    // Estimate the turn rate from the change in true track, and smooth it
+    // with the previous estimate
+    auto dtInS = static_cast<double>(oldInfo.timestamp().msecsTo(newInfo.timestamp()))/1000.0;
+    auto oldTT = oldInfo.trueTrack();
+    auto newTT = newInfo.trueTrack();
+    if (oldTT.isFinite() && newTT.isFinite() && (dtInS > 0.0) && (dtInS <= maxPredictionTime.count()))
+    {
+        auto deltaInDEG = std::remainder(newTT.toDEG()-oldTT.toDEG(), 360.0);
+        auto turnRate = qBound(-maxTurnRateInDEGPerS, deltaInDEG/dtInS, maxTurnRateInDEGPerS);
+        m_turnRateInDEGPerS = 0.5*turnRate + 0.5*m_turnRateInDEGPerS;
+    }
+    else
+    {
+        m_turnRateInDEGPerS = 0.0;
+    }
+
+    // Latency of the fix. Implausible values hint to a receiver clock that is
+    // off, and are disregarded.
+    auto latencyInMS = newInfo.timestamp().msecsTo(QDateTime::currentDateTimeUtc());
+    if ((latencyInMS < 0) || (latencyInMS > std::chrono::milliseconds(maxLatency).count()))
+    {
+        latencyInMS = 0;
+    }
+    m_latencyInS = static_cast<double>(latencyInMS)/1000.0;
+    m_sinceLastFix.start();
+
+    // Check if a prediction is possible at all
+    auto GS = newInfo.groundSpeed();
+    if (!newInfo.isValid() || !newTT.isFinite() || !GS.isFinite() || (GS.toMPS() < minPredictionSpeedInMPS)
+        || (QGuiApplication::applicationState() != Qt::ApplicationActive))
+    {
+        m_predictionTimer.stop();
+        m_offsetLatInDEG = 0.0;
+        m_offsetLonInDEG = 0.0;
+        m_predictedPositionInfo = newInfo;
+        emit predictedPositionInfoChanged();
+        return;
+    }
+
+    // The error of the old prediction is blended out over time, so that the
+    // predicted position does not jump
+    m_offsetLatInDEG = 0.0;
+    m_offsetLonInDEG = 0.0;
+    if (oldPrediction.isValid())
+    {
+        auto newPrediction = extrapolate(m_latencyInS).coordinate();
+        if (newPrediction.distanceTo(oldPrediction) < GS.toMPS()*maxPredictionTime.count())
+        {
+            m_offsetLatInDEG = oldPrediction.latitude()-newPrediction.latitude();
+            m_offsetLonInDEG = std::remainder(oldPrediction.longitude()-newPrediction.longitude(), 360.0);
+        }
+    }
+
+    m_predictionTimer.start();
+    updatePrediction();
+}
+
+
+void Positioning::PositionProvider::updatePrediction()
+{
+    auto sinceLastFixInS = static_cast<double>(m_sinceLastFix.elapsed())/1000.0;
+    if (!m_sinceLastFix.isValid() || (sinceLastFixInS > maxPredictionTime.count()))
+    {
+        m_predictionTimer.stop();
+        m_predictedPositionInfo = positionInfo();
+        emit predictedPositionInfoChanged();
+        return;
+    }
+
+    auto info = extrapolate(sinceLastFixInS+m_latencyInS);
+    auto coordinate = info.coordinate();
+    auto decay = qExp(-sinceLastFixInS/offsetDecayInS);
+    coordinate.setLatitude(qBound(-90.0, coordinate.latitude()+decay*m_offsetLatInDEG, 90.0));
+    coordinate.setLongitude(std::remainder(coordinate.longitude()+decay*m_offsetLonInDEG, 360.0));
+
+    QGeoPositionInfo tmp = info;
+    tmp.setCoordinate(coordinate);
+    m_predictedPositionInfo = PositionInfo(tmp);
+    emit predictedPositionInfoChanged();
+}
+
+
+auto Positioning::PositionProvider::extrapolate(double dtInS) const -> Positioning::PositionInfo
+{
+    auto fix = positionInfo();
+    auto GSInMPS = fix.groundSpeed().toMPS();
+    auto TTInDEG = fix.trueTrack().toDEG();
+
+    // Constant turn rate model: the aircraft moves along a circular arc. The
+    // chord of the arc points in direction of the mean track.
+    auto turnInDEG = m_turnRateInDEGPerS*dtInS;
+    auto halfTurnInRAD = qDegreesToRadians(turnInDEG)/2.0;
+    auto chordInM = GSInMPS*dtInS;
+    if (qAbs(halfTurnInRAD) > 1e-6)
+    {
+        chordInM *= qSin(halfTurnInRAD)/halfTurnInRAD;
+    }
+
+    auto climbInM = 0.0;
+    auto VS = fix.verticalSpeed();
+    if (VS.isFinite())
+    {
+        climbInM = VS.toMPS()*dtInS;
+    }
+
+    QGeoPositionInfo tmp = fix;
+    tmp.setCoordinate(fix.coordinate().atDistanceAndAzimuth(chordInM, TTInDEG+turnInDEG/2.0, climbInM));
+    tmp.setTimestamp(fix.timestamp().addMSecs(qRound64(1000.0*dtInS)));
+    auto newTTInDEG = std::fmod(TTInDEG+turnInDEG+360.0, 360.0);
+    tmp.setAttribute(QGeoPositionInfo::Direction, newTTInDEG);
+    return PositionInfo(tmp);
+}
+
+
 void Positioning::PositionProvider::updateStatusString()
 {
     if (receivingPositionInfo()) {
@@ -20,7 +20,9 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QQmlEngine>
+#include <QTimer>
 
 #include "GlobalObject.h"
 #include "positioning/PositionInfoSource_Abstract.h"
@@ -102,6 +104,43 @@ public:
      */
     static auto lastValidTT() -> Units::Angle;
 
+    /*! \brief Predicted position info, for display purposes
+     *
+     *  Position fixes arrive at 1–5 Hz and are several hundred milliseconds
+     *  old when they arrive. This property holds a position info that is
+     *  extrapolated from the last fix to the current time, using ground
+     *  speed, true track, turn rate and vertical speed. When a new fix
+     *  arrives, the difference between old prediction and new fix is blended
+     *  out smoothly. While the aircraft is moving, the property is updated at
+     *  display frame rate, so that the own-ship symbol can move without
+     *  jumps. If no prediction is possible, for instance because the
+     *  aircraft does not move or because the last fix is too old, or if the
+     *  app is not active, the property equals positionInfo.
+     *
+     *  The prediction must not be used for navigation.
+     */
+    Q_PROPERTY(Positioning::PositionInfo predictedPositionInfo READ predictedPositionInfo NOTIFY predictedPositionInfoChanged)
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property predictedPositionInfo
+     */
+    [[nodiscard]] auto predictedPositionInfo() const -> Positioning::PositionInfo { return m_predictedPositionInfo; }
+
+    /*! \brief Indicates if predictedPositionInfo is currently extrapolated
+     *
+     *  If true, the property predictedPositionInfo is updated at display
+     *  frame rate, and map items that follow it should not be animated. If
+     *  false, predictedPositionInfo equals positionInfo.
+     */
+    Q_PROPERTY(bool predicting READ predicting NOTIFY predictedPositionInfoChanged)
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property predicting
+     */
+    [[nodiscard]] auto predicting() const -> bool { return m_predictionTimer.isActive(); }
+
     /*! \brief startUpdates
      *
      *  Requests permissions if necessary and starts to provide data
@@ -117,6 +156,9 @@ signals:
     /*! \brief Notifier signal */
     void lastValidCoordinateChanged(QGeoCoordinate);
 
+    /*! \brief Notifier signal */
+    void predictedPositionInfoChanged();
+
 private slots:   
     // Intializations that are moved out of the constructor, in order to avoid
     // nested uses of constructors in Global.
@@ -140,9 +182,34 @@ private slots:
     // Setter method for property with the same name
     void updateStatusString();
 
+    // Extrapolates the last fix to the current time and sets the property
+    // predictedPositionInfo. Connected to m_predictionTimer.
+    void updatePrediction();
+
 private:
     Q_DISABLE_COPY_MOVE(PositionProvider)
 
+    // Updates the parameters of the prediction model. Called whenever a new
+    // fix arrives.
+    void updatePredictionModel(const Positioning::PositionInfo& oldInfo, const Positioning::PositionInfo& newInfo);
+
+    // Position of the aircraft, extrapolated from the last fix. The parameter
+    // is the time since the fix was taken, in seconds.
+    [[nodiscard]] auto extrapolate(double dtInS) const -> Positioning::PositionInfo;
+
+    // Display frame interval
+    static constexpr auto predictionInterval = 16ms;
+    // Positions are not extrapolated further than this into the future
+    static constexpr auto maxPredictionTime = 3s;
+    // Fixes older than this at arrival are assumed to carry wrong timestamps
+    static constexpr auto maxLatency = 1s;
+    // Time constant for blending out the error of the previous prediction
+    static constexpr double offsetDecayInS = 0.5;
+    // Predictions are made only if the aircraft is faster than this
+    static constexpr double minPredictionSpeedInMPS = 2.0;
+    // Larger turn rates are considered implausible
+    static constexpr double maxTurnRateInDEGPerS = 10.0;
+
     // Aircraft is considered flying if speed is at least this high
     static constexpr double minFlightSpeedInKT = 30.0;
     // Hysteresis for flight speed
@@ -157,6 +224,15 @@ private:
 
     QGeoCoordinate m_lastValidCoordinate {EDTF_lat, EDTF_lon, EDTF_ele};
     Units::Angle m_lastValidTT {};
+
+    // Prediction model
+    PositionInfo m_predictedPositionInfo;
+    QTimer m_predictionTimer;
+    QElapsedTimer m_sinceLastFix;
+    double m_latencyInS {0.0};
+    double m_turnRateInDEGPerS {0.0};
+    double m_offsetLatInDEG {0.0};
+    double m_offsetLonInDEG {0.0};
 };
 
 } // namespace Positioning
@@ -39,6 +39,22 @@ Map {
     */
     property real pixelPer10km: 0.0
 
+    /*! \brief URL of the TileJSON file describing the tiles of the current VAC
+
+    Once tiles have been generated for a VAC, the map shows the VAC as a tiled
+    raster source, so that only visible tiles are loaded, at the resolution
+    required. Until then, the raster image is shown as an image source. This
+    property is empty if the current VAC has no tiles. It changes as soon as
+    tiles for the current VAC have been generated in the background.
+    */
+    readonly property string vacTilesURL: GeoMapProvider.vacTilesURL
+
+    Binding {
+        target: GeoMapProvider
+        property: "currentVAC"
+        value: Global.currentVAC
+    }
+
     /*
     * Handle changes in zoom level
     */
@@ -70,7 +86,7 @@ Map {
 
             property string url: {
                 var vac = Global.currentVAC
-                if (!vac.isValid)
+                if (!vac.isValid || (flightMap.vacTilesURL !== ""))
                     return "qrc:/icons/appIcon.png"
                 return "file://" + vac.fileName
             }
@@ -80,7 +96,7 @@ Map {
             // whenever the approach chart changes.
             property var coordinates: {
                 var vac = Global.currentVAC
-                if (vac.isValid)
+                if (vac.isValid && (flightMap.vacTilesURL === ""))
                     return [[vac.topLeft.longitude, vac.topLeft.latitude],
                             [vac.topRight.longitude, vac.topRight.latitude],
                             [vac.bottomRight.longitude, vac.bottomRight.latitude],
@@ -103,7 +119,29 @@ Map {
             property string source: "vac"
 
             layout: {
-                "visibility": Global.currentVAC.isValid ? 'visible' : 'none'
+                "visibility": (Global.currentVAC.isValid && (flightMap.vacTilesURL === "")) ? 'visible' : 'none'
+            }
+        }
+
+        SourceParameter {
+            id: approachChartTiles
+
+            styleId: "vacTiles"
+            type: "raster"
+
+            property string url: flightMap.vacTilesURL
+            property int tileSize: 256
+        }
+
+        LayerParameter {
+            id: approachChartTilesLayer
+
+            styleId: "vacTilesLayer"
+            type: "raster"
+            property string source: "vacTiles"
+
+            layout: {
+                "visibility": (flightMap.vacTilesURL !== "") ? 'visible' : 'none'
             }
         }
 
@@ -95,6 +95,10 @@ Item {
                 importOpenAirDialog.open()
                 return
             }
+            if (fileFunction === FileExchange.Geoid) {
+                importGeoidDialog.open()
+                return
+            }
             if (fileFunction === FileExchange.ZipFile) {
                 errLbl.text = qsTr("The file <strong>%1</strong> seems to contain an zip file without the data required in a tripkit.").arg(fileName)
                 errorDialog.open()
@@ -141,13 +145,48 @@ Item {
         target: VACLibrary
 
         function onImportTripKitStatus(percent) {
-            if (percent < 1.0) {
-                pbar.value = percent
+            pbar.value = percent
+            if (percent === 0.0)
                 importTripKitWaitDialog.open()
-            } else
+            if (percent >= 1.0)
                 importTripKitWaitDialog.close()
             return
         }
+
+        function onImportTripKitFinished(errorString) {
+            if (errorString !== "") {
+                errLbl.text = errorString
+                errorDialog.open()
+                return
+            }
+            importManager.toast.doToast( qsTr("Trip kit imported") )
+        }
+    }
+
+
+    Connections {
+        target: DataManager
+
+        function onImportStatus(percent) {
+            mapPbar.value = percent
+            if (percent === 0.0)
+                importMapWaitDialog.open()
+            if (percent >= 1.0)
+                importMapWaitDialog.close()
+            return
+        }
+
+        function onImportFinished(errorString) {
+            if (errorString !== "") {
+                errLbl.text = errorString
+                errorDialog.open()
+                return
+            }
+            if (importManager.fileFunction === FileExchange.Geoid)
+                importManager.toast.doToast( qsTr("Geoid model installed") )
+            else
+                importManager.toast.doToast( qsTr("Map imported") )
+        }
     }
 
 
@@ -422,13 +461,7 @@ Item {
         onAccepted: {
             PlatformAdaptor.vibrateBrief()
 
-            var errorString = DataManager.import(importManager.filePath, mapNameRaster.text)
-            if (errorString !== "") {
-                errLbl.text = errorString
-                errorDialog.open()
-                return
-            }
-            importManager.toast.doToast( qsTr("Raster map imported") )
+            DataManager.import(importManager.filePath, mapNameRaster.text)
         }
     }
 
@@ -483,13 +516,7 @@ Item {
         onAccepted: {
             PlatformAdaptor.vibrateBrief()
 
-            var errorString = DataManager.import(importManager.filePath, mapNameVector.text)
-            if (errorString !== "") {
-                errLbl.text = errorString
-                errorDialog.open()
-                return
-            }
-            importManager.toast.doToast( qsTr("Vector map imported") )
+            DataManager.import(importManager.filePath, mapNameVector.text)
         }
 
     }
@@ -575,13 +602,24 @@ Item {
             PlatformAdaptor.vibrateBrief()
             close()
 
-            var errorString = VACLibrary.importTripKit(importManager.filePath)
-            if (errorString !== "") {
-                errLbl.text = errorString
-                errorDialog.open()
-                return
-            }
-            importManager.toast.doToast( qsTr("Trip kit imported") )
+            VACLibrary.importTripKit(importManager.filePath)
+        }
+    }
+
+    LongTextDialog {
+        id: importGeoidDialog
+
+        title: qsTr("Install Geoid Model?")
+        standardButtons: Dialog.No | Dialog.Yes
+        modal: true
+
+        text: qsTr("The file contains a high-resolution model of the geoid, which is used to convert between the ellipsoidal altitudes reported by satellite navigation and altitudes above mean sea level. This will replace any geoid model that was installed before.")
+
+        onAccepted: {
+            PlatformAdaptor.vibrateBrief()
+            close()
+
+            DataManager.importGeoid(importManager.filePath)
         }
     }
 
@@ -609,6 +647,9 @@ Item {
 
         modal: true
         closePolicy: Popup.NoAutoClose
+        standardButtons: Dialog.Cancel
+
+        onRejected: VACLibrary.cancelTripKitImport()
 
         ColumnLayout {
             anchors.fill: parent
@@ -617,7 +658,7 @@ Item {
                 id: txtLbl
                 Layout.fillWidth: true
 
-                text: qsTr("Extracting and converting files from the trip kit. Please do not interrupt or close the app.")
+                text: qsTr("Extracting and converting files from the trip kit.")
                 wrapMode: Text.Wrap
                 textFormat: Text.StyledText
             }
@@ -634,4 +675,39 @@ Item {
 
         }
     }
+
+    CenteringDialog {
+        id: importMapWaitDialog
+        title: qsTr("Stand by")
+
+        modal: true
+        closePolicy: Popup.NoAutoClose
+        standardButtons: Dialog.Cancel
+
+        onRejected: DataManager.cancelImport()
+
+        ColumnLayout {
+            anchors.fill: parent
+
+            Label {
+                id: mapTxtLbl
+                Layout.fillWidth: true
+
+                text: qsTr("Copying file into the library.")
+                wrapMode: Text.Wrap
+                textFormat: Text.StyledText
+            }
+
+            Item {
+                height: mapTxtLbl.font.pixelSize
+            }
+
+            ProgressBar {
+                id: mapPbar
+                Layout.fillWidth: true
+                value: 0.0
+            }
+
+        }
+    }
 }
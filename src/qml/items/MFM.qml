@@ -57,8 +57,24 @@ Item {
         copyrightsVisible: false // We have our own copyrights notice
 
         property bool followGPS: true
-        property real animatedTrack: PositionProvider.lastValidTT.isFinite() ? PositionProvider.lastValidTT.toDEG() : 0
-        Behavior on animatedTrack { RotationAnimation {duration: 400; direction: RotationAnimation.Shortest } }
+
+        // Position and track of the own aircraft, for display. While a
+        // prediction is available, these properties follow the prediction,
+        // which is updated at display frame rate. Map items that follow them
+        // must not be animated then.
+        readonly property bool predicting: PositionProvider.predicting
+        readonly property var ownCoordinate: predicting ? PositionProvider.predictedPositionInfo.coordinate() : PositionProvider.lastValidCoordinate
+        readonly property var ownTT: {
+            if (predicting) {
+                const tt = PositionProvider.predictedPositionInfo.trueTrack()
+                if (tt.isFinite())
+                    return tt
+            }
+            return PositionProvider.lastValidTT
+        }
+
+        property real animatedTrack: ownTT.isFinite() ? ownTT.toDEG() : 0
+        Behavior on animatedTrack { RotationAnimation {duration: flightMap.predicting ? 0 : 400; direction: RotationAnimation.Shortest } }
 
 
         // GESTURES
@@ -194,13 +210,14 @@ Item {
         // If "followGPS" is true, then update the map bearing whenever a new GPS position comes in
         Binding on bearing {
             when: GlobalSettings.mapBearingPolicy !== GlobalSettings.UserDefinedBearingUp
-            value: GlobalSettings.mapBearingPolicy === GlobalSettings.TTUp ? PositionProvider.lastValidTT.toDEG() : 0
+            value: GlobalSettings.mapBearingPolicy === GlobalSettings.TTUp ? flightMap.ownTT.toDEG() : 0
         }
 
-        // We expect GPS updates every second. So, we choose an animation of duration 1000ms here, to obtain a flowing movement
+        // We expect GPS updates every second. So, we choose an animation of duration 1000ms here, to obtain a flowing movement.
+        // Predictions are updated at display frame rate and need no animation.
         Behavior on bearing {
             id: bearingBehavior
-            RotationAnimation {duration: 1000; direction: RotationAnimation.Shortest }
+            RotationAnimation {duration: flightMap.predicting ? 0 : 1000; direction: RotationAnimation.Shortest }
         }
 
 
@@ -221,9 +238,9 @@ Item {
             value: {
                 // If not in flight, then aircraft stays in center of display
                 if (Navigator.flightStatus !== Navigator.Flight)
-                    return PositionProvider.lastValidCoordinate
-                if (!PositionProvider.lastValidTT.isFinite())
-                    return PositionProvider.lastValidCoordinate
+                    return flightMap.ownCoordinate
+                if (!flightMap.ownTT.isFinite())
+                    return flightMap.ownCoordinate
 
                 // Otherwise, we position the aircraft someplace on a circle around the
                 // center, so that the map shows a larger portion of the airspace ahead
@@ -240,14 +257,15 @@ Item {
                                         )
                 const radiusInM = 10000.0*radiusInPixel/flightMap.pixelPer10km
 
-                return PositionProvider.lastValidCoordinate.atDistanceAndAzimuth(radiusInM, PositionProvider.lastValidTT.toDEG())
+                return flightMap.ownCoordinate.atDistanceAndAzimuth(radiusInM, flightMap.ownTT.toDEG())
             }
         }
 
-        // We expect GPS updates every second. So, we choose an animation of duration 1000ms here, to obtain a flowing movement
+        // We expect GPS updates every second. So, we choose an animation of duration 1000ms here, to obtain a flowing movement.
+        // Predictions are updated at display frame rate and need no animation.
         Behavior on center {
             id: centerBindingAnimation
-            CoordinateAnimation { duration: 1000 }
+            CoordinateAnimation { duration: flightMap.predicting ? 0 : 1000 }
             enabled: true
 
             function omitAnimationforZoom() {
@@ -280,7 +298,7 @@ Item {
 
         // ADDITINAL MAP ITEMS
         MapCircle { // Circle for nondirectional traffic warning
-            center: PositionProvider.lastValidCoordinate
+            center: flightMap.ownCoordinate
 
             radius: Math.max(500, TrafficDataProvider.trafficObjectWithoutPosition.hDist.toM())
             Behavior on radius {
@@ -302,10 +320,10 @@ Item {
 
             property real distFromCenter: 0.5*Math.sqrt(lbl.width*lbl.width + lbl.height*lbl.height) + 28
 
-            coordinate: PositionProvider.lastValidCoordinate
+            coordinate: flightMap.ownCoordinate
             Behavior on coordinate {
                 CoordinateAnimation { duration: 1000 }
-                enabled: TrafficDataProvider.trafficObjectWithoutPosition.animate
+                enabled: TrafficDataProvider.trafficObjectWithoutPosition.animate && !flightMap.predicting
             }
 
             visible: TrafficDataProvider.trafficObjectWithoutPosition.valid
@@ -373,19 +391,22 @@ Item {
 
         MapPolyline {
             id: toNextWP
-            visible: PositionProvider.lastValidCoordinate.isValid &&
+            visible: flightMap.ownCoordinate.isValid &&
                      (Navigator.remainingRouteInfo.status === RemainingRouteInfo.OnRoute)
             line.width: 2
             line.color: 'darkred'
-            path: visible ? [PositionProvider.lastValidCoordinate, Navigator.remainingRouteInfo.nextWP.coordinate] : []
+            path: visible ? [flightMap.ownCoordinate, Navigator.remainingRouteInfo.nextWP.coordinate] : []
         }
 
         MapQuickItem {
             id: ownPosition
 
-            coordinate: PositionProvider.lastValidCoordinate
+            // The predicted position is updated at display frame rate and
+            // needs no animation
+            coordinate: flightMap.ownCoordinate
 
             Behavior on coordinate {
+                enabled: !flightMap.predicting
                 CoordinateAnimation { duration: 1000 }
             }
 
@@ -58,7 +58,13 @@ Item {
         columns: 6
 
         WordWrappingItemDelegate {
-            text: element.model.modelData.objectName + `<br><font color="#606060" size="2">${element.model.modelData.infoText}</font>`
+            text: {
+                var secondLine = element.model.modelData.infoText
+                // Only map sets report their throughput
+                if (element.model.modelData.downloading && (element.model.modelData.throughput > 0))
+                    secondLine = qsTr("downloading at %1").arg(element.model.modelData.throughputString) + "<br>" + secondLine
+                return element.model.modelData.objectName + `<br><font color="#606060" size="2">${secondLine}</font>`
+            }
             icon.source: {
                 if (element.model.modelData.updatable)
                     return "/icons/material/ic_new_releases.svg";
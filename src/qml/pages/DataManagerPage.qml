@@ -532,8 +532,8 @@ Page {
     footer: Footer {
         width: parent.width
 
-        visible: (!DataManager.mapList.downloading && !DataManager.mapList.hasFile) || ((!DataManager.items.downloading) && !DataManager.mapsAndData.updateSize.isNull())
-        contentHeight: Math.max(downloadMapListActionButton.height, downloadUpdatesActionButton.height)
+        visible: (!DataManager.mapList.downloading && !DataManager.mapList.hasFile) || ((!DataManager.items.downloading) && !DataManager.mapsAndData.updateSize.isNull()) || throughputLabel.visible
+        contentHeight: Math.max(downloadMapListActionButton.height, downloadUpdatesActionButton.height, throughputLabel.height)
         bottomPadding: SafeInsets.bottom
 
         ToolButton {
@@ -563,6 +563,17 @@ Page {
                 DataManager.mapsAndData.update()
             }
         }
+
+        Label {
+            id: throughputLabel
+            anchors.centerIn: parent
+
+            // Downloads started from the "Update" button or from the header menu
+            property var downloadGroup: DataManager.mapsAndData.throughput > 0 ? DataManager.mapsAndData : DataManager.items
+
+            visible: DataManager.items.downloading && (downloadGroup.throughput > 0)
+            text: qsTr("Downloading at %1").arg(downloadGroup.throughputString)
+        }
     }
 
     // Show error when list of maps cannot be downloaded
@@ -149,7 +149,7 @@ Page {
         ColumnLayout {
             id: grid
 
-            property leg leg: ({});
+            property int index: -1
 
             Layout.fillWidth: true
 
@@ -161,10 +161,10 @@ Page {
                     // Mention units
                     Navigator.aircraft.horizontalDistanceUnit
                     Navigator.aircraft.fuelConsumptionUnit
+                    // Mention summary, which changes with route, aircraft and wind
+                    Navigator.flightRoute.summary
 
-                    if (leg == null)
-                        return ""
-                    return leg.description(Navigator.wind, Navigator.aircraft)
+                    return Navigator.flightRoute.legDescription(grid.index)
                 }
             }
 
@@ -415,6 +415,27 @@ Page {
                     }
                 }
 
+                MenuItem {
+                    text: qsTr("Avoid Control Zones and Restricted Areas")
+                    enabled: (Navigator.flightRoute.size > 1) && (sv.currentIndex === 0)
+
+                    onTriggered: {
+                        PlatformAdaptor.vibrateBrief()
+                        highlighted = false
+                        var errorString = Navigator.flightRoute.avoidAirspaces(["CTR", "DNG", "P", "R"], GlobalSettings.airspaceAltitudeLimit)
+                        if (errorString !== "") {
+                            Global.dialogLoader.active = false
+                            Global.dialogLoader.setSource("../dialogs/LongTextDialog.qml", {
+                                                              title: qsTr("Avoid Airspaces"),
+                                                              text: errorString,
+                                                              standardButtons: Dialog.Ok})
+                            Global.dialogLoader.active = true
+                            return
+                        }
+                        toast.doToast(qsTr("Flight route updated"))
+                    }
+                }
+
             }
         }
     }
@@ -497,7 +518,7 @@ Page {
                             var legs = Navigator.flightRoute.legs
                             var j
                             for (j=0; j<legs.length; j++) {
-                                legComponent.createObject(co, {leg: legs[j]});
+                                legComponent.createObject(co, {index: j});
                                 waypointComponent.createObject(co, {waypoint: legs[j].endPoint, index: j+1});
                             }
                         }
@@ -318,6 +318,78 @@ Page {
                 }
             }
 
+            WordWrappingItemDelegate {
+                id: maxConcurrentDownloads
+                text: qsTr("Simultaneous Downloads") +
+                      `<br><font color="#606060" size="2">` +
+                      qsTr("Currently downloading up to %1 files at the same time").arg(GlobalSettings.maxConcurrentDownloads) +
+                      `</font>`
+                icon.source: "/icons/material/ic_file_download.svg"
+                Layout.fillWidth: true
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    maxConcurrentDownloadsDialog.open()
+                }
+            }
+            ToolButton {
+                icon.source: "/icons/material/ic_info_outline.svg"
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    helpDialog.title = qsTr("Simultaneous Downloads")
+                    helpDialog.text = "<p>" + qsTr("When you download or update several maps at once, the app transfers only a few files at the same time. Maps that cover your position or your flight route come first, so that they become usable as early as possible.") + "</p>"
+                            + "<p>" + qsTr("On fast and reliable internet connections, more simultaneous downloads may finish sooner. On slow or unreliable connections, fewer simultaneous downloads are better.") + "</p>"
+                    helpDialog.open()
+                }
+            }
+
+            WordWrappingSwitchDelegate {
+                id: recordFlights
+                text: qsTr("Record Flights")
+                icon.source: "/icons/material/ic_flight.svg"
+                Layout.fillWidth: true
+                Component.onCompleted: {
+                    recordFlights.checked = GlobalSettings.recordFlights
+                }
+                onToggled: {
+                    PlatformAdaptor.vibrateBrief()
+                    GlobalSettings.recordFlights = recordFlights.checked
+                }
+            }
+            ToolButton {
+                icon.source: "/icons/material/ic_info_outline.svg"
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    helpDialog.title = qsTr("Record Flights")
+                    helpDialog.text = "<p>" + qsTr("If this option is enabled, the app records your position, altitude, ground speed and track whenever position information is available. The recordings are stored on your device only. They never leave the device unless you share them.") + "</p>"
+                            + "<p>" + qsTr("The app keeps the recordings of the last 20 program starts. If you disable this option, all recordings are deleted.") + "</p>"
+                    helpDialog.open()
+                }
+            }
+
+            WordWrappingItemDelegate {
+                Layout.fillWidth: true
+                Layout.columnSpan: 2
+                icon.source: "/icons/material/ic_share.svg"
+                text: (Qt.platform.os === "android") || (Qt.platform.os === "ios") ? qsTr("Share Flight Recordings…") : qsTr("Export Flight Recordings…")
+                visible: GlobalSettings.recordFlights && (FlightRecorder.recordings.length > 0)
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    flightRecordingsDialog.open()
+                }
+            }
+
+            WordWrappingItemDelegate {
+                Layout.fillWidth: true
+                Layout.columnSpan: 2
+                icon.source: "/icons/material/ic_delete.svg"
+                text: qsTr("Delete Flight Recordings")
+                visible: GlobalSettings.recordFlights
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    clearFlightRecordingsDialog.open()
+                }
+            }
+
             WordWrappingSwitchDelegate {
                 id: ignoreSSL
                 text: qsTr("Ignore Network Security Errors")
@@ -533,6 +605,106 @@ Page {
 
     }
 
+    CenteringDialog {
+        id: flightRecordingsDialog
+
+        title: (Qt.platform.os === "android") || (Qt.platform.os === "ios") ? qsTr("Share Flight Recording") : qsTr("Export Flight Recording")
+        modal: true
+
+        standardButtons: Dialog.Cancel
+
+        function shareRecording(recording, format) {
+            PlatformAdaptor.vibrateBrief()
+            flightRecordingsDialog.close()
+            var errorString = FlightRecorder.share(recording, format)
+            if (errorString === "abort") {
+                Global.toast.doToast(qsTr("Aborted"))
+                return
+            }
+            if (errorString !== "") {
+                helpDialog.title = qsTr("Error")
+                helpDialog.text = errorString
+                helpDialog.open()
+                return
+            }
+            if (Qt.platform.os === "android")
+                Global.toast.doToast(qsTr("Flight recording shared"))
+            else
+                Global.toast.doToast(qsTr("Flight recording exported"))
+        }
+
+        ColumnLayout {
+            anchors.fill: parent
+
+            Label {
+                Layout.fillWidth: true
+
+                text: qsTr("Recordings are listed by the time when the app was started. Choose the file format for the recording you want to share.")
+                wrapMode: Text.Wrap
+                textFormat: Text.StyledText
+            }
+
+            DecoratedListView {
+                Layout.fillWidth: true
+                Layout.fillHeight: true
+                Layout.preferredHeight: contentHeight
+
+                clip: true
+                model: FlightRecorder.recordings
+                ScrollIndicator.vertical: ScrollIndicator {}
+
+                delegate: RowLayout {
+                    required property string modelData
+
+                    width: ListView.view.width
+
+                    Label {
+                        Layout.fillWidth: true
+                        text: FlightRecorder.description(modelData)
+                        wrapMode: Text.Wrap
+                    }
+                    ToolButton {
+                        text: "IGC"
+                        onClicked: flightRecordingsDialog.shareRecording(modelData, FlightRecorder.IGC)
+                    }
+                    ToolButton {
+                        text: "GPX"
+                        onClicked: flightRecordingsDialog.shareRecording(modelData, FlightRecorder.GPX)
+                    }
+                }
+            }
+        }
+    }
+
+    LongTextDialog {
+        id: clearFlightRecordingsDialog
+
+        title: qsTr("Delete Flight Recordings?")
+        modal: true
+
+        text: qsTr("Once deleted, the recordings can no longer be retrieved.")
+
+        footer: DialogButtonBox {
+            Button {
+                flat: true
+                text: qsTr("Delete")
+                DialogButtonBox.buttonRole: DialogButtonBox.AcceptRole
+            }
+            Button {
+                flat: true
+                text: qsTr("Cancel")
+                DialogButtonBox.buttonRole: DialogButtonBox.RejectRole
+            }
+
+        }
+
+        onAccepted: {
+            FlightRecorder.clear()
+            Global.toast.doToast(qsTr("Flight recordings deleted"))
+        }
+
+    }
+
     CenteringDialog {
         id: fontSizeDialog
 
@@ -570,6 +742,43 @@ Page {
         }
     }
 
+    CenteringDialog {
+        id: maxConcurrentDownloadsDialog
+
+        modal: true
+
+        title: qsTr("Simultaneous Downloads")
+        standardButtons: Dialog.Ok
+
+        GridLayout {
+            width: maxConcurrentDownloadsDialog.availableWidth
+            columns: 2
+
+            Slider {
+                id: maxConcurrentDownloadsSlider
+                Layout.columnSpan: 2
+                Layout.fillWidth: true
+                from: 1
+                to: GlobalSettings.maxConcurrentDownloads_max
+                stepSize: 1
+                snapMode: Slider.SnapAlways
+                value: GlobalSettings.maxConcurrentDownloads
+                onValueChanged: GlobalSettings.maxConcurrentDownloads = maxConcurrentDownloadsSlider.value
+            }
+            Label {
+                Layout.fillWidth: true
+                horizontalAlignment: Text.AlignLeft
+                text: maxConcurrentDownloadsSlider.from
+            }
+            Label {
+                Layout.fillWidth: true
+                horizontalAlignment: Text.AlignRight
+                text: maxConcurrentDownloadsSlider.to
+            }
+
+        }
+    }
+
     CenteringDialog {
         id: heightLimitDialog
 
@@ -33,6 +33,7 @@
 #include "sunset.h"
 
 #include "GlobalObject.h"
+#include "geomaps/CoordinateBatch.h"
 #include "geomaps/GeoMapProvider.h"
 #include "navigation/Clock.h"
 #include "navigation/FlightRoute.h"
@@ -492,6 +493,8 @@ auto Weather::WeatherDataProvider::QNH() const -> Units::Pressure
 
     // Find QNH of nearest airfield
     Weather::Station *closestReportWithQNH = nullptr;
+    QList<Weather::Station*> candidates;
+    GeoMaps::CoordinateBatch batch;
     Units::Pressure QNH;
     foreach(auto weatherStationPtr, _weatherStationsByICAOCode) {
         if (weatherStationPtr.isNull())
@@ -511,16 +514,12 @@ auto Weather::WeatherDataProvider::QNH() const -> Units::Pressure
         {
             continue;
         }
-        if (closestReportWithQNH == nullptr) {
-            closestReportWithQNH = weatherStationPtr;
-            continue;
-        }
-
-        QGeoCoordinate here = Positioning::PositionProvider::lastValidCoordinate();
-        if (here.distanceTo(weatherStationPtr->coordinate()) < here.distanceTo(closestReportWithQNH->coordinate()))
-        {
-            closestReportWithQNH = weatherStationPtr;
-        }
+        candidates.append(weatherStationPtr);
+        batch.append(weatherStationPtr->coordinate());
+    }
+    if (!candidates.isEmpty())
+    {
+        closestReportWithQNH = candidates[qMax(batch.nearest(Positioning::PositionProvider::lastValidCoordinate()), 0)];
     }
     if (closestReportWithQNH != nullptr)
     {
@@ -541,6 +540,8 @@ auto Weather::WeatherDataProvider::QNHInfo() const -> QString
 
     // Find QNH of nearest airfield
     Weather::Station *closestReportWithQNH = nullptr;
+    QList<Weather::Station*> candidates;
+    GeoMaps::CoordinateBatch batch;
     Units::Pressure QNH;
     foreach(auto weatherStationPtr, _weatherStationsByICAOCode) {
         if (weatherStationPtr.isNull())
@@ -560,16 +561,12 @@ auto Weather::WeatherDataProvider::QNHInfo() const -> QString
         {
             continue;
         }
-        if (closestReportWithQNH == nullptr) {
-            closestReportWithQNH = weatherStationPtr;
-            continue;
-        }
-
-        QGeoCoordinate here = Positioning::PositionProvider::lastValidCoordinate();
-        if (here.distanceTo(weatherStationPtr->coordinate()) < here.distanceTo(closestReportWithQNH->coordinate()))
-        {
-            closestReportWithQNH = weatherStationPtr;
-        }
+        candidates.append(weatherStationPtr);
+        batch.append(weatherStationPtr->coordinate());
+    }
+    if (!candidates.isEmpty())
+    {
+        closestReportWithQNH = candidates[qMax(batch.nearest(Positioning::PositionProvider::lastValidCoordinate()), 0)];
     }
     if (closestReportWithQNH != nullptr)
     {
@@ -695,12 +692,8 @@ auto Weather::WeatherDataProvider::weatherStations() const -> QList<Weather::Sta
         }
 
     // Sort list
-    auto compare = [&](const Weather::Station *a, const Weather::Station* b)
-    {
-        QGeoCoordinate here = Positioning::PositionProvider::lastValidCoordinate();
-        return here.distanceTo(a->coordinate()) < here.distanceTo(b->coordinate());
-    };
-    std::sort(sortedReports.begin(), sortedReports.end(), compare);
+    GeoMaps::CoordinateBatch::sortByDistance(sortedReports, Positioning::PositionProvider::lastValidCoordinate(),
+                                             [](const Weather::Station* station) { return station->coordinate(); });
 
     return sortedReports;
 }